@@ -1,96 +1,180 @@
 #include "algo.hpp"
+#include "bucket_sort.hpp"
+#include "instrumentation.hpp"
+#include "station_generator.hpp"
+#include <cmath>
 
-void Algo::loadStations(std::string file_path)
+Algo::Algo(std::pmr::memory_resource* resource) : stations(resource)
 {
+}
+
+bool Algo::loadStations(std::string file_path)
+{
+    ALGO_SPAN("algo.load_stations");
     std::ifstream file(file_path);
     if (!file.is_open()) {
-        std::cerr << "Failed to open file: " << file_path << std::endl;
-        return;
+        return false;
     }
 
     stations.clear();
     std::string line;
 
     while (std::getline(file, line)) {
-        Station s;
-        s.name = line;
-        s.faulty = false;
+        //longer names (ids past 7 digits) outgrow the inline buffer, so build
+        //them with the table's allocator and move them in: a copy would not keep it.
+        Station s{ 0, std::pmr::string(line, stations.get_allocator()), false };
 
         // Parse ID from the line
         size_t underscorePos = line.find('_');
         if (underscorePos != std::string::npos) {
-            s.id = std::stoi(line.substr(underscorePos + 1));
+            s.id = std::stoll(line.substr(underscorePos + 1));
         } else {
             s.id = 1; // fallback
         }
 
-        stations.push_back(s);
+        stations.push_back(std::move(s));
     }
 
     file.close();
+    ALGO_COUNT("algo.stations_loaded", stations.size());
+    return true;
 }
 
 
-int Algo::setRandomFaultyStation()
+int64_t Algo::setRandomFaultyStation()
 {
  if (stations.size() < 2) return -1; // Need at least 2 stations
 
     std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dist(0, stations.size() - 2); // avoid last
+    std::mt19937_64 gen(rd());
+    std::uniform_int_distribution<size_t> dist(0, stations.size() - 2); // avoid last
 
-    int index = dist(gen);
+    size_t index = dist(gen);
 
-    int baseID = stations[index].id;
-    int nextID = stations[index + 1].id;
+    int64_t baseID = stations[index].id;
+    int64_t nextID = stations[index + 1].id;
 
-    int targetID;
+    int64_t targetID;
 
     if (nextID - baseID > 1) {
         // There is a gap; pick a random number in-between
-        std::uniform_int_distribution<> offsetDist(1, nextID - baseID - 1);
-        int offset = offsetDist(gen);
+        std::uniform_int_distribution<int64_t> offsetDist(1, nextID - baseID - 1);
+        int64_t offset = offsetDist(gen);
         targetID = baseID + offset;
     } else {
         // No gap; fallback to picking a station ID (will be found in 1 probe)
         targetID = baseID;
     }
 
-    std::cout << "Generated hard target ID: " << targetID 
-              << " (between " << baseID << " and " << nextID << ")\n";
-
     return targetID;
 }
 
 int Algo::interpolationSearch(int64_t targetID, int& probes)
 {
-    int low = 0;
-    int high = stations.size() - 1;
+    ALGO_SPAN("algo.interpolation_search");
     probes = 0;
+    int landed = 0;
+    int found = interpolateRange(0, stations.size() - 1, targetID, probes, landed);
 
+    ALGO_COUNT("algo.interpolation_search.probes", probes);
+    ALGO_HISTOGRAM("algo.interpolation_search.probes", probes);
+    return found;
+}
+
+int Algo::fingerSearch(int64_t targetID, SearchCursor& cursor, int& probes)
+{
+    ALGO_SPAN("algo.finger_search");
+    probes = 0;
+    int last = stations.size() - 1;
+    if (last < 0) return -1;
+
+    //near means within about kNear stations (and a sixteenth of the table),
+    //judged from the average id density and the id the cursor remembers.
+    //Anything else, and a fresh or stale cursor, gets a plain interpolation
+    //search: it does not read the cursor, so a random stream keeps several
+    //lookups in flight at once.
+    const double kNear = 1 << 12;
+    const int kMaxGallop = 4;
+    int low = 0;
+    int high = last;
+    int found = -1;
+    int finger = cursor.position;
+    //near when the id distance times the average density (last / span)
+    //is at most the limit; multiplied out, a far query costs no division.
+    double span = std::max(1.0, (double)(stations[last].id - stations[0].id));
+    double distance = std::abs((double)targetID - (double)cursor.id);
+    if (finger >= 0 && finger <= last && distance * last <= std::min(kNear, last / 16.0) * span) {
+        double guess = distance * last / span;
+        ++probes;
+        if (stations[finger].id == targetID) {
+            cursor.id = targetID;
+            ALGO_COUNT("algo.finger_search.probes", probes);
+            return finger;
+        }
+
+        //bracket the target: the neighbour first, then steps of the guessed
+        //distance, doubling. Targets further than kMaxGallop steps are
+        //interpolated over the rest of that side.
+        bool forward = stations[finger].id < targetID;
+        int direction = forward ? 1 : -1;
+        int step = guess < 2 ? 1 : (int)guess;
+        if (forward) low = finger + 1; else high = finger - 1;
+        for (int k = 0; k < kMaxGallop && low <= high; ++k) {
+            int probe = std::max(0, std::min(finger + direction * step, last));
+            ++probes;
+            int64_t id = stations[probe].id;
+            if (forward ? id >= targetID : id <= targetID) {
+                if (id == targetID) found = probe;
+                if (forward) high = probe; else low = probe;
+                break;
+            }
+            if (forward) low = probe + 1; else high = probe - 1;
+            step *= 2;
+        }
+    }
+
+    int landed = found;
+    if (found < 0) {
+        found = interpolateRange(low, high, targetID, probes, landed);
+    }
+    //the target itself stands in for the id at position: it is as good for
+    //judging the next distance and does not wait for this lookup's loads.
+    cursor.position = found >= 0 ? found : std::max(0, std::min(landed, last));
+    cursor.id = targetID;
+    ALGO_COUNT("algo.finger_search.probes", probes);
+    ALGO_HISTOGRAM("algo.finger_search.probes", probes);
+    return found;
+}
+
+int Algo::interpolateRange(int low, int high, int64_t targetID, int& probes, int& landed) const
+{
+    int found = -1;
     while (low <= high && targetID >= stations[low].id && targetID <= stations[high].id) {
         ++probes;
 
         if (low == high) {
-            if (stations[low].id == targetID) return low;
-            return -1;
+            if (stations[low].id == targetID) found = low;
+            break;
         }
 
         int pos = low + (int)((double)(targetID - stations[low].id) * (high - low) /
                               (stations[high].id - stations[low].id));
 
-        if (stations[pos].id == targetID)
-            return pos;
+        if (stations[pos].id == targetID) {
+            found = pos;
+            break;
+        }
         else if (stations[pos].id < targetID)
             low = pos + 1;
         else
             high = pos - 1;
     }
 
-    return -1;
+    landed = found >= 0 ? found : low;
+    return found;
 }
 
-void Algo::benchmarkInterpolationSearch(int targetID)
+void Algo::benchmarkInterpolationSearch(int64_t targetID, std::ostream& out)
 {
     int probes = 0;
 
@@ -100,67 +184,70 @@ void Algo::benchmarkInterpolationSearch(int targetID)
 
     std::chrono::duration<double, std::micro> duration = end - start;
 
-    std::cout << "----- Interpolation Search Benchmark -----" << std::endl;
-    std::cout << "Array size: " << stations.size() << std::endl;
-    std::cout << "Target station ID: " << targetID << std::endl;
+    out << "----- Interpolation Search Benchmark -----" << std::endl;
+    out << "Array size: " << stations.size() << std::endl;
+    out << "Target station ID: " << targetID << std::endl;
 
     if (pos != -1)
-        std::cout << "Found at index: " << pos << std::endl;
+        out << "Found at index: " << pos << std::endl;
     else
-        std::cout << "Station not found." << std::endl;
+        out << "Station not found." << std::endl;
 
-    std::cout << "Probes/iterations: " << probes << std::endl;
-    std::cout << "Time taken: " << duration.count() << " microseconds" << std::endl;
-    std::cout << "-----------------------------------------" << std::endl;
+    out << "Probes/iterations: " << probes << std::endl;
+    out << "Time taken: " << duration.count() << " microseconds" << std::endl;
+    out << "-----------------------------------------" << std::endl;
 }
 
-void Algo::generateSequentialStations(const std::string& filepath, int limit) {
-    std::ofstream file(filepath);
-    if (!file.is_open()) {
-        std::cerr << "Failed to open file for writing: " << filepath << std::endl;
-        return;
-    }
-
-    for (int id = 1; id <= limit; ++id) {
-        file << "Station_" << id << std::endl; // write station name
-    }
-
-    file.close();
-    std::cout << "Generated stations from 1 to " << limit << " in " << filepath << std::endl;
+bool Algo::generateSequentialStations(const std::string& filepath, int limit) {
+    ALGO_SPAN("algo.generate_sequential_stations");
+    StationGeneratorOptions options;
+    options.count = limit > 0 ? limit : 0;
+    options.meanGap = 1; // every gap is 1, so the ids run 1..limit
+    return writeStations(filepath, options);
 }
 
 
-void Algo::generateHighlyNonUniformStations(const std::string &filepath, int numStations)
+bool Algo::generateHighlyNonUniformStations(const std::string &filepath, int numStations)
 {
-    std::ofstream file(filepath);
-    if (!file.is_open()) {
-        std::cerr << "Failed to open file: " << filepath << std::endl;
-        return;
-    }
-
+    ALGO_SPAN("algo.generate_non_uniform_stations");
+    // tiny gaps, a medium gap every third station and a huge one every tenth
+    StationGeneratorOptions options;
+    options.count = numStations > 0 ? numStations : 0;
+    options.gaps = GapDistribution::Clustered;
     std::random_device rd;
-    std::mt19937_64 gen(rd()); // 64-bit RNG
-    std::uniform_int_distribution<int64_t> tinyGap(1, 5);
-    std::uniform_int_distribution<int64_t> mediumGap(50, 200);
-    std::uniform_int_distribution<int64_t> hugeGap(5000, 20000);
-
-    int64_t currentID = 1;
+    options.seed = (static_cast<std::uint64_t>(rd()) << 32) | rd();
+    return writeStations(filepath, options);
+}
 
-    for (int i = 0; i < numStations; ++i) {
-        file << "Station_" << currentID << std::endl;
+bool Algo::writeStations(const std::string& filepath, const StationGeneratorOptions& options)
+{
+    try {
+        StationGenerator::generate(filepath, options);
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
 
-        // Use highly irregular gaps
-        if (i % 10 == 0)
-            currentID += hugeGap(gen);
-        else if (i % 3 == 0)
-            currentID += mediumGap(gen);
-        else
-            currentID += tinyGap(gen);
+bool Algo::loadStationSnapshot(const std::string& file_path)
+{
+    ALGO_SPAN("algo.load_station_snapshot");
+    std::vector<std::int64_t> ids;
+    try {
+        ids = StationGenerator::readSnapshot(file_path);
+    } catch (const std::exception&) {
+        return false;
     }
 
-    file.close();
-    std::cout << "Generated " << numStations << " highly non-uniform stations in "
-              << filepath << std::endl;
+    stations.clear();
+    stations.reserve(ids.size());
+    for (std::int64_t id : ids) {
+        std::pmr::string name("Station_", stations.get_allocator());
+        name += std::to_string(id);
+        stations.push_back(Station{ id, std::move(name), false });
+    }
+    ALGO_COUNT("algo.stations_loaded", stations.size());
+    return true;
 }
 
 int64_t Algo::generateHardTarget()
@@ -189,10 +276,6 @@ int64_t Algo::generateHardTarget()
 
     std::uniform_int_distribution<int64_t> offsetDist(1, nextID - baseID - 1);
     int64_t targetID = baseID + offsetDist(gen);
-
-    std::cout << "Generated hard target ID: " << targetID
-              << " (between " << baseID << " and " << nextID << ")\n";
-
     return targetID;
 }
 
@@ -210,12 +293,7 @@ int64_t Algo::generateHardExistingTarget()
     bool pickStart = (gen() % 2 == 0);
     size_t idx = pickStart ? dist(gen) : stations.size() - 1 - dist(gen);
 
-    int64_t targetID = stations[idx].id;
-
-    std::cout << "Generated hard-but-existing target: " << targetID
-              << " at index " << idx << "\n";
-
-    return targetID;
+    return stations[idx].id;
 }
 
 int64_t Algo::pickTargetFromStations()
@@ -234,12 +312,32 @@ void Algo::clearStations()
 {
     stations.clear();
 }
+
+std::vector<Station> Algo::getStationsSortedByName() const
+{
+    ALGO_SPAN("algo.stations_sorted_by_name");
+    std::vector<std::string_view> names(stations.size());
+    for (size_t i = 0; i < stations.size(); ++i) {
+        names[i] = stations[i].name;
+    }
+
+    // sort views of the names, then copy every station once in final order
+    std::vector<size_t> order = BucketSort::stringSortOrder(names);
+    std::vector<Station> sorted;
+    sorted.reserve(stations.size());
+    for (size_t index : order) {
+        sorted.push_back(stations[index]);
+    }
+    return sorted;
+}
 //===================================================
 //Recursive Subset Sum Count (Exponential) functions.
 //===================================================
 int Algo::countSubsets(const std::vector<int> &arr, int n, int sum, int& probes)
 {
    ++probes;  // count every recursive call as a probe
+   ALGO_DEPTH("algo.count_subsets");
+   ALGO_COUNT("algo.count_subsets.calls", 1);
 
     if (sum == 0) return 1;  // found a valid subset
     if (n == 0) return 0;    // no elements left
@@ -252,7 +350,8 @@ int Algo::countSubsets(const std::vector<int> &arr, int n, int sum, int& probes)
            countSubsets(arr, n-1, sum - arr[n-1], probes);
 }
 
-void Algo::benchmarkSubsetSum(const std::vector<int>& arr, int targetSum) {
+void Algo::benchmarkSubsetSum(const std::vector<int>& arr, int targetSum, std::ostream& out) {
+    ALGO_SPAN("algo.benchmark_subset_sum");
     int probes = 0;
 
     auto start = std::chrono::high_resolution_clock::now();
@@ -261,11 +360,11 @@ void Algo::benchmarkSubsetSum(const std::vector<int>& arr, int targetSum) {
 
     double time_taken = std::chrono::duration<double, std::micro>(end - start).count();
 
-    std::cout << "----- Subset Sum Benchmark -----\n";
-    std::cout << "Array size: " << arr.size() << "\n";
-    std::cout << "Target sum: " << targetSum << "\n";
-    std::cout << "Number of subsets: " << count << "\n";
-    std::cout << "Probes (recursive calls): " << probes << "\n";
-    std::cout << "Time taken: " << time_taken << " microseconds\n";
-    std::cout << "--------------------------------\n";
+    out << "----- Subset Sum Benchmark -----\n";
+    out << "Array size: " << arr.size() << "\n";
+    out << "Target sum: " << targetSum << "\n";
+    out << "Number of subsets: " << count << "\n";
+    out << "Probes (recursive calls): " << probes << "\n";
+    out << "Time taken: " << time_taken << " microseconds\n";
+    out << "--------------------------------\n";
 }
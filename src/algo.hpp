@@ -5,37 +5,66 @@
 #include <chrono>
 #include <fstream>
 #include <string>
+#include <memory_resource>
+#include "station_generator.hpp"
 //this is to hold the station struct data
 struct Station{
     std::int64_t id;
-    std::string name; // name of station
+    std::pmr::string name; // name of station, from the table's memory resource
     bool faulty;     //check if faulty or not.
 };
 
+//where the previous fingerSearch ended; one cursor per query stream.
+struct SearchCursor {
+    int position = -1; //-1 until the first search
+    int64_t id = 0;    //id last searched for, which landed at position
+};
+
 
 class Algo {
     public :
+    //the station table and the station names are allocated from resource
+    //(e.g. an ArenaResource shared by a request). Copies handed out, like
+    //getStationsSortedByName, use the default resource.
+    explicit Algo(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
     //interpolation search functions 
     //===============================
-    void loadStations(std::string file_path);
-    int setRandomFaultyStation();
+    //returns false if the file could not be opened.
+    bool loadStations(std::string file_path);
+    //same, from a binary snapshot written by StationGenerator.
+    bool loadStationSnapshot(const std::string& file_path);
+    int64_t setRandomFaultyStation();
     int interpolationSearch(int64_t targetID, int& probes);
-    void benchmarkInterpolationSearch(int targetID);
+    //same result as interpolationSearch, but starts at the cursor: a nearby
+    //target is bracketed by galloping outward from the last position and then
+    //interpolated inside the bracket, so a target d stations away costs
+    //O(log d) probes. Far targets get a plain interpolation search.
+    int fingerSearch(int64_t targetID, SearchCursor& cursor, int& probes);
+    void benchmarkInterpolationSearch(int64_t targetID, std::ostream& out = std::cout);
     //void generateNonUniformStations(const std::string& filepath, int numStations, int minGap = 1, int maxGap = 50);
-    void generateSequentialStations(const std::string& filepath, int limit);
-    void generateHighlyNonUniformStations(const std::string &filepath, int numStations);
+    //both return false if the file could not be written. They are thin
+    //wrappers over StationGenerator, which also writes bigger and binary files.
+    bool generateSequentialStations(const std::string& filepath, int limit);
+    bool generateHighlyNonUniformStations(const std::string &filepath, int numStations);
     int64_t generateHardTarget();
     int64_t generateHardExistingTarget();
     int64_t pickTargetFromStations();
     void clearStations();
+    //stations ordered by name for reports (the search order stays by id).
+    std::vector<Station> getStationsSortedByName() const;
 
     //Recursive Subset Sum Count (Exponential) functions.
     //===================================================
     int countSubsets(const std::vector<int>& arr, int n, int sum, int& probes);
-    void benchmarkSubsetSum(const std::vector<int>& arr, int targetSum);
+    void benchmarkSubsetSum(const std::vector<int>& arr, int targetSum, std::ostream& out = std::cout);
 
     private:
+    bool writeStations(const std::string& filepath, const StationGeneratorOptions& options);
+    //interpolation search within [low, high]; landed is where it stopped.
+    int interpolateRange(int low, int high, int64_t targetID, int& probes, int& landed) const;
+
     //holding the list of stations.
-    std::vector<Station> stations;
+    std::pmr::vector<Station> stations;
     std::mt19937 gen;  // RNG reused
 };
\ No newline at end of file
@@ -0,0 +1,68 @@
+/**
+ * @file alloc_counting.cpp
+ * @brief Counting replacements for the global operator new and delete
+ *
+ * Built as the alloc_counting CMake target; only programs that link it
+ * replace their allocator (see alloc_stats.hpp).
+ */
+
+#include "alloc_stats.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+const std::size_t kHeaderBytes = 16; // keeps max_align_t alignment
+
+// Runs during static initialization, before main can ask.
+const bool gMarked = (markAllocationCounting(), true);
+
+// extra bytes are allocated past the block but not counted.
+void* countedAlloc(std::size_t size, std::size_t extra = 0) {
+    void* block = std::malloc(size + extra + kHeaderBytes);
+    if (!block) throw std::bad_alloc();
+    *static_cast<std::size_t*>(block) = size;
+    recordAllocation(size);
+    return static_cast<char*>(block) + kHeaderBytes;
+}
+
+void countedFree(void* ptr) {
+    if (!ptr) return;
+    void* block = static_cast<char*>(ptr) - kHeaderBytes;
+    recordDeallocation(*static_cast<std::size_t*>(block));
+    std::free(block);
+}
+
+// Over-aligned blocks (std::pmr::new_delete_resource always asks for an
+// alignment) keep the malloc'd address just below the counted block.
+void* countedAlignedAlloc(std::size_t size, std::align_val_t alignment) {
+    std::size_t align = std::max(static_cast<std::size_t>(alignment), kHeaderBytes);
+    char* block = static_cast<char*>(countedAlloc(size, align + sizeof(void*)));
+    std::uintptr_t first = reinterpret_cast<std::uintptr_t>(block + sizeof(void*));
+    char* aligned = block + sizeof(void*) + (align - first % align) % align;
+    reinterpret_cast<void**>(aligned)[-1] = block;
+    return aligned;
+}
+
+void countedAlignedFree(void* ptr) {
+    if (!ptr) return;
+    countedFree(static_cast<void**>(ptr)[-1]);
+}
+
+} // namespace
+
+void* operator new(std::size_t size) { return countedAlloc(size); }
+void* operator new[](std::size_t size) { return countedAlloc(size); }
+void operator delete(void* ptr) noexcept { countedFree(ptr); }
+void operator delete[](void* ptr) noexcept { countedFree(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { countedFree(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { countedFree(ptr); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return countedAlignedAlloc(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return countedAlignedAlloc(size, alignment); }
+void operator delete(void* ptr, std::align_val_t) noexcept { countedAlignedFree(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { countedAlignedFree(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { countedAlignedFree(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { countedAlignedFree(ptr); }
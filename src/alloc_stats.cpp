@@ -0,0 +1,66 @@
+/**
+ * @file alloc_stats.cpp
+ * @brief Heap counters, fed by the operator new and delete of alloc_counting.cpp
+ */
+
+#include "alloc_stats.hpp"
+#include <atomic>
+
+namespace {
+
+std::atomic<bool> gCountingEnabled{ false };
+std::atomic<std::uint64_t> gAllocations{ 0 };
+std::atomic<std::uint64_t> gBytesAllocated{ 0 };
+std::atomic<std::int64_t> gLiveBytes{ 0 };
+std::atomic<std::int64_t> gPeakBytes{ 0 };
+#if ALGO_INSTRUMENTATION
+thread_local std::uint64_t tThreadAllocations = 0;
+#endif
+
+} // namespace
+
+bool allocationCountingEnabled() {
+    return gCountingEnabled.load(std::memory_order_relaxed);
+}
+
+AllocationStats currentAllocationStats() {
+    AllocationStats stats;
+    stats.allocations = gAllocations.load(std::memory_order_relaxed);
+    stats.bytesAllocated = gBytesAllocated.load(std::memory_order_relaxed);
+    stats.liveBytes = gLiveBytes.load(std::memory_order_relaxed);
+    stats.peakBytes = gPeakBytes.load(std::memory_order_relaxed);
+    return stats;
+}
+
+std::uint64_t threadAllocationCount() {
+#if ALGO_INSTRUMENTATION
+    return tThreadAllocations;
+#else
+    return 0;
+#endif
+}
+
+void resetPeakBytes() {
+    gPeakBytes.store(gLiveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void markAllocationCounting() {
+    gCountingEnabled.store(true, std::memory_order_relaxed);
+}
+
+void recordAllocation(std::size_t bytes) {
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+#if ALGO_INSTRUMENTATION
+    ++tThreadAllocations;
+#endif
+    gBytesAllocated.fetch_add(bytes, std::memory_order_relaxed);
+    std::int64_t live = gLiveBytes.fetch_add(static_cast<std::int64_t>(bytes), std::memory_order_relaxed)
+                        + static_cast<std::int64_t>(bytes);
+    std::int64_t peak = gPeakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !gPeakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+}
+
+void recordDeallocation(std::size_t bytes) {
+    gLiveBytes.fetch_sub(static_cast<std::int64_t>(bytes), std::memory_order_relaxed);
+}
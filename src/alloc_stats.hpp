@@ -0,0 +1,78 @@
+/**
+ * @file alloc_stats.hpp
+ * @brief Process-wide heap accounting
+ *
+ * @section description Description
+ * alloc_counting.cpp replaces the global operator new and delete (aligned
+ * overloads included) with versions that feed these counters, so any
+ * region of code can report how many allocations it made and how many
+ * bytes it requested. Counters are relaxed atomics; each block carries a
+ * 16-byte size header.
+ *
+ * The replacement is opt-in: it is the alloc_counting CMake target, which
+ * the benchmarks and tests link, and which instrumented builds
+ * (ALGO_INSTRUMENTATION) link into every executable. Other programs keep
+ * the standard allocator; their counters stay at 0 and
+ * allocationCountingEnabled() is false.
+ *
+ * @section usage Usage
+ * AllocationStats before = currentAllocationStats();
+ * run();
+ * AllocationStats used = currentAllocationStats() - before;
+ */
+
+#ifndef ALLOC_STATS_HPP
+#define ALLOC_STATS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @struct AllocationStats
+ * @brief Snapshot of the heap counters
+ */
+struct AllocationStats {
+    std::uint64_t allocations = 0;     ///< Calls to operator new so far
+    std::uint64_t bytesAllocated = 0;  ///< Bytes requested so far
+    std::int64_t liveBytes = 0;        ///< Bytes currently allocated
+    std::int64_t peakBytes = 0;        ///< Highest liveBytes since the last resetPeakBytes()
+
+    /**
+     * @brief Counts between two snapshots; live and peak are taken from this one
+     */
+    AllocationStats operator-(const AllocationStats& earlier) const {
+        return { allocations - earlier.allocations, bytesAllocated - earlier.bytesAllocated, liveBytes, peakBytes };
+    }
+};
+
+/**
+ * @brief Whether this program links the counting operator new and delete
+ */
+bool allocationCountingEnabled();
+
+/**
+ * @brief Reads the current heap counters
+ */
+AllocationStats currentAllocationStats();
+
+/**
+ * @brief Allocations made so far by the calling thread
+ *
+ * Counted only in builds with ALGO_INSTRUMENTATION (see instrumentation.hpp),
+ * where spans use it; otherwise always 0 so operator new stays as cheap.
+ */
+std::uint64_t threadAllocationCount();
+
+/**
+ * @brief Restarts peak tracking from the current live byte count
+ */
+void resetPeakBytes();
+
+/**
+ * @brief Hooks for alloc_counting.cpp's operator new and delete
+ */
+void markAllocationCounting();
+void recordAllocation(std::size_t bytes);
+void recordDeallocation(std::size_t bytes);
+
+#endif
@@ -1,23 +1,33 @@
 ﻿#include "bucket_sort.hpp"
+#include "instrumentation.hpp"
 #include <iostream>
 #include <fstream>
 #include <chrono>
 #include <algorithm>
 #include <cmath>
 #include <random>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <ostream>
 
 void BucketSort::loadFromFile(const std::string& filename) {
+    ALGO_SPAN("bucket_sort.load_from_file");
     std::ifstream file(filename);
     int value;
 
     numbers.clear();
+    sortedCount = 0;
+    rankIndexValid = false;
 
     while (file >> value) {
         numbers.push_back(value);
     }
 }
 
-void BucketSort::insertionSort(std::vector<int>& bucket) {
+void BucketSort::insertionSort(std::pmr::vector<int>& bucket) {
     for (size_t i = 1; i < bucket.size(); i++) {
         int key = bucket[i];
         int j = static_cast<int>(i) - 1;
@@ -30,26 +40,179 @@ void BucketSort::insertionSort(std::vector<int>& bucket) {
     }
 }
 
+namespace {
+
+// Counting sort when the value range is at most this multiple of n...
+const std::uint64_t kCountingRangeFactor = 4;
+// ...or when its count table stays cache resident (128 KB) and n is not tiny.
+const std::uint64_t kCacheResidentCounts = 1 << 15;
+// Counting sort, forced or not, never uses a table larger than this (256 MB).
+const std::uint64_t kMaxCountingRange = std::uint64_t(1) << 26;
+// Radix needs enough numbers to amortize its scratch buffer and passes,
+// and at most three 8-bit digit passes to beat the bucket sort.
+const std::size_t kRadixMinSize = 2048;
+const std::uint64_t kRadixMaxRange = std::uint64_t(1) << 24;
+// American flag partitions this small go to insertion sort.
+const std::ptrdiff_t kInPlaceSmallPartition = 32;
+
+} // namespace
+
+const char* sortStrategyName(SortStrategy strategy) {
+    switch (strategy) {
+    case SortStrategy::Auto: return "auto";
+    case SortStrategy::Bucket: return "bucket";
+    case SortStrategy::Counting: return "counting";
+    case SortStrategy::Radix: return "radix";
+    case SortStrategy::InPlace: return "inplace";
+    }
+    return "unknown";
+}
+
+SortStrategy BucketSort::chooseStrategy(std::uint64_t range) const {
+    std::uint64_t n = numbers.size();
+
+    switch (strategy) {
+    case SortStrategy::Bucket:
+    case SortStrategy::Radix:
+    case SortStrategy::InPlace:
+        return strategy;
+    case SortStrategy::Counting:
+        return range <= kMaxCountingRange ? SortStrategy::Counting : SortStrategy::Radix;
+    case SortStrategy::Auto:
+        break;
+    }
+
+    if (range <= kMaxCountingRange &&
+        (range <= kCountingRangeFactor * n || (range <= kCacheResidentCounts && n * 8 >= range))) {
+        return SortStrategy::Counting;
+    }
+    if (n >= kRadixMinSize && range <= kRadixMaxRange) {
+        return SortStrategy::Radix;
+    }
+    return SortStrategy::Bucket;
+}
+
+void BucketSort::insertionSort(int* first, int* last) {
+    for (int* i = first + 1; i < last; ++i) {
+        int key = *i;
+        int* j = i;
+        while (j > first && *(j - 1) > key) {
+            *j = *(j - 1);
+            --j;
+        }
+        *j = key;
+    }
+}
+
 void BucketSort::bucketSort() {
+    ALGO_SPAN("bucket_sort.sort");
+    lastStrategy = SortStrategy::Auto;
+    if (sortedCount > numbers.size()) sortedCount = 0;
+    if (sortedCount == numbers.size()) return; // nothing new since the last sort
+    rankIndexValid = false;
+
+    std::size_t batchSize = numbers.size() - sortedCount;
+    if (sortedCount == 0 || batchSize > sortedCount) {
+        sortAll();
+        sortedCount = numbers.size();
+        return;
+    }
+
+    // Sort only the appended batch (swapping vectors keeps the big prefix in
+    // place), then merge it into the sorted prefix.
+    std::vector<int> batch(numbers.begin() + sortedCount, numbers.end());
+    numbers.resize(sortedCount);
+    numbers.swap(batch);
+    sortAll();
+    numbers.swap(batch);
+    mergeSortedBatch(batch);
+    sortedCount = numbers.size();
+}
+
+namespace {
+
+// First index in [0, hi) whose value is greater than key, galloping leftwards
+// from hi so that keys landing near the end of the prefix cost O(log d).
+std::size_t gallopUpperBound(const int* data, std::size_t hi, int key) {
+    std::size_t step = 1;
+    std::size_t upper = hi;
+    while (step <= upper && data[upper - step] > key) {
+        hi = upper - step;
+        step *= 2;
+    }
+    std::size_t lower = step <= upper ? upper - step : 0;
+    return static_cast<std::size_t>(std::upper_bound(data + lower, data + hi, key) - data);
+}
+
+} // namespace
+
+void BucketSort::mergeSortedBatch(const std::vector<int>& batch) {
+    // Merge from the back: every prefix element moves at most once, and only
+    // the elements above the batch's smallest value move at all.
+    std::size_t hi = numbers.size();
+    numbers.resize(numbers.size() + batch.size());
+    std::size_t out = numbers.size();
+    int* data = numbers.data();
+
+    for (std::size_t b = batch.size(); b-- > 0;) {
+        int value = batch[b];
+        std::size_t pos = gallopUpperBound(data, hi, value);
+        std::move_backward(data + pos, data + hi, data + out);
+        out -= hi - pos;
+        hi = pos;
+        data[--out] = value;
+    }
+}
+
+void BucketSort::sortAll() {
     if (numbers.empty()) return;
 
-    int minVal = *std::min_element(numbers.begin(), numbers.end());
-    int maxVal = *std::max_element(numbers.begin(), numbers.end());
+    auto minMax = std::minmax_element(numbers.begin(), numbers.end());
+    int minVal = *minMax.first;
+    int maxVal = *minMax.second;
 
     if (minVal == maxVal) return;
 
+    std::uint64_t range = static_cast<std::uint64_t>(static_cast<std::int64_t>(maxVal) - minVal) + 1;
+    lastStrategy = chooseStrategy(range);
+    ALGO_COUNT(lastStrategy == SortStrategy::Counting ? "bucket_sort.strategy.counting"
+               : lastStrategy == SortStrategy::Radix ? "bucket_sort.strategy.radix"
+               : lastStrategy == SortStrategy::InPlace ? "bucket_sort.strategy.inplace"
+               : "bucket_sort.strategy.bucket", 1);
+    ALGO_COUNT("bucket_sort.numbers_sorted", numbers.size());
+
+    switch (lastStrategy) {
+    case SortStrategy::Counting:
+        countingSort(minVal, maxVal);
+        break;
+    case SortStrategy::Radix:
+        radixSort(minVal, maxVal);
+        break;
+    case SortStrategy::InPlace:
+        americanFlagSort(minVal, maxVal);
+        break;
+    default:
+        classicBucketSort(minVal, maxVal);
+        break;
+    }
+}
+
+void BucketSort::classicBucketSort(int minVal, int maxVal) {
     int bucketCount = std::max(1, static_cast<int>(std::sqrt(numbers.size())));
-    std::vector<std::vector<int>> buckets(bucketCount);
+    // The inner vectors pick up the resource through uses-allocator construction.
+    std::pmr::vector<std::pmr::vector<int>> buckets(bucketCount, resource);
 
+    // Normalize in double: num - minVal overflows int for wide ranges.
+    double span = static_cast<double>(maxVal) - minVal;
     for (int num : numbers) {
-       
-        double normalized = static_cast<double>(num - minVal) / (maxVal - minVal);
+        double normalized = (static_cast<double>(num) - minVal) / span;
         int idx = std::min(bucketCount - 1, static_cast<int>(normalized * bucketCount));
         buckets[idx].push_back(num);
     }
 
     numbers.clear();
     for (auto& bucket : buckets) {
+        ALGO_HISTOGRAM("bucket_sort.bucket_occupancy", bucket.size());
         if (!bucket.empty()) {
             insertionSort(bucket);
             for (int num : bucket) {
@@ -59,13 +222,388 @@ void BucketSort::bucketSort() {
     }
 }
 
-void BucketSort::printNumbers() const {
+void BucketSort::countingSort(int minVal, int maxVal) {
+    std::size_t range = static_cast<std::size_t>(static_cast<std::int64_t>(maxVal) - minVal) + 1;
+    std::pmr::vector<std::uint32_t> counts(range, 0, resource);
+
     for (int num : numbers) {
-        std::cout << num << std::endl;
+        ++counts[static_cast<std::uint32_t>(num - minVal)];
+    }
+
+    // Rebuild straight from the histogram; no per-element moves are needed.
+    auto out = numbers.begin();
+    for (std::size_t v = 0; v < range; ++v) {
+        if (counts[v] != 0) {
+            out = std::fill_n(out, counts[v], static_cast<int>(minVal + static_cast<std::int64_t>(v)));
+        }
     }
 }
 
-void BucketSort::benchmark(int iterations) {
+void BucketSort::radixSort(int minVal, int maxVal) {
+    // Sort the unsigned offsets from minVal, so only the digits that the
+    // range actually uses need a pass.
+    std::uint32_t maxKey = static_cast<std::uint32_t>(maxVal) - static_cast<std::uint32_t>(minVal);
+    std::pmr::vector<int> scratch(numbers.size(), resource);
+    int* src = numbers.data();
+    int* dst = scratch.data();
+    std::size_t n = numbers.size();
+
+    for (int shift = 0; shift < 32 && (maxKey >> shift) != 0; shift += 8) {
+        std::size_t counts[256] = {};
+        for (std::size_t i = 0; i < n; ++i) {
+            std::uint32_t key = static_cast<std::uint32_t>(src[i]) - static_cast<std::uint32_t>(minVal);
+            ++counts[(key >> shift) & 0xFF];
+        }
+
+        std::size_t offset = 0;
+        for (std::size_t& count : counts) {
+            std::size_t c = count;
+            count = offset;
+            offset += c;
+        }
+
+        for (std::size_t i = 0; i < n; ++i) {
+            std::uint32_t key = static_cast<std::uint32_t>(src[i]) - static_cast<std::uint32_t>(minVal);
+            dst[counts[(key >> shift) & 0xFF]++] = src[i];
+        }
+        std::swap(src, dst);
+    }
+
+    if (src != numbers.data()) {
+        std::copy(src, src + n, numbers.data());
+    }
+}
+
+void BucketSort::americanFlagSort(int minVal, int maxVal) {
+    // MSD over the offsets from minVal, starting at the highest digit the
+    // range uses.
+    std::uint32_t maxKey = static_cast<std::uint32_t>(maxVal) - static_cast<std::uint32_t>(minVal);
+    int shift = 24;
+    while (shift > 0 && (maxKey >> shift) == 0) shift -= 8;
+
+    americanFlagSort(numbers.data(), numbers.data() + numbers.size(),
+                     static_cast<std::uint32_t>(minVal), shift);
+}
+
+void BucketSort::americanFlagSort(int* first, int* last, std::uint32_t minVal, int shift) {
+    ALGO_DEPTH("bucket_sort.american_flag");
+    if (last - first <= kInPlaceSmallPartition) {
+        insertionSort(first, last);
+        return;
+    }
+
+    auto digit = [minVal, shift](int num) {
+        return ((static_cast<std::uint32_t>(num) - minVal) >> shift) & 0xFF;
+    };
+
+    std::size_t next[256] = {};
+    std::size_t end[256];
+    for (int* p = first; p < last; ++p) ++next[digit(*p)];
+
+    std::size_t offset = 0;
+    for (int b = 0; b < 256; ++b) {
+        std::size_t count = next[b];
+        next[b] = offset;
+        offset += count;
+        end[b] = offset;
+    }
+
+    // Cycle-leader permutation: each swap drops one element into its bin.
+    for (int b = 0; b < 256; ++b) {
+        while (next[b] < end[b]) {
+            int value = first[next[b]];
+            std::uint32_t d = digit(value);
+            while (d != static_cast<std::uint32_t>(b)) {
+                std::swap(value, first[next[d]++]);
+                d = digit(value);
+            }
+            first[next[b]++] = value;
+        }
+    }
+
+    if (shift == 0) return;
+
+    std::size_t start = 0;
+    for (int b = 0; b < 256; ++b) {
+        if (end[b] - start > 1) {
+            americanFlagSort(first + start, first + end[b], minVal, shift - 8);
+        }
+        start = end[b];
+    }
+}
+
+//===================================================
+// Rank queries over lazily sorted buckets
+//===================================================
+bool BucketSort::prepareRanks() {
+    if (numbers.empty()) return false;
+    if (sortedCount > numbers.size()) sortedCount = 0;
+    if (isSorted() || rankIndexValid) return true;
+
+    // Finishing an incremental merge is cheaper than bucketing from scratch.
+    if (sortedCount > 0) {
+        bucketSort();
+        return true;
+    }
+
+    auto minMax = std::minmax_element(numbers.begin(), numbers.end());
+    int minVal = *minMax.first;
+    int maxVal = *minMax.second;
+    if (minVal == maxVal) {
+        sortedCount = numbers.size();
+        return true;
+    }
+
+    // One counting pass and one scatter pass, same bucket layout as bucketSort.
+    std::size_t bucketCount = std::max<std::size_t>(1, static_cast<std::size_t>(std::sqrt(numbers.size())));
+    std::uint64_t range = static_cast<std::uint64_t>(static_cast<std::int64_t>(maxVal) - minVal) + 1;
+    auto bucketOf = [&](int num) {
+        std::uint64_t offset = static_cast<std::uint64_t>(static_cast<std::int64_t>(num) - minVal);
+        return static_cast<std::size_t>(offset * bucketCount / range);
+    };
+
+    rankBucketStart.assign(bucketCount + 1, 0);
+    for (int num : numbers) ++rankBucketStart[bucketOf(num) + 1];
+    for (std::size_t b = 0; b < bucketCount; ++b) rankBucketStart[b + 1] += rankBucketStart[b];
+
+    std::pmr::vector<std::size_t> fill(rankBucketStart.begin(), rankBucketStart.end() - 1, resource);
+    std::vector<int> scattered(numbers.size());
+    for (int num : numbers) scattered[fill[bucketOf(num)]++] = num;
+    numbers.swap(scattered);
+
+    rankBucketSorted.assign(bucketCount, 0);
+    rankBucketsLeft = bucketCount;
+    rankIndexValid = true;
+    return true;
+}
+
+void BucketSort::sortRankBucket(std::size_t bucket) {
+    if (rankBucketSorted[bucket]) return;
+    ALGO_COUNT("bucket_sort.rank_buckets_sorted", 1);
+
+    int* first = numbers.data() + rankBucketStart[bucket];
+    int* last = numbers.data() + rankBucketStart[bucket + 1];
+    if (last - first <= 32) {
+        insertionSort(first, last);
+    } else {
+        std::sort(first, last);
+    }
+    rankBucketSorted[bucket] = 1;
+
+    // Every bucket got sorted along the way: the vector is now fully sorted.
+    if (--rankBucketsLeft == 0) {
+        sortedCount = numbers.size();
+        rankIndexValid = false;
+    }
+}
+
+// Sorts just the buckets covering ranks [firstRank, lastRank].
+void BucketSort::sortRanks(std::size_t firstRank, std::size_t lastRank) {
+    if (isSorted()) return;
+
+    auto bucketOfRank = [&](std::size_t rank) {
+        auto it = std::upper_bound(rankBucketStart.begin(), rankBucketStart.end(), rank);
+        return static_cast<std::size_t>(it - rankBucketStart.begin()) - 1;
+    };
+
+    std::size_t first = bucketOfRank(firstRank);
+    std::size_t last = bucketOfRank(lastRank);
+    for (std::size_t b = first; b <= last && !isSorted(); ++b) {
+        sortRankBucket(b);
+    }
+}
+
+int BucketSort::nthElement(std::size_t k) {
+    ALGO_SPAN("bucket_sort.nth_element");
+    if (k >= numbers.size()) {
+        throw std::out_of_range("nthElement: rank " + std::to_string(k) + " out of range");
+    }
+    prepareRanks();
+    sortRanks(k, k);
+    return numbers[k];
+}
+
+std::vector<int> BucketSort::topK(std::size_t k) {
+    ALGO_SPAN("bucket_sort.top_k");
+    k = std::min(k, numbers.size());
+    if (k == 0 || !prepareRanks()) return {};
+
+    std::size_t n = numbers.size();
+    sortRanks(n - k, n - 1);
+    return std::vector<int>(numbers.rbegin(), numbers.rbegin() + k);
+}
+
+std::vector<int> BucketSort::percentiles(const std::vector<double>& ps) {
+    ALGO_SPAN("bucket_sort.percentiles");
+    std::vector<int> result;
+    if (!prepareRanks()) return result;
+
+    std::size_t n = numbers.size();
+    result.reserve(ps.size());
+    for (double p : ps) {
+        double clamped = std::min(100.0, std::max(0.0, p));
+        std::size_t rank = static_cast<std::size_t>(std::ceil(clamped / 100.0 * n));
+        rank = rank == 0 ? 0 : rank - 1;
+        sortRanks(rank, rank);
+        result.push_back(numbers[rank]);
+    }
+    return result;
+}
+
+//===================================================
+// String MSD radix sort
+//===================================================
+namespace {
+
+const std::size_t kSmallStringSort = 32;
+
+struct StringEntry {
+    std::uint64_t prefix; // bytes [depth, depth + 8) big-endian, 0-padded
+    std::size_t index;
+};
+
+struct StringSorter {
+    const std::vector<std::string_view>& keys;
+    std::vector<StringEntry> scratch;
+
+    std::string_view tail(std::size_t index, std::size_t depth) const {
+        std::string_view s = keys[index];
+        return depth < s.size() ? s.substr(depth) : std::string_view();
+    }
+
+    std::uint64_t loadPrefix(std::size_t index, std::size_t depth) const {
+        std::string_view s = keys[index];
+        std::uint64_t prefix = 0;
+        for (std::size_t i = 0; i < 8; ++i) {
+            std::size_t pos = depth + i;
+            unsigned char c = pos < s.size() ? static_cast<unsigned char>(s[pos]) : 0;
+            prefix = (prefix << 8) | c;
+        }
+        return prefix;
+    }
+
+    void smallSort(StringEntry* a, std::size_t n, std::size_t depth) {
+        std::sort(a, a + n, [&](const StringEntry& x, const StringEntry& y) {
+            return tail(x.index, depth) < tail(y.index, depth);
+        });
+    }
+
+    // Entries in a share all 8 cached bytes: go 8 bytes deeper if any string
+    // continues, otherwise they only differ by trailing NUL bytes (length).
+    void sortEqualPrefix(StringEntry* a, std::size_t n, std::size_t depth) {
+        if (n < 2) return;
+        std::size_t next = depth + 8;
+        bool continues = false;
+        for (std::size_t i = 0; i < n && !continues; ++i) {
+            continues = keys[a[i].index].size() > next;
+        }
+        if (continues) {
+            sortFrom(a, n, next);
+        } else {
+            std::sort(a, a + n, [&](const StringEntry& x, const StringEntry& y) {
+                return keys[x.index].size() < keys[y.index].size();
+            });
+        }
+    }
+
+    void sortFrom(StringEntry* a, std::size_t n, std::size_t depth) {
+        if (n <= kSmallStringSort) {
+            smallSort(a, n, depth);
+            return;
+        }
+        for (std::size_t i = 0; i < n; ++i) a[i].prefix = loadPrefix(a[i].index, depth);
+        radixByte(a, n, depth, 0);
+    }
+
+    void radixByte(StringEntry* a, std::size_t n, std::size_t depth, int byte) {
+        if (n <= kSmallStringSort) {
+            std::sort(a, a + n, [](const StringEntry& x, const StringEntry& y) { return x.prefix < y.prefix; });
+            std::size_t start = 0;
+            for (std::size_t i = 1; i <= n; ++i) {
+                if (i == n || a[i].prefix != a[start].prefix) {
+                    sortEqualPrefix(a + start, i - start, depth);
+                    start = i;
+                }
+            }
+            return;
+        }
+
+        int shift = 56 - 8 * byte;
+        std::size_t counts[256] = {};
+        for (std::size_t i = 0; i < n; ++i) ++counts[(a[i].prefix >> shift) & 0xFF];
+
+        // A shared byte (like the "Station_" prefix) needs no data movement.
+        std::size_t shared = (a[0].prefix >> shift) & 0xFF;
+        if (counts[shared] == n) {
+            if (byte < 7) {
+                radixByte(a, n, depth, byte + 1);
+            } else {
+                sortEqualPrefix(a, n, depth);
+            }
+            return;
+        }
+
+        std::size_t offsets[257];
+        offsets[0] = 0;
+        for (int b = 0; b < 256; ++b) offsets[b + 1] = offsets[b] + counts[b];
+
+        std::size_t fill[256];
+        std::copy(offsets, offsets + 256, fill);
+        StringEntry* out = scratch.data();
+        for (std::size_t i = 0; i < n; ++i) out[fill[(a[i].prefix >> shift) & 0xFF]++] = a[i];
+        std::copy(out, out + n, a);
+
+        for (int b = 0; b < 256; ++b) {
+            std::size_t size = offsets[b + 1] - offsets[b];
+            if (size < 2) continue;
+            if (byte < 7) {
+                radixByte(a + offsets[b], size, depth, byte + 1);
+            } else {
+                sortEqualPrefix(a + offsets[b], size, depth);
+            }
+        }
+    }
+};
+
+} // namespace
+
+std::vector<std::size_t> BucketSort::stringSortOrder(const std::vector<const std::string*>& keys) {
+    std::vector<std::string_view> views(keys.size());
+    for (std::size_t i = 0; i < keys.size(); ++i) views[i] = *keys[i];
+    return stringSortOrder(views);
+}
+
+std::vector<std::size_t> BucketSort::stringSortOrder(const std::vector<std::string_view>& keys) {
+    ALGO_SPAN("bucket_sort.string_sort_order");
+    std::vector<StringEntry> entries(keys.size());
+    for (std::size_t i = 0; i < keys.size(); ++i) entries[i] = { 0, i };
+
+    StringSorter sorter{ keys, std::vector<StringEntry>(keys.size()) };
+    sorter.sortFrom(entries.data(), entries.size(), 0);
+
+    std::vector<std::size_t> order(keys.size());
+    for (std::size_t i = 0; i < entries.size(); ++i) order[i] = entries[i].index;
+    return order;
+}
+
+void BucketSort::sortStrings(std::vector<std::string>& keys) {
+    std::vector<const std::string*> pointers(keys.size());
+    for (std::size_t i = 0; i < keys.size(); ++i) pointers[i] = &keys[i];
+
+    std::vector<std::size_t> order = stringSortOrder(pointers);
+    std::vector<std::string> sorted;
+    sorted.reserve(keys.size());
+    for (std::size_t index : order) sorted.push_back(std::move(keys[index]));
+    keys.swap(sorted);
+}
+
+void BucketSort::printNumbers(std::ostream& out) const {
+    for (int num : numbers) {
+        out << num << "\n";
+    }
+}
+
+void BucketSort::benchmark(int iterations, std::ostream& out) {
     if (numbers.empty()) return;
 
     std::vector<int> original = numbers;
@@ -73,12 +611,15 @@ void BucketSort::benchmark(int iterations) {
     std::random_device rd;
     std::mt19937 gen(rd());
 
-    std::cout << "\nBenchmarking Bucket Sort:" << std::endl;
-    std::cout << "Dataset size: " << original.size() << std::endl;
-    std::cout << "Iterations: " << iterations << std::endl;
+    out << "\nBenchmarking Bucket Sort:" << std::endl;
+    out << "Dataset size: " << original.size() << std::endl;
+    out << "Iterations: " << iterations << std::endl;
+    out << "Strategy: " << sortStrategyName(strategy) << std::endl;
 
     for (int i = 0; i < iterations; i++) {
         numbers = original;
+        sortedCount = 0;
+        rankIndexValid = false;
         std::shuffle(numbers.begin(), numbers.end(), gen);
 
         auto start = std::chrono::high_resolution_clock::now();
@@ -90,7 +631,7 @@ void BucketSort::benchmark(int iterations) {
 
         for (size_t j = 1; j < numbers.size(); j++) {
             if (numbers[j - 1] > numbers[j]) {
-                std::cerr << "ERROR: Sorting failed at iteration " << i << std::endl;
+                out << "ERROR: Sorting failed at iteration " << i << std::endl;
                 return;
             }
         }
@@ -100,6 +641,398 @@ void BucketSort::benchmark(int iterations) {
     double avgTimeMicros = avgTimeNs / 1000.0;
     double avgTimeMs = avgTimeMicros / 1000.0;
 
-    std::cout << "Average time: " << avgTimeMicros << " microseconds ("
+    out << "Average time: " << avgTimeMicros << " microseconds ("
         << avgTimeMs << " ms)" << std::endl;
+    out << "Chosen strategy: " << sortStrategyName(lastStrategy) << std::endl;
+}
+
+//===================================================
+// External (out-of-core) bucket sort
+//===================================================
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const std::size_t kTextBufferBytes = 1 << 20;
+const std::size_t kMinMemoryBudget = 64 * 1024;
+const std::size_t kMinSpillBufferBytes = 4096;
+// numbers plus the per-bucket copies bucketSort makes, with vector slack.
+const std::size_t kInMemoryBytesPerElement = 12;
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Streams whitespace separated integers out of a text file. Tokens that
+// are not integers, or fall outside the int range, are skipped and counted.
+class TextIntReader {
+public:
+    TextIntReader(std::FILE* file, std::size_t bufferBytes)
+        : file(file), buffer(bufferBytes) {}
+
+    bool next(int& value) {
+        for (;;) {
+            int c = peek();
+            if (c == EOF) return false;
+            if (isSpace(c)) {
+                ++pos;
+                continue;
+            }
+
+            bool negative = c == '-';
+            if (c == '-' || c == '+') {
+                ++pos;
+                c = peek();
+            }
+            // checked digit by digit, so no token can overflow the accumulator
+            const std::uint32_t limit = negative ? std::uint32_t(1) << 31 : (std::uint32_t(1) << 31) - 1;
+            std::uint32_t magnitude = 0;
+            bool digits = false;
+            bool bad = false;
+            for (; c != EOF && !isSpace(c); ++pos, c = peek()) {
+                unsigned digit = static_cast<unsigned>(c - '0');
+                if (digit > 9 || magnitude > (limit - digit) / 10) {
+                    bad = true;
+                } else if (!bad) {
+                    magnitude = magnitude * 10 + digit;
+                    digits = true;
+                }
+            }
+            if (!digits || bad) {
+                ++skipped;
+                continue;
+            }
+            value = negative ? static_cast<int>(0u - magnitude) : static_cast<int>(magnitude);
+            return true;
+        }
+    }
+
+    std::uint64_t bytesRead() const { return bytes; }
+    std::uint64_t malformed() const { return skipped; }
+
+private:
+    static bool isSpace(int c) { return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\f' || c == '\v'; }
+
+    int peek() {
+        if (pos == len) {
+            len = std::fread(buffer.data(), 1, buffer.size(), file);
+            pos = 0;
+            bytes += len;
+            if (len == 0) return EOF;
+        }
+        return static_cast<unsigned char>(buffer[pos]);
+    }
+
+    std::FILE* file;
+    std::vector<char> buffer;
+    std::size_t pos = 0;
+    std::size_t len = 0;
+    std::uint64_t bytes = 0;
+    std::uint64_t skipped = 0;
+};
+
+// Formats integers one per line into a large buffer and writes it in big blocks.
+class TextIntWriter {
+public:
+    TextIntWriter(std::FILE* file, std::size_t bufferBytes)
+        : file(file), buffer(bufferBytes) {}
+
+    void put(int value) {
+        if (len + 16 > buffer.size()) flush();
+        char digits[16];
+        int count = 0;
+        unsigned int magnitude = value < 0 ? 0u - static_cast<unsigned int>(value)
+                                           : static_cast<unsigned int>(value);
+        do {
+            digits[count++] = static_cast<char>('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude != 0);
+        if (value < 0) buffer[len++] = '-';
+        while (count > 0) buffer[len++] = digits[--count];
+        buffer[len++] = '\n';
+    }
+
+    void flush() {
+        if (len == 0) return;
+        std::size_t written = std::fwrite(buffer.data(), 1, len, file);
+        if (written != len) failed = true;
+        bytes += written;
+        len = 0;
+    }
+
+    std::uint64_t bytesWritten() const { return bytes; }
+    bool hasFailed() const { return failed; }
+
+private:
+    std::FILE* file;
+    std::vector<char> buffer;
+    std::size_t len = 0;
+    std::uint64_t bytes = 0;
+    bool failed = false; // a write came up short, e.g. on a full disk
+};
+
+// Buffered writer for one binary bucket spill file.
+class SpillWriter {
+public:
+    bool open(const std::string& path, std::size_t bufferInts) {
+        file = std::fopen(path.c_str(), "wb");
+        buffer.resize(std::max<std::size_t>(1, bufferInts));
+        return file != nullptr;
+    }
+
+    void put(int value) {
+        buffer[len++] = value;
+        if (len == buffer.size()) flush();
+        ++count;
+        minVal = std::min(minVal, value);
+        maxVal = std::max(maxVal, value);
+    }
+
+    std::uint64_t close() {
+        flush();
+        if (file && std::fclose(file) != 0) failed = true;
+        file = nullptr;
+        std::vector<int>().swap(buffer);
+        return bytes;
+    }
+
+    bool hasFailed() const { return failed; }
+
+    std::uint64_t count = 0;
+    int minVal = std::numeric_limits<int>::max();
+    int maxVal = std::numeric_limits<int>::min();
+
+private:
+    void flush() {
+        if (len == 0) return;
+        std::size_t written = std::fwrite(buffer.data(), sizeof(int), len, file);
+        if (written != len) failed = true;
+        bytes += written * sizeof(int);
+        len = 0;
+    }
+
+    std::FILE* file = nullptr;
+    std::vector<int> buffer;
+    std::size_t len = 0;
+    std::uint64_t bytes = 0;
+    bool failed = false;
+};
+
+} // namespace
+
+struct BucketSort::ExternalSortContext {
+    std::size_t budget = 0;
+    std::string spillPrefix;
+    std::uint64_t nextSpill = 0;
+    TextIntWriter* output = nullptr;
+    ExternalSortStats* stats = nullptr;
+    BucketSort* sorter = nullptr; // in-memory sorts, pinned to SortStrategy::Bucket
+
+    // Records the first failure; later steps see it and stop.
+    void fail(const std::string& message) {
+        if (stats->error.empty()) stats->error = message;
+    }
+    bool failed() const { return !stats->error.empty(); }
+
+    ExternalSortPhase& partition() { return stats->phases[1]; }
+    ExternalSortPhase& sort() { return stats->phases[2]; }
+
+    std::string nextSpillPath() {
+        ++stats->spillFiles;
+        return spillPrefix + std::to_string(nextSpill++);
+    }
+};
+
+void BucketSort::externalSortSpill(ExternalSortContext& ctx, const std::string& path,
+                                   std::uint64_t count, int minVal, int maxVal, int depth) {
+    ALGO_DEPTH("bucket_sort.external_sort");
+    if (ctx.failed()) {
+        std::remove(path.c_str());
+        return;
+    }
+    ctx.stats->maxDepth = std::max(ctx.stats->maxDepth, depth);
+
+    // Every value is the same: no need to read the spill back at all.
+    if (minVal == maxVal) {
+        auto start = Clock::now();
+        for (std::uint64_t i = 0; i < count; ++i) ctx.output->put(minVal);
+        ctx.sort().seconds += secondsSince(start);
+        std::remove(path.c_str());
+        return;
+    }
+
+    std::FILE* in = std::fopen(path.c_str(), "rb");
+    if (!in) {
+        ctx.fail("failed to open spill file " + path);
+        return;
+    }
+
+    // Fits in the budget: sort it in memory with the regular bucket sort.
+    if (count * kInMemoryBytesPerElement <= ctx.budget) {
+        auto start = Clock::now();
+        std::vector<int>& values = ctx.sorter->numbers;
+        values.resize(static_cast<std::size_t>(count));
+        std::size_t got = std::fread(values.data(), sizeof(int), values.size(), in);
+        std::fclose(in);
+        std::remove(path.c_str());
+        ctx.sort().bytesRead += got * sizeof(int);
+        if (got != values.size()) {
+            ctx.sorter->clearNumbers();
+            ctx.fail("short read from spill file " + path);
+            return;
+        }
+
+        ctx.sorter->sortedCount = 0;
+        ctx.sorter->bucketSort();
+        for (int num : values) ctx.output->put(num);
+        ctx.sorter->clearNumbers();
+        ctx.sort().seconds += secondsSince(start);
+        return;
+    }
+
+    // Too big: split the value range into fanout sub-buckets and recurse.
+    auto start = Clock::now();
+    std::size_t needed = static_cast<std::size_t>(count * kInMemoryBytesPerElement / ctx.budget) + 1;
+    std::size_t maxFanout = std::max<std::size_t>(2, (ctx.budget / 2) / kMinSpillBufferBytes);
+    std::size_t fanout = std::min<std::size_t>({ needed * 2, maxFanout, 1024 });
+    fanout = std::max<std::size_t>(2, fanout);
+    std::size_t spillBufferInts = (ctx.budget / 2) / fanout / sizeof(int);
+
+    std::vector<SpillWriter> spills(fanout);
+    std::vector<std::string> spillPaths(fanout);
+    for (std::size_t b = 0; b < fanout; ++b) {
+        spillPaths[b] = ctx.nextSpillPath();
+        if (!spills[b].open(spillPaths[b], spillBufferInts)) {
+            ctx.fail("failed to create spill file " + spillPaths[b]);
+            std::fclose(in);
+            std::remove(path.c_str());
+            for (std::size_t k = 0; k <= b; ++k) {
+                spills[k].close();
+                std::remove(spillPaths[k].c_str());
+            }
+            return;
+        }
+    }
+
+    std::uint64_t range = static_cast<std::uint64_t>(static_cast<std::int64_t>(maxVal) - minVal) + 1;
+    std::vector<int> chunk(std::max<std::size_t>(1, (ctx.budget / 4) / sizeof(int)));
+    std::size_t got;
+    while ((got = std::fread(chunk.data(), sizeof(int), chunk.size(), in)) > 0) {
+        ctx.partition().bytesRead += got * sizeof(int);
+        for (std::size_t i = 0; i < got; ++i) {
+            std::uint64_t offset = static_cast<std::uint64_t>(static_cast<std::int64_t>(chunk[i]) - minVal);
+            spills[static_cast<std::size_t>(offset * fanout / range)].put(chunk[i]);
+        }
+    }
+    std::fclose(in);
+    std::remove(path.c_str());
+    std::vector<int>().swap(chunk);
+
+    std::uint64_t partitioned = 0;
+    for (std::size_t b = 0; b < fanout; ++b) {
+        ctx.partition().bytesWritten += spills[b].close();
+        partitioned += spills[b].count;
+        if (spills[b].hasFailed()) ctx.fail("failed to write spill file " + spillPaths[b]);
+    }
+    if (partitioned != count) ctx.fail("short read from spill file " + path);
+    ctx.partition().seconds += secondsSince(start);
+
+    for (std::size_t b = 0; b < fanout; ++b) {
+        if (spills[b].count == 0 || ctx.failed()) {
+            std::remove(spillPaths[b].c_str());
+            continue;
+        }
+        externalSortSpill(ctx, spillPaths[b], spills[b].count, spills[b].minVal, spills[b].maxVal, depth + 1);
+    }
+}
+
+ExternalSortStats BucketSort::externalSort(const std::string& inputFile,
+                                           const std::string& outputFile,
+                                           std::size_t memoryBudgetBytes,
+                                           const std::string& tempDir) {
+    ALGO_SPAN("bucket_sort.external_sort");
+    ExternalSortStats stats;
+    stats.phases.resize(3);
+    stats.phases[0].name = "scan";
+    stats.phases[1].name = "partition";
+    stats.phases[2].name = "sort";
+
+    std::FILE* in = std::fopen(inputFile.c_str(), "rb");
+    if (!in) {
+        stats.error = "failed to open " + inputFile;
+        return stats;
+    }
+    std::FILE* out = std::fopen(outputFile.c_str(), "wb");
+    if (!out) {
+        stats.error = "failed to open " + outputFile + " for writing";
+        std::fclose(in);
+        return stats;
+    }
+
+    ExternalSortContext ctx;
+    ctx.budget = std::max(memoryBudgetBytes, kMinMemoryBudget);
+    ctx.spillPrefix = tempDir.empty() ? outputFile + ".spill."
+                                      : tempDir + "/bucket_sort.spill.";
+    ctx.stats = &stats;
+    // A private sorter keeps this one's numbers intact, and the bucket
+    // strategy keeps in-memory sorts within kInMemoryBytesPerElement: the
+    // counting table or the radix buffer could exceed the budget.
+    BucketSort sorter(resource);
+    sorter.setStrategy(SortStrategy::Bucket);
+    ctx.sorter = &sorter;
+
+    // Scan: parse the text once, converting it into a binary run file and
+    // collecting the value range for the partition pass.
+    auto start = Clock::now();
+    std::string runPath = ctx.nextSpillPath();
+    SpillWriter run;
+    if (!run.open(runPath, (ctx.budget / 4) / sizeof(int))) {
+        stats.error = "failed to create spill file " + runPath;
+        std::fclose(in);
+        std::fclose(out);
+        return stats;
+    }
+    {
+        TextIntReader reader(in, std::min(kTextBufferBytes, ctx.budget / 4));
+        int value;
+        while (reader.next(value)) run.put(value);
+        stats.phases[0].bytesRead = reader.bytesRead();
+        stats.malformed = reader.malformed();
+    }
+    std::fclose(in);
+    stats.phases[0].bytesWritten = run.close();
+    stats.phases[0].seconds = secondsSince(start);
+    stats.elements = run.count;
+    if (run.hasFailed()) ctx.fail("failed to write spill file " + runPath);
+
+    // The output buffer stays alive through the whole recursion, so the
+    // spill and in-memory decisions only get what is left of the budget.
+    std::size_t writerBytes = std::min(kTextBufferBytes, ctx.budget / 4);
+    TextIntWriter writer(out, writerBytes);
+    ctx.output = &writer;
+    ctx.budget -= writerBytes;
+    if (run.count > 0 && !ctx.failed()) {
+        externalSortSpill(ctx, runPath, run.count, run.minVal, run.maxVal, 0);
+    } else {
+        std::remove(runPath.c_str());
+    }
+
+    start = Clock::now();
+    writer.flush();
+    if (writer.hasFailed()) ctx.fail("failed to write " + outputFile);
+    if (std::fclose(out) != 0) ctx.fail("failed to close " + outputFile);
+    stats.phases[2].seconds += secondsSince(start);
+    stats.phases[2].bytesWritten = writer.bytesWritten();
+    stats.ok = !ctx.failed();
+    return stats;
+}
+
+void ExternalSortStats::print(std::ostream& os) const {
+    os << "External sort of " << elements << " numbers ("
+       << spillFiles << " spill files, max depth " << maxDepth << ")" << std::endl;
+    if (malformed != 0) os << "  malformed input skipped: " << malformed << std::endl;
+    for (const auto& phase : phases) {
+        os << "  " << phase.name << ": " << phase.seconds * 1000.0 << " ms, read "
+           << phase.bytesRead << " bytes, wrote " << phase.bytesWritten << " bytes" << std::endl;
+    }
 }
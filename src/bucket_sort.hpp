@@ -3,24 +3,152 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
+#include <cstdint>
+#include <iostream>
+#include <memory_resource>
+
+// I/O volume and wall time of one externalSort phase.
+struct ExternalSortPhase {
+    std::string name;
+    double seconds = 0.0;
+    std::uint64_t bytesRead = 0;
+    std::uint64_t bytesWritten = 0;
+};
+
+struct ExternalSortStats {
+    std::vector<ExternalSortPhase> phases; // scan, partition, sort
+    std::uint64_t elements = 0;
+    std::uint64_t malformed = 0;           // input tokens skipped: not an int, or out of range
+    std::uint64_t spillFiles = 0;
+    int maxDepth = 0;                      // deepest re-partition level
+    bool ok = false;                       // every read, write and close succeeded
+    std::string error;                     // first failure when !ok
+
+    void print(std::ostream& os) const;
+};
+
+// How bucketSort orders the numbers. Auto picks from the value range it
+// already computes: counting sort when the range is a small multiple of n
+// (and its count table at most 256 MB), LSD radix for mid-range ints, and
+// the classic bucket sort otherwise.
+// InPlace (American flag sort) is never picked automatically; it trades some
+// speed for using no memory beyond a 256-entry table per digit level.
+enum class SortStrategy {
+    Auto,
+    Bucket,
+    Counting,
+    Radix,
+    InPlace
+};
+
+const char* sortStrategyName(SortStrategy strategy);
 
 class BucketSort {
 public:
+    // Scratch storage of the sorts (buckets, histograms, radix and rank
+    // buffers) comes from resource, e.g. an ArenaResource that a whole
+    // request shares. The numbers stay in a std::vector, which getNumbers()
+    // hands out.
+    explicit BucketSort(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : resource(resource) {}
+
     void loadFromFile(const std::string& filename);
+    // Sorts the numbers. The sorter remembers how much of the vector is
+    // already sorted: numbers appended since the last call are sorted on
+    // their own and galloping-merged into the sorted prefix, and a call with
+    // nothing new returns immediately.
     void bucketSort();
-    void printNumbers() const;
-    void benchmark(int iterations = 1000);
+    void printNumbers(std::ostream& out = std::cout) const;
+    void benchmark(int iterations = 1000, std::ostream& out = std::cout);
 
+    // Out-of-core sort of a whitespace separated integer file. The input is
+    // streamed, partitioned by value into binary bucket spill files, and each
+    // bucket is sorted in memory once it fits in memoryBudgetBytes (or
+    // re-partitioned when it does not). The budget covers the output
+    // buffer too, which is held for the whole sort. The output is one
+    // number per line.
+    // Tokens that are not integers or do not fit an int are skipped and
+    // counted in stats.malformed.
+    // Spill files go next to outputFile unless tempDir is given. The sorter's
+    // own numbers are left untouched. If any file cannot be opened, read or
+    // written, stats.ok is false, stats.error says why and the output is
+    // incomplete.
+    ExternalSortStats externalSort(const std::string& inputFile,
+                                   const std::string& outputFile,
+                                   std::size_t memoryBudgetBytes,
+                                   const std::string& tempDir = "");
 
-    std::vector<int>& getNumbers() { return numbers; }
+
+    // Rank queries that only sort the buckets holding the requested ranks.
+    // The first query buckets the numbers once (reordering them, but leaving
+    // every bucket unsorted); later queries reuse that bucketing until the
+    // numbers change. Ranks are 0-based over the ascending order.
+    int nthElement(std::size_t k);
+    std::vector<int> topK(std::size_t k);                            // largest first
+    std::vector<int> percentiles(const std::vector<double>& ps);     // nearest-rank, ps in [0, 100]
+
+    void setMemoryResource(std::pmr::memory_resource* r) { resource = r; }
+    std::pmr::memory_resource* getMemoryResource() const { return resource; }
+
+    void setStrategy(SortStrategy s) { strategy = s; }
+    SortStrategy getStrategy() const { return strategy; }
+    // Strategy the last bucketSort() call actually ran (Auto if nothing needed sorting).
+    SortStrategy getLastStrategy() const { return lastStrategy; }
+
+    // String mode: MSD radix sort over an 8-byte prefix cache. Each level
+    // buckets on the cached bytes, recurses into shared-prefix buckets with
+    // the next 8 bytes, and small buckets fall back to a comparison sort on
+    // the remaining tails. stringSortOrder returns the permutation without
+    // touching the strings; sortStrings then moves each string exactly once.
+    // The string_view overload sorts keys held in any string type.
+    static std::vector<std::size_t> stringSortOrder(const std::vector<std::string_view>& keys);
+    static std::vector<std::size_t> stringSortOrder(const std::vector<const std::string*>& keys);
+    static void sortStrings(std::vector<std::string>& keys);
+
+    // Mutable access may reorder anything, so it drops the sorted state.
+    std::vector<int>& getNumbers() { sortedCount = 0; rankIndexValid = false; return numbers; }
     const std::vector<int>& getNumbers() const { return numbers; }
-    void clearNumbers() { numbers.clear(); }
-    void addNumber(int num) { numbers.push_back(num); }
+    void clearNumbers() { numbers.clear(); sortedCount = 0; rankIndexValid = false; }
+    void addNumber(int num) { numbers.push_back(num); rankIndexValid = false; }
+    void addNumbers(const std::vector<int>& batch) {
+        numbers.insert(numbers.end(), batch.begin(), batch.end());
+        rankIndexValid = false;
+    }
     size_t getNumberCount() const { return numbers.size(); }
+    bool isSorted() const { return sortedCount == numbers.size(); }
 
 private:
+    struct ExternalSortContext;
+
     std::vector<int> numbers;
-    void insertionSort(std::vector<int>& bucket);
+    std::pmr::memory_resource* resource; // scratch buffers of the sorts
+    std::size_t sortedCount = 0; // numbers[0, sortedCount) is known to be sorted
+    SortStrategy strategy = SortStrategy::Auto;
+    SortStrategy lastStrategy = SortStrategy::Auto;
+
+    // Bucketing shared by the rank queries: bucket b is
+    // numbers[rankBucketStart[b], rankBucketStart[b + 1]).
+    std::vector<std::size_t> rankBucketStart;
+    std::vector<char> rankBucketSorted;
+    std::size_t rankBucketsLeft = 0; // buckets not sorted yet
+    bool rankIndexValid = false;
+
+    SortStrategy chooseStrategy(std::uint64_t range) const;
+    void sortAll();
+    void mergeSortedBatch(const std::vector<int>& batch);
+    void insertionSort(std::pmr::vector<int>& bucket);
+    void insertionSort(int* first, int* last);
+    bool prepareRanks();
+    void sortRankBucket(std::size_t bucket);
+    void sortRanks(std::size_t firstRank, std::size_t lastRank);
+    void classicBucketSort(int minVal, int maxVal);
+    void countingSort(int minVal, int maxVal);
+    void radixSort(int minVal, int maxVal);
+    void americanFlagSort(int minVal, int maxVal);
+    void americanFlagSort(int* first, int* last, std::uint32_t minVal, int shift);
+    void externalSortSpill(ExternalSortContext& ctx, const std::string& path,
+                           std::uint64_t count, int minVal, int maxVal, int depth);
 };
 
 #endif
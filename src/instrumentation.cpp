@@ -0,0 +1,301 @@
+/**
+ * @file instrumentation.cpp
+ * @brief Per-thread recording and the trace/metrics exporters
+ */
+
+#include "instrumentation.hpp"
+#include "alloc_stats.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// The recorder's own storage comes straight from malloc, so it never shows up
+// in the heap counters or in the allocation counts of the spans it records.
+template <typename T>
+struct UncountedAllocator {
+    using value_type = T;
+
+    UncountedAllocator() = default;
+    template <typename U>
+    UncountedAllocator(const UncountedAllocator<U>&) {}
+
+    T* allocate(std::size_t n) {
+        void* p = std::malloc(n * sizeof(T));
+        if (!p) throw std::bad_alloc();
+        return static_cast<T*>(p);
+    }
+    void deallocate(T* p, std::size_t) { std::free(p); }
+
+    template <typename U>
+    bool operator==(const UncountedAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const UncountedAllocator<U>&) const { return false; }
+};
+
+template <typename V>
+using UncountedMap = std::unordered_map<const char*, V, std::hash<const char*>, std::equal_to<const char*>,
+                                        UncountedAllocator<std::pair<const char* const, V>>>;
+
+struct SpanEvent {
+    const char* name;
+    std::uint64_t startNs;
+    std::uint64_t durationNs;
+    std::uint64_t allocations;
+};
+
+// Bucket k holds values of bit width k: 0, 1, 2-3, 4-7, ...
+struct Histogram {
+    std::array<std::uint64_t, 65> buckets{};
+    std::uint64_t sum = 0;
+    std::uint64_t count = 0;
+};
+
+struct Depth {
+    std::int64_t current = 0;
+    std::int64_t max = 0;
+};
+
+// Names are string literals, so the per-thread maps key on the pointer;
+// the exporters merge equal names that live at different addresses.
+struct ThreadLog {
+    unsigned id = 0;
+    std::vector<SpanEvent, UncountedAllocator<SpanEvent>> spans;
+    std::uint64_t dropped = 0;
+    UncountedMap<std::int64_t> counters;
+    UncountedMap<Histogram> histograms;
+    UncountedMap<Depth> depths;
+};
+
+std::mutex gRegistryMutex;
+using Registry = std::vector<std::shared_ptr<ThreadLog>, UncountedAllocator<std::shared_ptr<ThreadLog>>>;
+
+Registry& registry() {
+    static Registry logs;  // outlive their threads
+    return logs;
+}
+
+ThreadLog& threadLog() {
+    thread_local std::shared_ptr<ThreadLog> log = [] {
+        auto created = std::allocate_shared<ThreadLog>(UncountedAllocator<ThreadLog>());
+        std::lock_guard<std::mutex> lock(gRegistryMutex);
+        created->id = static_cast<unsigned>(registry().size());
+        registry().push_back(created);
+        return created;
+    }();
+    return *log;
+}
+
+std::uint64_t nowNs() {
+    static const auto epoch = std::chrono::steady_clock::now();
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count());
+}
+
+unsigned bitWidth(std::uint64_t value) {
+    unsigned width = 0;
+    while (value != 0) {
+        ++width;
+        value >>= 1;
+    }
+    return width;
+}
+
+void writeJsonString(std::ostream& out, const std::string& text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') out << '\\';
+        out << c;
+    }
+    out << '"';
+}
+
+// Nanoseconds as fixed-point microseconds ("1500163.250"): the stream's
+// default 6 significant digits would round away milliseconds in long runs.
+void writeMicros(std::ostream& out, std::uint64_t ns) {
+    const char fraction[] = { '.', char('0' + ns / 100 % 10), char('0' + ns / 10 % 10), char('0' + ns % 10), '\0' };
+    out << ns / 1000 << fraction;
+}
+
+} // namespace
+
+Instrumentation::Span::Span(const char* name)
+    : name_(name), startNs_(nowNs()), startAllocations_(threadAllocationCount()) {}
+
+Instrumentation::Span::~Span() {
+    std::uint64_t end = nowNs();
+    ThreadLog& log = threadLog();
+    if (log.spans.size() >= kMaxSpansPerThread) {
+        ++log.dropped;
+        return;
+    }
+    log.spans.push_back({ name_, startNs_, end - startNs_, threadAllocationCount() - startAllocations_ });
+}
+
+Instrumentation::DepthScope::DepthScope(const char* name) {
+    Depth& depth = threadLog().depths[name];
+    current_ = &depth.current;
+    if (++depth.current > depth.max) {
+        depth.max = depth.current;
+    }
+}
+
+Instrumentation::DepthScope::~DepthScope() {
+    --*current_;
+}
+
+void Instrumentation::addCount(const char* name, std::int64_t delta) {
+    threadLog().counters[name] += delta;
+}
+
+void Instrumentation::recordValue(const char* name, std::uint64_t value) {
+    Histogram& histogram = threadLog().histograms[name];
+    ++histogram.buckets[bitWidth(value)];
+    histogram.sum += value;
+    ++histogram.count;
+}
+
+void Instrumentation::reset() {
+    std::lock_guard<std::mutex> lock(gRegistryMutex);
+    for (auto& log : registry()) {
+        log->spans.clear();
+        log->dropped = 0;
+        log->counters.clear();
+        log->histograms.clear();
+        log->depths.clear();
+    }
+}
+
+std::uint64_t Instrumentation::droppedSpans() {
+    std::lock_guard<std::mutex> lock(gRegistryMutex);
+    std::uint64_t dropped = 0;
+    for (auto& log : registry()) {
+        dropped += log->dropped;
+    }
+    return dropped;
+}
+
+void Instrumentation::writeChromeTrace(std::ostream& out) {
+    std::lock_guard<std::mutex> lock(gRegistryMutex);
+    out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+    const char* separator = "\n  ";
+    for (auto& log : registry()) {
+        std::uint64_t lastNs = 0;
+        for (const SpanEvent& span : log->spans) {
+            out << separator << "{\"name\": ";
+            writeJsonString(out, span.name);
+            out << ", \"cat\": \"algo\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << log->id
+                << ", \"ts\": ";
+            writeMicros(out, span.startNs);
+            out << ", \"dur\": ";
+            writeMicros(out, span.durationNs);
+            out << ", \"args\": {\"allocations\": " << span.allocations << "}}";
+            separator = ",\n  ";
+            lastNs = std::max(lastNs, span.startNs + span.durationNs);
+        }
+        if (!log->counters.empty()) {
+            out << separator << "{\"name\": \"counters\", \"ph\": \"C\", \"pid\": 1, \"tid\": " << log->id
+                << ", \"ts\": ";
+            writeMicros(out, lastNs);
+            out << ", \"args\": {";
+            const char* comma = "";
+            for (const auto& counter : log->counters) {
+                out << comma;
+                writeJsonString(out, counter.first);
+                out << ": " << counter.second;
+                comma = ", ";
+            }
+            out << "}}";
+            separator = ",\n  ";
+        }
+    }
+    out << "\n]}\n";
+}
+
+void Instrumentation::writePrometheus(std::ostream& out) {
+    struct SpanTotal {
+        std::uint64_t count = 0;
+        std::uint64_t ns = 0;
+        std::uint64_t allocations = 0;
+    };
+    std::map<std::string, std::int64_t> counters;
+    std::map<std::string, SpanTotal> spans;
+    std::map<std::string, std::int64_t> depths;
+    std::map<std::string, Histogram> histograms;
+    {
+        std::lock_guard<std::mutex> lock(gRegistryMutex);
+        for (auto& log : registry()) {
+            for (const auto& counter : log->counters) counters[counter.first] += counter.second;
+            for (const SpanEvent& span : log->spans) {
+                SpanTotal& total = spans[span.name];
+                ++total.count;
+                total.ns += span.durationNs;
+                total.allocations += span.allocations;
+            }
+            for (const auto& depth : log->depths) {
+                depths[depth.first] = std::max(depths[depth.first], depth.second.max);
+            }
+            for (const auto& entry : log->histograms) {
+                Histogram& merged = histograms[entry.first];
+                for (size_t k = 0; k < merged.buckets.size(); ++k) merged.buckets[k] += entry.second.buckets[k];
+                merged.sum += entry.second.sum;
+                merged.count += entry.second.count;
+            }
+        }
+    }
+
+    out << "# HELP algo_counter Event counts recorded by the algorithms\n# TYPE algo_counter counter\n";
+    for (const auto& counter : counters) {
+        out << "algo_counter{name=\"" << counter.first << "\"} " << counter.second << "\n";
+    }
+    out << "# HELP algo_span_seconds Time spent inside instrumented spans\n# TYPE algo_span_seconds summary\n";
+    for (const auto& span : spans) {
+        out << "algo_span_seconds_sum{name=\"" << span.first << "\"} " << span.second.ns / 1e9 << "\n";
+        out << "algo_span_seconds_count{name=\"" << span.first << "\"} " << span.second.count << "\n";
+    }
+    out << "# HELP algo_span_allocations Heap allocations made inside instrumented spans\n# TYPE algo_span_allocations counter\n";
+    for (const auto& span : spans) {
+        out << "algo_span_allocations{name=\"" << span.first << "\"} " << span.second.allocations << "\n";
+    }
+    out << "# HELP algo_recursion_depth_max Deepest recursion reached\n# TYPE algo_recursion_depth_max gauge\n";
+    for (const auto& depth : depths) {
+        out << "algo_recursion_depth_max{name=\"" << depth.first << "\"} " << depth.second << "\n";
+    }
+    out << "# HELP algo_histogram Distributions recorded by the algorithms\n# TYPE algo_histogram histogram\n";
+    for (const auto& entry : histograms) {
+        const Histogram& histogram = entry.second;
+        size_t last = histogram.buckets.size();
+        while (last > 1 && histogram.buckets[last - 1] == 0) --last;
+        std::uint64_t cumulative = 0;
+        for (size_t k = 0; k < last; ++k) {
+            cumulative += histogram.buckets[k];
+            // Bucket k ends at 2^k - 1.
+            std::uint64_t upper = k == 0 ? 0 : (k >= 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << k) - 1);
+            out << "algo_histogram_bucket{name=\"" << entry.first << "\",le=\"" << upper << "\"} " << cumulative << "\n";
+        }
+        out << "algo_histogram_bucket{name=\"" << entry.first << "\",le=\"+Inf\"} " << histogram.count << "\n";
+        out << "algo_histogram_sum{name=\"" << entry.first << "\"} " << histogram.sum << "\n";
+        out << "algo_histogram_count{name=\"" << entry.first << "\"} " << histogram.count << "\n";
+    }
+}
+
+bool Instrumentation::exportFiles(const std::string& tracePath, const std::string& metricsPath) {
+    std::ofstream trace(tracePath);
+    std::ofstream metrics(metricsPath);
+    if (!trace.is_open() || !metrics.is_open()) {
+        return false;
+    }
+    writeChromeTrace(trace);
+    writePrometheus(metrics);
+    return static_cast<bool>(trace) && static_cast<bool>(metrics);
+}
@@ -0,0 +1,141 @@
+/**
+ * @file instrumentation.hpp
+ * @brief Compile-time switchable spans, counters and histograms
+ *
+ * @section description Description
+ * The algorithms mark their entry points with the macros below. Building
+ * with -DALGO_INSTRUMENTATION=ON (CMake) records, per thread:
+ * - timed spans, each with the allocations its thread made inside it,
+ * - counters (probes, recursive calls, strategies picked, cache hits),
+ * - log2 histograms (bucket occupancy, probes per search),
+ * - the deepest recursion reached per recursive algorithm.
+ * Without the option every macro expands to ((void)0) and its arguments
+ * are not evaluated, so instrumented code compiles to exactly what it was.
+ *
+ * The recordings can be written as Chrome trace JSON (chrome://tracing or
+ * ui.perfetto.dev) and as Prometheus text exposition. Each thread writes
+ * only its own log; export and reset() must run while no instrumented
+ * work is in flight.
+ *
+ * @section usage Usage
+ * void BucketSort::bucketSort() {
+ *     ALGO_SPAN("bucket_sort");
+ *     ALGO_COUNT("bucket_sort.numbers", numbers.size());
+ *     ...
+ * }
+ * Instrumentation::exportFiles("trace.json", "metrics.prom");
+ */
+
+#ifndef INSTRUMENTATION_HPP
+#define INSTRUMENTATION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+#ifndef ALGO_INSTRUMENTATION
+#define ALGO_INSTRUMENTATION 0
+#endif
+
+/**
+ * @class Instrumentation
+ * @brief Per-thread recorder behind the ALGO_* macros, plus the exporters
+ */
+class Instrumentation {
+public:
+    static constexpr bool kEnabled = ALGO_INSTRUMENTATION != 0;  ///< Built with the macros active
+    static constexpr std::size_t kMaxSpansPerThread = 1 << 20;   ///< Later spans are counted, not kept
+
+    /**
+     * @class Span
+     * @brief Records its own lifetime as one complete trace event
+     */
+    class Span {
+    public:
+        explicit Span(const char* name);
+        ~Span();
+
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+    private:
+        const char* name_;               ///< Static name of the span
+        std::uint64_t startNs_;          ///< Start, relative to the trace epoch
+        std::uint64_t startAllocations_; ///< Thread allocations at the start
+    };
+
+    /**
+     * @class DepthScope
+     * @brief Tracks the current and deepest nesting of a recursive function
+     */
+    class DepthScope {
+    public:
+        explicit DepthScope(const char* name);
+        ~DepthScope();
+
+        DepthScope(const DepthScope&) = delete;
+        DepthScope& operator=(const DepthScope&) = delete;
+
+    private:
+        std::int64_t* current_;  ///< Depth counter of this thread
+    };
+
+    /**
+     * @brief Adds delta to a counter of the calling thread
+     */
+    static void addCount(const char* name, std::int64_t delta);
+
+    /**
+     * @brief Adds one observation to a log2-bucketed histogram
+     */
+    static void recordValue(const char* name, std::uint64_t value);
+
+    /**
+     * @brief Writes every thread's spans as Chrome trace events
+     *
+     * @details
+     * Spans become complete ("X") events with their allocation count in
+     * args; each thread's final counters follow as one counter ("C")
+     * event, so Perfetto shows them next to the thread's track.
+     */
+    static void writeChromeTrace(std::ostream& out);
+
+    /**
+     * @brief Writes counters, span totals, recursion depths and histograms,
+     *        summed over threads, in Prometheus text format
+     */
+    static void writePrometheus(std::ostream& out);
+
+    /**
+     * @brief Writes both exports to local files
+     * @return false if either file could not be written
+     */
+    static bool exportFiles(const std::string& tracePath, const std::string& metricsPath);
+
+    /**
+     * @brief Drops everything recorded so far (threads keep their ids)
+     */
+    static void reset();
+
+    /**
+     * @brief Spans not kept because a thread hit kMaxSpansPerThread
+     */
+    static std::uint64_t droppedSpans();
+};
+
+#if ALGO_INSTRUMENTATION
+#define ALGO_CONCAT_(a, b) a##b
+#define ALGO_CONCAT(a, b) ALGO_CONCAT_(a, b)
+#define ALGO_SPAN(name) Instrumentation::Span ALGO_CONCAT(algoSpan_, __LINE__)(name)
+#define ALGO_DEPTH(name) Instrumentation::DepthScope ALGO_CONCAT(algoDepth_, __LINE__)(name)
+#define ALGO_COUNT(name, delta) Instrumentation::addCount(name, static_cast<std::int64_t>(delta))
+#define ALGO_HISTOGRAM(name, value) Instrumentation::recordValue(name, static_cast<std::uint64_t>(value))
+#else
+#define ALGO_SPAN(name) ((void)0)
+#define ALGO_DEPTH(name) ((void)0)
+#define ALGO_COUNT(name, delta) ((void)0)
+#define ALGO_HISTOGRAM(name, value) ((void)0)
+#endif
+
+#endif
@@ -1,8 +1,12 @@
-﻿#include <iostream>
+﻿#include <algorithm>
+#include <iostream>
+#include <fstream>
 #include <string>
 #include "algo.hpp"
 #include "bucket_sort.hpp"
 #include "transport.hpp"
+#include "instrumentation.hpp"
+#include "query_server.hpp"
 //file path to the txt files.
 std::string random_station_file = "../../src/randomStations.txt";
 std::string thousand_numbers_file = "../../src/thousand.txt";
@@ -15,15 +19,149 @@ std::string thousand_NonUniform_file = "../../src/thousand_nonUniform.txt";
 //ten thousand entries.
 std::string ten_thousand_Uniform_file = "../../src/ten_thousand_uniform.txt";
 std::string ten_thousand_NonUniform_file = "../../src/ten_thousand_nonUniform.txt";
-int main() {
+
+//usage of the streaming mode (main serve ...).
+static int serveUsage() {
+    std::cerr << "usage: main serve [--stations FILE | --snapshot FILE] [--sort] [--binary] [--input FILE]\n"
+              << "                  [--output FILE] [--batch N] [--queue N]\n"
+              << "  lookup mode (default) answers station IDs against --stations;\n"
+              << "  --sort sorts one job per line instead. Input and output default to stdin/stdout,\n"
+              << "  the summary goes to stderr." << std::endl;
+    return 2;
+}
+
+//loads the stations once, then serves batches from the input until it ends.
+static int runServe(int argc, char** argv) {
+    ServeOptions options;
+    std::string stationsFile, snapshotFile, inputFile, outputFile;
+    try {
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--sort") options.mode = ServeMode::Sort;
+            else if (arg == "--binary") options.format = ServeFormat::Binary;
+            else if (arg == "--stations" && hasValue) stationsFile = argv[++i];
+            else if (arg == "--snapshot" && hasValue) snapshotFile = argv[++i];
+            else if (arg == "--input" && hasValue) inputFile = argv[++i];
+            else if (arg == "--output" && hasValue) outputFile = argv[++i];
+            else if (arg == "--batch" && hasValue) options.batchSize = std::stoul(argv[++i]);
+            else if (arg == "--queue" && hasValue) options.queueDepth = std::stoul(argv[++i]);
+            else return serveUsage();
+        }
+    } catch (const std::exception&) {
+        return serveUsage();
+    }
+
     Algo algo;
-    int targetID = 0;
+    if (options.mode == ServeMode::Lookup) {
+        if (stationsFile.empty() == snapshotFile.empty()) return serveUsage();
+        bool loaded = snapshotFile.empty() ? algo.loadStations(stationsFile) : algo.loadStationSnapshot(snapshotFile);
+        if (!loaded) {
+            std::cerr << "Failed to load stations from " << (snapshotFile.empty() ? stationsFile : snapshotFile) << std::endl;
+            return 1;
+        }
+    }
+
+    std::ios::sync_with_stdio(false);
+    std::ifstream inputStream;
+    std::ofstream outputStream;
+    if (!inputFile.empty()) {
+        inputStream.open(inputFile, std::ios::binary);
+        if (!inputStream.is_open()) {
+            std::cerr << "Failed to open file: " << inputFile << std::endl;
+            return 1;
+        }
+    }
+    if (!outputFile.empty()) {
+        outputStream.open(outputFile, std::ios::binary);
+        if (!outputStream.is_open()) {
+            std::cerr << "Failed to open file for writing: " << outputFile << std::endl;
+            return 1;
+        }
+    }
+
+    try {
+        QueryServer server(&algo, options);
+        ServeStats stats = server.run(inputFile.empty() ? std::cin : inputStream,
+                                      outputFile.empty() ? std::cout : outputStream);
+        stats.print(std::cerr);
+    } catch (const std::exception& e) {
+        std::cerr << "serve failed: " << e.what() << std::endl;
+        return 1;
+    }
+    if (Instrumentation::kEnabled) {
+        Instrumentation::exportFiles("algo_trace.json", "algo_metrics.prom");
+    }
+    return 0;
+}
+
+//usage of the dataset generator (main generate ...).
+static int generateUsage() {
+    std::cerr << "usage: main generate --output FILE [--count N] [--gaps uniform|bursty|pareto|clustered]\n"
+              << "                     [--mean-gap N] [--alpha A] [--snapshot] [--seed N] [--threads N]" << std::endl;
+    return 2;
+}
+
+//writes a station file with StationGenerator and reports how fast it went.
+static int runGenerate(int argc, char** argv) {
+    StationGeneratorOptions options;
+    std::string outputFile;
+    try {
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--snapshot") options.format = StationFileFormat::Snapshot;
+            else if (arg == "--output" && hasValue) outputFile = argv[++i];
+            else if (arg == "--count" && hasValue) options.count = std::stoull(argv[++i]);
+            else if (arg == "--mean-gap" && hasValue) options.meanGap = static_cast<std::uint32_t>(std::stoul(argv[++i]));
+            else if (arg == "--alpha" && hasValue) options.paretoAlpha = std::stod(argv[++i]);
+            else if (arg == "--seed" && hasValue) options.seed = std::stoull(argv[++i]);
+            else if (arg == "--threads" && hasValue) options.threads = static_cast<unsigned>(std::stoul(argv[++i]));
+            else if (arg == "--gaps" && hasValue) {
+                std::string gaps = argv[++i];
+                if (gaps == "uniform") options.gaps = GapDistribution::Uniform;
+                else if (gaps == "bursty") options.gaps = GapDistribution::Bursty;
+                else if (gaps == "pareto") options.gaps = GapDistribution::Pareto;
+                else if (gaps == "clustered") options.gaps = GapDistribution::Clustered;
+                else return generateUsage();
+            }
+            else return generateUsage();
+        }
+    } catch (const std::exception&) {
+        return generateUsage();
+    }
+    if (outputFile.empty()) return generateUsage();
+
+    try {
+        StationGeneratorStats stats = StationGenerator::generate(outputFile, options);
+        std::cerr << "Generated " << stats.stations << " stations (last id " << stats.lastId << ", "
+                  << stats.bytesWritten << " bytes) in " << stats.seconds << " s ("
+                  << stats.stations / std::max(stats.seconds, 1e-9) << " stations/s)" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "generate failed: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string(argv[1]) == "serve") {
+        return runServe(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "generate") {
+        return runGenerate(argc, argv);
+    }
+
+    Algo algo;
+    int64_t targetID = 0;
     // ===== INTERPOLATION SEARCH TESTING =====
     std::cout << "\n\n1. INTERPOLATION SEARCH TESTING" << std::endl;
     std::cout << "======================" << std::endl;
 
     //Test for 100 sequential entries
-    algo.loadStations(hundred_Uniform_file);
+    if (!algo.loadStations(hundred_Uniform_file)) {
+        std::cerr << "Failed to open file: " << hundred_Uniform_file << std::endl;
+    }
     // Set a random faulty station
     targetID = algo.pickTargetFromStations();
     std::cout << "Benchmarking Interpolation Search for target ID: " << targetID << std::endl;
@@ -31,7 +169,9 @@ int main() {
     algo.clearStations();
 
     //Test for 100 non-uniform entries
-    algo.loadStations(hundred_NonUniform_file);
+    if (!algo.loadStations(hundred_NonUniform_file)) {
+        std::cerr << "Failed to open file: " << hundred_NonUniform_file << std::endl;
+    }
     // Set a random faulty station
     targetID = algo.pickTargetFromStations();
     std::cout << "Benchmarking Interpolation Search for target ID: " << targetID << std::endl;
@@ -39,7 +179,9 @@ int main() {
     algo.clearStations();
 
     //Test for 1000 non-uniform entries
-    algo.loadStations(thousand_Uniform_file);
+    if (!algo.loadStations(thousand_Uniform_file)) {
+        std::cerr << "Failed to open file: " << thousand_Uniform_file << std::endl;
+    }
     // Set a random faulty station
     targetID = algo.pickTargetFromStations();
     std::cout << "Benchmarking Interpolation Search for target ID: " << targetID << std::endl;
@@ -47,7 +189,9 @@ int main() {
     algo.clearStations();
 
     //Test for 1000 non-uniform entries
-    algo.loadStations(thousand_NonUniform_file);
+    if (!algo.loadStations(thousand_NonUniform_file)) {
+        std::cerr << "Failed to open file: " << thousand_NonUniform_file << std::endl;
+    }
     // Set a random faulty station
     targetID = algo.pickTargetFromStations();
     std::cout << "Benchmarking Interpolation Search for target ID: " << targetID << std::endl;
@@ -55,7 +199,9 @@ int main() {
     algo.clearStations();
 
      //Test for 10000 non-uniform entries
-    algo.loadStations(ten_thousand_Uniform_file);
+    if (!algo.loadStations(ten_thousand_Uniform_file)) {
+        std::cerr << "Failed to open file: " << ten_thousand_Uniform_file << std::endl;
+    }
     // Set a random faulty station
     targetID = algo.pickTargetFromStations();
     std::cout << "Benchmarking Interpolation Search for target ID: " << targetID << std::endl;
@@ -63,15 +209,23 @@ int main() {
     algo.clearStations();
 
      //Test for 10000 non-uniform entries
-    algo.loadStations(ten_thousand_NonUniform_file);
+    if (!algo.loadStations(ten_thousand_NonUniform_file)) {
+        std::cerr << "Failed to open file: " << ten_thousand_NonUniform_file << std::endl;
+    }
     // Set a random faulty station
     targetID = algo.pickTargetFromStations();
     std::cout << "Benchmarking Interpolation Search for target ID: " << targetID << std::endl;
     algo.benchmarkInterpolationSearch(targetID);  
     algo.clearStations();
 
-    //Test for 1000000 non-uniform entries
-    algo.loadStations(random_station_file);
+    //Test for 1000000 non-uniform entries (generated on the first run)
+    if (!std::ifstream(random_station_file).good()) {
+        std::cout << "Generating " << random_station_file << std::endl;
+        algo.generateHighlyNonUniformStations(random_station_file, 1000000);
+    }
+    if (!algo.loadStations(random_station_file)) {
+        std::cerr << "Failed to open file: " << random_station_file << std::endl;
+    }
     // Set a random faulty station
     targetID = algo.pickTargetFromStations();
     std::cout << "Benchmarking Interpolation Search for target ID: " << targetID << std::endl;
@@ -161,7 +315,7 @@ int main() {
         auto network = SingaporeTransportOptimizer::generateNetwork(size);
 
         auto start = std::chrono::high_resolution_clock::now();
-        int result = optimizer.optimizeTransport(network);
+        std::int64_t result = optimizer.optimizeTransport(network);
         auto end = std::chrono::high_resolution_clock::now();
 
         auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
@@ -178,5 +332,13 @@ int main() {
     std::cout << "TRANSPORT NETWORK OPTIMIZATION END" << std::endl;
     std::cout << "==================================" << std::endl;
 
+    if (Instrumentation::kEnabled) {
+        if (Instrumentation::exportFiles("algo_trace.json", "algo_metrics.prom")) {
+            std::cout << "\nInstrumentation written to algo_trace.json and algo_metrics.prom" << std::endl;
+        } else {
+            std::cerr << "Failed to write instrumentation files" << std::endl;
+        }
+    }
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,148 @@
+/**
+ * @file memory_arena.cpp
+ * @brief ArenaResource and SizeClassPool implementation
+ */
+
+#include "memory_arena.hpp"
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+
+// Chunk and slab headers are padded to this, so the first block is aligned
+// like anything operator new returns.
+const std::size_t kHeaderBytes = alignof(std::max_align_t) > 16 ? alignof(std::max_align_t) : 16;
+
+char* alignUp(char* p, std::size_t alignment) {
+    std::uintptr_t address = reinterpret_cast<std::uintptr_t>(p);
+    return p + ((alignment - address % alignment) % alignment);
+}
+
+} // namespace
+
+ArenaResource::ArenaResource(std::size_t initialBytes, std::pmr::memory_resource* upstream)
+    : upstream_(upstream), nextChunkBytes_(std::max<std::size_t>(initialBytes, 2 * kHeaderBytes)) {}
+
+ArenaResource::~ArenaResource() {
+    while (chunks_) {
+        Chunk* next = chunks_->next;
+        upstream_->deallocate(chunks_, chunks_->size, kHeaderBytes);
+        chunks_ = next;
+    }
+}
+
+void ArenaResource::addChunk(std::size_t minBytes) {
+    std::size_t size = std::max(nextChunkBytes_, minBytes + kHeaderBytes);
+    Chunk* chunk = static_cast<Chunk*>(upstream_->allocate(size, kHeaderBytes));
+    chunk->next = chunks_;
+    chunk->size = size;
+    chunks_ = chunk;
+    cursor_ = reinterpret_cast<char*>(chunk) + kHeaderBytes;
+    end_ = reinterpret_cast<char*>(chunk) + size;
+    nextChunkBytes_ = size * 2;
+    reserved_ += size;
+    ++chunkCount_;
+}
+
+void* ArenaResource::do_allocate(std::size_t bytes, std::size_t alignment) {
+    char* p = cursor_ ? alignUp(cursor_, alignment) : nullptr;
+    if (!p || bytes > static_cast<std::size_t>(end_ - p)) {
+        addChunk(bytes + alignment);
+        p = alignUp(cursor_, alignment);
+    }
+    cursor_ = p + bytes;
+    used_ += bytes;
+    ++allocations_;
+    return p;
+}
+
+void ArenaResource::release() {
+    if (chunks_) {
+        // The newest chunk is the largest; everything older goes back.
+        Chunk* keep = chunks_;
+        Chunk* old = keep->next;
+        while (old) {
+            Chunk* next = old->next;
+            reserved_ -= old->size;
+            upstream_->deallocate(old, old->size, kHeaderBytes);
+            old = next;
+        }
+        keep->next = nullptr;
+        cursor_ = reinterpret_cast<char*>(keep) + kHeaderBytes;
+        end_ = reinterpret_cast<char*>(keep) + keep->size;
+        chunkCount_ = 1;
+    }
+    used_ = 0;
+    allocations_ = 0;
+}
+
+SizeClassPool::SizeClassPool(std::pmr::memory_resource* upstream, std::size_t slabBytes)
+    : upstream_(upstream),
+      slabBytes_(std::max(slabBytes, kHeaderBytes + (kMinBlock << (kClasses - 1)))) {}
+
+SizeClassPool::~SizeClassPool() {
+    release();
+}
+
+std::size_t SizeClassPool::classOf(std::size_t bytes) {
+    std::size_t sizeClass = 0;
+    while ((kMinBlock << sizeClass) < bytes) {
+        ++sizeClass;
+    }
+    return sizeClass;
+}
+
+void SizeClassPool::refill(std::size_t sizeClass) {
+    Slab* slab = static_cast<Slab*>(upstream_->allocate(slabBytes_, kHeaderBytes));
+    slab->next = slabs_;
+    slab->size = slabBytes_;
+    slabs_ = slab;
+    ++upstreamAllocations_;
+
+    // Thread the whole slab onto the free list, lowest address first.
+    std::size_t block = kMinBlock << sizeClass;
+    char* first = reinterpret_cast<char*>(slab) + kHeaderBytes;
+    std::size_t count = (slabBytes_ - kHeaderBytes) / block;
+    for (std::size_t k = count; k-- > 0;) {
+        FreeBlock* free = reinterpret_cast<FreeBlock*>(first + k * block);
+        free->next = freeLists_[sizeClass];
+        freeLists_[sizeClass] = free;
+    }
+}
+
+void* SizeClassPool::do_allocate(std::size_t bytes, std::size_t alignment) {
+    ++allocations_;
+    if (bytes > (kMinBlock << (kClasses - 1)) || alignment > kHeaderBytes) {
+        ++upstreamAllocations_;
+        return upstream_->allocate(bytes, alignment);
+    }
+
+    std::size_t sizeClass = classOf(bytes);
+    if (!freeLists_[sizeClass]) {
+        refill(sizeClass);
+    }
+    FreeBlock* block = freeLists_[sizeClass];
+    freeLists_[sizeClass] = block->next;
+    return block;
+}
+
+void SizeClassPool::do_deallocate(void* p, std::size_t bytes, std::size_t alignment) {
+    if (bytes > (kMinBlock << (kClasses - 1)) || alignment > kHeaderBytes) {
+        upstream_->deallocate(p, bytes, alignment);
+        return;
+    }
+
+    std::size_t sizeClass = classOf(bytes);
+    FreeBlock* block = static_cast<FreeBlock*>(p);
+    block->next = freeLists_[sizeClass];
+    freeLists_[sizeClass] = block;
+}
+
+void SizeClassPool::release() {
+    while (slabs_) {
+        Slab* next = slabs_->next;
+        upstream_->deallocate(slabs_, slabs_->size, kHeaderBytes);
+        slabs_ = next;
+    }
+    std::fill(freeLists_, freeLists_ + kClasses, nullptr);
+}
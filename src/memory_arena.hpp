@@ -0,0 +1,143 @@
+/**
+ * @file memory_arena.hpp
+ * @brief Memory resources for request-scoped allocation
+ *
+ * @section description Description
+ * Defines two std::pmr::memory_resource implementations that Algo,
+ * BucketSort and SingaporeTransportOptimizer can allocate their working
+ * storage from instead of the global heap:
+ * - ArenaResource, a monotonic bump allocator. Deallocation is a no-op and
+ *   release() frees everything at once, so a whole request can run out of
+ *   one arena and be torn down without walking its objects.
+ * - SizeClassPool, which recycles freed blocks through per-size free lists.
+ *   Its classes are the powers of two from 16 bytes to 4 KB, which is also
+ *   how std::vector grows, so the buffers a growing bucket abandons are
+ *   reused by the next bucket that reaches that size.
+ * Neither resource is synchronized; give each thread its own.
+ *
+ * @section usage Usage
+ * ArenaResource arena;
+ * BucketSort sorter(&arena);
+ * sorter.bucketSort();
+ * arena.release();
+ */
+
+#ifndef MEMORY_ARENA_HPP
+#define MEMORY_ARENA_HPP
+
+#include <cstddef>
+#include <memory_resource>
+
+/**
+ * @class ArenaResource
+ * @brief Monotonic bump allocator over geometrically growing chunks
+ */
+class ArenaResource : public std::pmr::memory_resource {
+public:
+    /**
+     * @param initialBytes Size of the first chunk; each further chunk doubles
+     * @param upstream Resource the chunks come from
+     */
+    explicit ArenaResource(std::size_t initialBytes = 64 * 1024,
+                           std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+    ~ArenaResource() override;
+
+    ArenaResource(const ArenaResource&) = delete;
+    ArenaResource& operator=(const ArenaResource&) = delete;
+
+    /**
+     * @brief Frees every allocation at once
+     *
+     * @details
+     * The largest chunk is kept and rewound, the others go back upstream.
+     * A workload that repeats with the same footprint therefore settles on
+     * a single chunk, and from then on release() frees one pointer and
+     * allocating touches the upstream resource not at all.
+     */
+    void release();
+
+    std::size_t bytesUsed() const { return used_; }            ///< Bytes handed out since the last release
+    std::size_t bytesReserved() const { return reserved_; }    ///< Bytes held in chunks
+    std::size_t allocationCount() const { return allocations_; }  ///< Allocations since the last release
+    std::size_t chunkCount() const { return chunkCount_; }     ///< Chunks currently held
+
+private:
+    struct Chunk {
+        Chunk* next;       ///< Previously allocated chunk
+        std::size_t size;  ///< Bytes in the chunk, header included
+    };
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void*, std::size_t, std::size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    void addChunk(std::size_t minBytes);
+
+    std::pmr::memory_resource* upstream_;  ///< Source of the chunks
+    Chunk* chunks_ = nullptr;              ///< Newest (largest) chunk first
+    char* cursor_ = nullptr;               ///< Next free byte in the newest chunk
+    char* end_ = nullptr;                  ///< End of the newest chunk
+    std::size_t nextChunkBytes_;           ///< Size of the next chunk to allocate
+    std::size_t used_ = 0;                 ///< See bytesUsed()
+    std::size_t reserved_ = 0;             ///< See bytesReserved()
+    std::size_t allocations_ = 0;          ///< See allocationCount()
+    std::size_t chunkCount_ = 0;           ///< See chunkCount()
+};
+
+/**
+ * @class SizeClassPool
+ * @brief Power-of-two free lists carved from large upstream slabs
+ */
+class SizeClassPool : public std::pmr::memory_resource {
+public:
+    static constexpr std::size_t kMinBlock = 16;  ///< Smallest class
+    static constexpr std::size_t kClasses = 9;    ///< 16, 32, ..., 4096 bytes
+
+    /**
+     * @param upstream Resource the slabs (and oversized blocks) come from
+     * @param slabBytes Bytes requested from upstream whenever a class runs dry
+     */
+    explicit SizeClassPool(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource(),
+                           std::size_t slabBytes = 64 * 1024);
+    ~SizeClassPool() override;
+
+    SizeClassPool(const SizeClassPool&) = delete;
+    SizeClassPool& operator=(const SizeClassPool&) = delete;
+
+    /**
+     * @brief Returns every slab to upstream
+     *
+     * Blocks larger than the largest class are passed straight through to
+     * upstream and must still be deallocated by their owner.
+     */
+    void release();
+
+    std::size_t allocationCount() const { return allocations_; }    ///< Allocations served
+    std::size_t upstreamAllocations() const { return upstreamAllocations_; }  ///< Slabs and oversized blocks requested
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct Slab {
+        Slab* next;        ///< Previously allocated slab
+        std::size_t size;  ///< Bytes in the slab, header included
+    };
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    static std::size_t classOf(std::size_t bytes);
+    void refill(std::size_t sizeClass);
+
+    std::pmr::memory_resource* upstream_;         ///< Source of slabs and oversized blocks
+    std::size_t slabBytes_;                       ///< Size of each slab
+    FreeBlock* freeLists_[kClasses] = {};         ///< Free blocks per class
+    Slab* slabs_ = nullptr;                       ///< Every slab, newest first
+    std::size_t allocations_ = 0;                 ///< See allocationCount()
+    std::size_t upstreamAllocations_ = 0;         ///< See upstreamAllocations()
+};
+
+#endif
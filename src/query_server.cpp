@@ -0,0 +1,456 @@
+/**
+ * @file query_server.cpp
+ * @brief QueryServer pipeline: parser, worker and writer threads
+ */
+
+#include "query_server.hpp"
+#include "algo.hpp"
+#include "bucket_sort.hpp"
+#include "instrumentation.hpp"
+#include "memory_arena.hpp"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <istream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::uint64_t nowNs() {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// One unit of work; the same objects cycle through the pipeline so their
+// buffers are reused once the first few batches have grown them.
+struct Batch {
+    std::uint64_t startNs = 0;
+    std::vector<std::int64_t> ids;      // lookup input
+    std::vector<std::int64_t> indices;  // lookup results
+    std::vector<int> values;            // sort jobs back to back, sorted in place
+    std::vector<std::size_t> jobEnds;   // end of each job in values
+    std::uint64_t found = 0;
+
+    std::size_t records() const { return ids.empty() ? jobEnds.size() : ids.size(); }
+
+    void clear() {
+        ids.clear();
+        indices.clear();
+        values.clear();
+        jobEnds.clear();
+        found = 0;
+    }
+};
+
+using BatchPtr = std::unique_ptr<Batch>;
+
+// FIFO of at most capacity items. close() wakes everyone: push then fails,
+// and pop drains what is left before failing.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(std::size_t capacity) : capacity_(capacity) {}
+
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notFull_.wait(lock, [&] { return closed_ || items_.size() < capacity_; });
+        if (closed_) return false;
+        items_.push_back(std::move(item));
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    bool tryPush(T& item) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_ || items_.size() >= capacity_) return false;
+        items_.push_back(std::move(item));
+        return true;
+    }
+
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notEmpty_.wait(lock, [&] { return closed_ || !items_.empty(); });
+        if (items_.empty()) return false;
+        item = std::move(items_.front());
+        items_.pop_front();
+        notFull_.notify_one();
+        return true;
+    }
+
+    bool tryPop(T& item) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (items_.empty()) return false;
+        item = std::move(items_.front());
+        items_.pop_front();
+        notFull_.notify_one();
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        notFull_.notify_all();
+        notEmpty_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable notFull_;
+    std::condition_variable notEmpty_;
+    std::deque<T> items_;
+    std::size_t capacity_;
+    bool closed_ = false;
+};
+
+// Whitespace-separated integers from a stream, read in 64 KB blocks.
+class TextScanner {
+public:
+    explicit TextScanner(std::istream& in) : in_(in), buffer_(64 * 1024) {}
+
+    // Next integer token; lineBreak tells whether a newline preceded it.
+    // Tokens that are not integers (or overflow int64) are skipped and counted.
+    bool next(std::int64_t& value, bool& lineBreak, std::uint64_t& malformed) {
+        lineBreak = false;
+        for (;;) {
+            int c = peek();
+            if (c < 0) return false;
+            if (c == '\n') lineBreak = true;
+            if (isSpace(c)) {
+                ++pos_;
+                continue;
+            }
+
+            bool negative = c == '-';
+            if (c == '-' || c == '+') {
+                ++pos_;
+                c = peek();
+            }
+            const std::uint64_t limit = negative ? std::uint64_t(1) << 63 : (std::uint64_t(1) << 63) - 1;
+            std::uint64_t magnitude = 0;
+            bool digits = false;
+            bool bad = false;
+            for (; c >= 0 && !isSpace(c); ++pos_, c = peek()) {
+                unsigned digit = static_cast<unsigned>(c - '0');
+                if (digit > 9 || magnitude > (limit - digit) / 10) {
+                    bad = true;
+                } else if (!bad) {
+                    magnitude = magnitude * 10 + digit;
+                    digits = true;
+                }
+            }
+            if (!digits || bad) {
+                ++malformed;
+                continue;
+            }
+            value = negative ? static_cast<std::int64_t>(~magnitude + 1) : static_cast<std::int64_t>(magnitude);
+            return true;
+        }
+    }
+
+private:
+    static bool isSpace(int c) { return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\f' || c == '\v'; }
+
+    int peek() {
+        if (pos_ == end_) {
+            in_.read(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+            end_ = static_cast<std::size_t>(in_.gcount());
+            pos_ = 0;
+            if (end_ == 0) return -1;
+        }
+        return static_cast<unsigned char>(buffer_[pos_]);
+    }
+
+    std::istream& in_;
+    std::vector<char> buffer_;
+    std::size_t pos_ = 0;
+    std::size_t end_ = 0;
+};
+
+// Splits the input into batches of whole records.
+class BatchParser {
+public:
+    BatchParser(std::istream& in, const ServeOptions& options) : in_(in), text_(in), options_(options) {}
+
+    // Fills batch; false once the input is exhausted and nothing was read.
+    bool fill(Batch& batch, std::uint64_t& malformed) {
+        batch.clear();
+        if (options_.mode == ServeMode::Lookup) {
+            options_.format == ServeFormat::Text ? lookupText(batch, malformed) : lookupBinary(batch, malformed);
+        } else {
+            options_.format == ServeFormat::Text ? sortText(batch, malformed) : sortBinary(batch, malformed);
+        }
+        return batch.records() != 0;
+    }
+
+private:
+    void lookupText(Batch& batch, std::uint64_t& malformed) {
+        std::int64_t id = 0;
+        bool lineBreak = false;
+        while (batch.ids.size() < options_.batchSize && text_.next(id, lineBreak, malformed)) {
+            batch.ids.push_back(id);
+        }
+    }
+
+    void lookupBinary(Batch& batch, std::uint64_t& malformed) {
+        if (done_) return;
+        batch.ids.resize(options_.batchSize);
+        in_.read(reinterpret_cast<char*>(batch.ids.data()),
+                 static_cast<std::streamsize>(options_.batchSize * sizeof(std::int64_t)));
+        std::size_t bytes = static_cast<std::size_t>(in_.gcount());
+        batch.ids.resize(bytes / sizeof(std::int64_t));
+        if (bytes < options_.batchSize * sizeof(std::int64_t)) {
+            done_ = true;
+            if (bytes % sizeof(std::int64_t) != 0) ++malformed;
+        }
+    }
+
+    // A job is one line; a batch closes at the first line end past batchSize.
+    void sortText(Batch& batch, std::uint64_t& malformed) {
+        if (hasPending_) {
+            batch.values.push_back(pending_);
+            hasPending_ = false;
+        }
+        std::int64_t value = 0;
+        bool lineBreak = false;
+        bool skippedBreak = false;  // a newline before a skipped value still ends the job
+        while (text_.next(value, lineBreak, malformed)) {
+            lineBreak = lineBreak || skippedBreak;
+            skippedBreak = false;
+            if (value < std::numeric_limits<int>::min() || value > std::numeric_limits<int>::max()) {
+                ++malformed;
+                skippedBreak = lineBreak;
+                continue;
+            }
+            if (lineBreak && endJob(batch) && batch.values.size() >= options_.batchSize) {
+                pending_ = static_cast<int>(value);
+                hasPending_ = true;
+                return;
+            }
+            batch.values.push_back(static_cast<int>(value));
+        }
+        endJob(batch);
+    }
+
+    void sortBinary(Batch& batch, std::uint64_t& malformed) {
+        while (!done_ && batch.values.size() < options_.batchSize) {
+            std::uint32_t count = 0;
+            in_.read(reinterpret_cast<char*>(&count), sizeof(count));
+            if (in_.gcount() != sizeof(count)) {
+                if (in_.gcount() != 0) ++malformed;
+                done_ = true;
+                break;
+            }
+            // Grow in steps, so a corrupt count fails on the missing bytes
+            // instead of on one huge allocation.
+            std::size_t start = batch.values.size();
+            std::size_t remaining = count;
+            while (remaining > 0) {
+                std::size_t step = std::min<std::size_t>(remaining, 1 << 20);
+                std::size_t at = batch.values.size();
+                batch.values.resize(at + step);
+                in_.read(reinterpret_cast<char*>(batch.values.data() + at),
+                         static_cast<std::streamsize>(step * sizeof(int)));
+                if (static_cast<std::size_t>(in_.gcount()) != step * sizeof(int)) {
+                    batch.values.resize(start);
+                    ++malformed;
+                    done_ = true;
+                    return;
+                }
+                remaining -= step;
+            }
+            batch.jobEnds.push_back(batch.values.size());
+        }
+    }
+
+    // Closes the open job, if it has any values.
+    bool endJob(Batch& batch) {
+        std::size_t begin = batch.jobEnds.empty() ? 0 : batch.jobEnds.back();
+        if (batch.values.size() == begin) return false;
+        batch.jobEnds.push_back(batch.values.size());
+        return true;
+    }
+
+    std::istream& in_;
+    TextScanner text_;
+    const ServeOptions& options_;
+    int pending_ = 0;         // first value of the next batch's first job
+    bool hasPending_ = false;
+    bool done_ = false;       // binary input ended
+};
+
+void appendNumber(std::string& text, std::int64_t value, char separator) {
+    char digits[24];
+    char* end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+    text.append(digits, end);
+    text.push_back(separator);
+}
+
+void writeBatch(std::ostream& out, const Batch& batch, const ServeOptions& options, std::string& text) {
+    if (options.format == ServeFormat::Binary) {
+        if (options.mode == ServeMode::Lookup) {
+            out.write(reinterpret_cast<const char*>(batch.indices.data()),
+                      static_cast<std::streamsize>(batch.indices.size() * sizeof(std::int64_t)));
+            return;
+        }
+        std::size_t begin = 0;
+        for (std::size_t end : batch.jobEnds) {
+            std::uint32_t count = static_cast<std::uint32_t>(end - begin);
+            out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+            out.write(reinterpret_cast<const char*>(batch.values.data() + begin),
+                      static_cast<std::streamsize>(count * sizeof(int)));
+            begin = end;
+        }
+        return;
+    }
+
+    text.clear();
+    if (options.mode == ServeMode::Lookup) {
+        for (std::int64_t index : batch.indices) appendNumber(text, index, '\n');
+    } else {
+        std::size_t begin = 0;
+        for (std::size_t end : batch.jobEnds) {
+            for (std::size_t k = begin; k < end; ++k) appendNumber(text, batch.values[k], k + 1 == end ? '\n' : ' ');
+            begin = end;
+        }
+    }
+    out.write(text.data(), static_cast<std::streamsize>(text.size()));
+}
+
+double percentileUs(const std::vector<std::uint64_t>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    std::size_t rank = static_cast<std::size_t>(std::ceil(p * sorted.size()));
+    return sorted[rank == 0 ? 0 : rank - 1] / 1000.0;
+}
+
+} // namespace
+
+void ServeStats::print(std::ostream& os) const {
+    os << "Served " << queries << " queries in " << batches << " batches, " << seconds << " s ("
+       << queriesPerSecond << " queries/s)" << std::endl;
+    os << "  batch latency: p50 " << latencyP50Us << " us, p99 " << latencyP99Us << " us, p99.9 "
+       << latencyP999Us << " us, max " << latencyMaxUs << " us" << std::endl;
+    if (values != 0) os << "  values sorted: " << values << std::endl;
+    if (found != 0) os << "  found: " << found << std::endl;
+    if (malformed != 0) os << "  malformed input skipped: " << malformed << std::endl;
+}
+
+QueryServer::QueryServer(Algo* stations, const ServeOptions& options) : stations_(stations), options_(options) {
+    if (options_.mode == ServeMode::Lookup && !stations_) {
+        throw std::invalid_argument("QueryServer: lookup mode needs a station table");
+    }
+    if (options_.batchSize == 0 || options_.queueDepth == 0) {
+        throw std::invalid_argument("QueryServer: batch size and queue depth must be positive");
+    }
+}
+
+ServeStats QueryServer::run(std::istream& in, std::ostream& out) {
+    ALGO_SPAN("serve.run");
+    ServeStats stats;
+    const std::uint64_t startNs = nowNs();
+
+    BoundedQueue<BatchPtr> parsed(options_.queueDepth);
+    BoundedQueue<BatchPtr> answered(options_.queueDepth);
+    BoundedQueue<BatchPtr> spare(2 * options_.queueDepth + 3);  // every batch in flight fits
+    std::vector<std::uint64_t> latencies;
+    std::exception_ptr workerError;
+    std::exception_ptr writerError;
+
+    std::thread worker([&] {
+        try {
+            ArenaResource arena;
+            BucketSort sorter(&arena);
+            BatchPtr batch;
+            while (parsed.pop(batch)) {
+                if (options_.mode == ServeMode::Lookup) {
+                    ALGO_SPAN("serve.lookup_batch");
+                    batch->indices.resize(batch->ids.size());
+                    for (std::size_t k = 0; k < batch->ids.size(); ++k) {
+                        int probes = 0;
+                        batch->indices[k] = stations_->interpolationSearch(batch->ids[k], probes);
+                        batch->found += batch->indices[k] >= 0;
+                    }
+                } else {
+                    ALGO_SPAN("serve.sort_batch");
+                    std::size_t begin = 0;
+                    for (std::size_t end : batch->jobEnds) {
+                        std::vector<int>& numbers = sorter.getNumbers();
+                        numbers.assign(batch->values.begin() + begin, batch->values.begin() + end);
+                        sorter.bucketSort();
+                        std::copy(sorter.getNumbers().begin(), sorter.getNumbers().end(), batch->values.begin() + begin);
+                        begin = end;
+                    }
+                    arena.release();
+                }
+                if (!answered.push(std::move(batch))) break;
+            }
+        } catch (...) {
+            workerError = std::current_exception();
+        }
+        parsed.close();
+        answered.close();
+    });
+
+    std::thread writer([&] {
+        try {
+            std::string text;
+            BatchPtr batch;
+            while (answered.pop(batch)) {
+                writeBatch(out, *batch, options_, text);
+                if (!out) throw std::runtime_error("QueryServer: writing the results failed");
+                latencies.push_back(nowNs() - batch->startNs);
+                stats.queries += batch->records();
+                stats.values += batch->values.size();
+                stats.found += batch->found;
+                ++stats.batches;
+                spare.tryPush(batch);
+            }
+            out.flush();
+            if (!out) throw std::runtime_error("QueryServer: writing the results failed");
+        } catch (...) {
+            writerError = std::current_exception();
+            answered.close();
+            parsed.close();
+        }
+    });
+
+    std::exception_ptr parserError;
+    try {
+        BatchParser parser(in, options_);
+        for (;;) {
+            BatchPtr batch;
+            if (!spare.tryPop(batch)) batch = std::make_unique<Batch>();
+            batch->startNs = nowNs();
+            if (!parser.fill(*batch, stats.malformed) || !parsed.push(std::move(batch))) break;
+        }
+    } catch (...) {
+        parserError = std::current_exception();
+    }
+    parsed.close();
+    worker.join();
+    writer.join();
+
+    for (const std::exception_ptr& error : { parserError, workerError, writerError }) {
+        if (error) std::rethrow_exception(error);
+    }
+
+    stats.seconds = (nowNs() - startNs) / 1e9;
+    stats.queriesPerSecond = stats.seconds > 0 ? stats.queries / stats.seconds : 0.0;
+    std::sort(latencies.begin(), latencies.end());
+    stats.latencyP50Us = percentileUs(latencies, 0.50);
+    stats.latencyP99Us = percentileUs(latencies, 0.99);
+    stats.latencyP999Us = percentileUs(latencies, 0.999);
+    stats.latencyMaxUs = latencies.empty() ? 0.0 : latencies.back() / 1000.0;
+    ALGO_COUNT("serve.queries", stats.queries);
+    return stats;
+}
@@ -0,0 +1,131 @@
+/**
+ * @file query_server.hpp
+ * @brief Streaming batch lookups and sorts over stdin-style streams
+ *
+ * @section description Description
+ * Defines QueryServer, which answers a stream of station-ID lookups (or
+ * integer sort jobs) against data loaded once. Three threads form a
+ * pipeline joined by bounded queues:
+ * - the calling thread parses the input into batches,
+ * - a worker runs the lookups (Algo::interpolationSearch) or the sorts
+ *   (BucketSort, with scratch from an arena released after every batch),
+ * - a writer formats and writes each batch's results in input order.
+ * A full queue blocks its producer, so memory stays bounded by
+ * queueDepth batches per stage whatever the input size.
+ *
+ * @section formats Formats
+ * Lookup, text:   whitespace-separated IDs in; one index per line out
+ *                 (-1 when the station does not exist).
+ * Lookup, binary: int64 IDs in; int64 indices out.
+ * Sort, text:     one job per non-empty line of whitespace-separated
+ *                 integers in; the same line sorted out.
+ * Sort, binary:   jobs as a uint32 count followed by that many int32
+ *                 values, in and out.
+ * Binary values use the host byte order. Text tokens that are not
+ * integers are skipped and counted in ServeStats::malformed.
+ *
+ * @section usage Usage
+ * Algo algo;
+ * algo.loadStations("stations.txt");
+ * QueryServer server(&algo);
+ * ServeStats stats = server.run(std::cin, std::cout);
+ * stats.print(std::cerr);
+ */
+
+#ifndef QUERY_SERVER_HPP
+#define QUERY_SERVER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+class Algo;
+
+/**
+ * @enum ServeMode
+ * @brief What each input record asks for
+ */
+enum class ServeMode {
+    Lookup,  ///< Station ID to index
+    Sort     ///< List of integers to sorted list
+};
+
+/**
+ * @enum ServeFormat
+ * @brief Encoding of the input and output streams
+ */
+enum class ServeFormat {
+    Text,
+    Binary
+};
+
+/**
+ * @struct ServeOptions
+ * @brief Pipeline shape of a QueryServer
+ */
+struct ServeOptions {
+    ServeMode mode = ServeMode::Lookup;
+    ServeFormat format = ServeFormat::Text;
+    std::size_t batchSize = 4096;  ///< Lookups (or sorted values) per batch
+    std::size_t queueDepth = 8;    ///< Batches a queue holds before its producer blocks
+};
+
+/**
+ * @struct ServeStats
+ * @brief Throughput and latency of one QueryServer::run
+ *
+ * @details
+ * Latency is per batch, from the moment the parser starts filling it to
+ * the moment its results have been handed to the output stream, so it
+ * includes the time spent waiting in both queues.
+ */
+struct ServeStats {
+    std::uint64_t queries = 0;     ///< Lookups answered, or sort jobs completed
+    std::uint64_t values = 0;      ///< Sort mode: integers sorted
+    std::uint64_t found = 0;       ///< Lookup mode: IDs that exist
+    std::uint64_t malformed = 0;   ///< Text tokens skipped, or a truncated binary record
+    std::uint64_t batches = 0;     ///< Batches through the pipeline
+    double seconds = 0.0;          ///< Wall time of the run
+    double queriesPerSecond = 0.0; ///< queries / seconds
+    double latencyP50Us = 0.0;     ///< Median batch latency
+    double latencyP99Us = 0.0;     ///< 99th percentile batch latency
+    double latencyP999Us = 0.0;    ///< 99.9th percentile batch latency
+    double latencyMaxUs = 0.0;     ///< Slowest batch
+
+    /**
+     * @brief Writes a short human-readable summary
+     */
+    void print(std::ostream& os) const;
+};
+
+/**
+ * @class QueryServer
+ * @brief Pipelined batch engine over a loaded station table
+ */
+class QueryServer {
+public:
+    /**
+     * @param stations Loaded station table; may be null in Sort mode
+     * @param options Mode, format and pipeline sizes
+     * @throws std::invalid_argument if Lookup mode has no stations, or a size is 0
+     */
+    explicit QueryServer(Algo* stations, const ServeOptions& options = ServeOptions());
+
+    /**
+     * @brief Answers every record of in, writing the results to out
+     *
+     * @details
+     * Returns once in is exhausted and every result has been written; out
+     * is flushed. The station table must not change during the run.
+     * @throws std::runtime_error if writing to out fails
+     */
+    ServeStats run(std::istream& in, std::ostream& out);
+
+    const ServeOptions& options() const { return options_; }
+
+private:
+    Algo* stations_;       ///< Lookup table (not owned)
+    ServeOptions options_; ///< See options()
+};
+
+#endif
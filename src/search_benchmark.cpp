@@ -0,0 +1,259 @@
+// Search benchmark suite: answers seeded query streams with
+// Algo::interpolationSearch (every query starts from the whole table) and
+// Algo::fingerSearch (one cursor carried through the stream), and reports
+// JSON with nanoseconds and probes per query. Every finger result is checked
+// against the plain search.
+//
+// Streams (a quarter of the queries ask for id + 1, which is usually a miss):
+//   sequential  consecutive stations, like a walk along one line
+//   clustered   bursts of 256 queries within 64 stations of a random centre
+//   random      uniformly random stations
+//
+// Usage:
+//   searchBenchmark [--sizes 1000,1000000,...] [--gaps uniform,clustered,...]
+//                   [--streams sequential,clustered,random] [--queries N]
+//                   [--reps N] [--seed S] [--out results.json]
+//
+// The station tables come from StationGenerator (mean gap 10 for uniform).
+// Build with -DCMAKE_BUILD_TYPE=Release for meaningful numbers.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "algo.hpp"
+#include "station_generator.hpp"
+
+namespace {
+
+//===================================================
+// Query streams
+//===================================================
+std::vector<std::int64_t> generateStream(const std::string& stream, const std::vector<std::int64_t>& ids,
+                                         std::size_t queries, std::uint64_t seed) {
+    std::mt19937_64 gen(seed);
+    std::uniform_int_distribution<std::size_t> anyStation(0, ids.size() - 1);
+    std::uniform_int_distribution<int> quarter(0, 3);
+    std::vector<std::int64_t> out;
+    out.reserve(queries);
+
+    std::size_t walk = anyStation(gen);
+    std::size_t centre = anyStation(gen);
+    std::uniform_int_distribution<long> nearby(-64, 64);
+    for (std::size_t q = 0; q < queries; ++q) {
+        std::size_t index;
+        if (stream == "sequential") {
+            index = walk;
+            walk = walk + 1 < ids.size() ? walk + 1 : 0;
+        } else if (stream == "clustered") {
+            if (q % 256 == 0) centre = anyStation(gen);
+            long at = static_cast<long>(centre) + nearby(gen);
+            index = static_cast<std::size_t>(std::max(0L, std::min(at, static_cast<long>(ids.size()) - 1)));
+        } else if (stream == "random") {
+            index = anyStation(gen);
+        } else {
+            std::cerr << "Unknown stream: " << stream << std::endl;
+            return {};
+        }
+        out.push_back(ids[index] + (quarter(gen) == 0 ? 1 : 0));
+    }
+    return out;
+}
+
+StationGeneratorOptions gapOptions(const std::string& gaps, std::size_t size, std::uint64_t seed, bool& known) {
+    StationGeneratorOptions options;
+    options.count = size;
+    options.seed = seed;
+    options.format = StationFileFormat::Snapshot;
+    known = true;
+    if (gaps == "uniform") options.gaps = GapDistribution::Uniform;
+    else if (gaps == "bursty") options.gaps = GapDistribution::Bursty;
+    else if (gaps == "pareto") options.gaps = GapDistribution::Pareto;
+    else if (gaps == "clustered") options.gaps = GapDistribution::Clustered;
+    else known = false;
+    return options;
+}
+
+//===================================================
+// Measurement
+//===================================================
+struct Result {
+    std::string gaps;
+    std::string stream;
+    std::string algo;
+    std::size_t size = 0;
+    std::size_t queries = 0;
+    int reps = 0;
+    double minNs = 0, p50Ns = 0;  // per query
+    double meanProbes = 0;
+    bool correct = true;
+};
+
+double percentile(std::vector<double> samples, double p) {
+    std::sort(samples.begin(), samples.end());
+    std::size_t rank = static_cast<std::size_t>(std::ceil(p / 100.0 * samples.size()));
+    return samples[rank == 0 ? 0 : rank - 1];
+}
+
+// Runs the stream reps times; search(query, probes) answers one query.
+Result measure(const std::string& algo, const std::vector<std::int64_t>& stream, int reps,
+               const std::function<int(std::int64_t, int&)>& search, const std::vector<int>& expected,
+               std::vector<int>& answers) {
+    Result r;
+    r.algo = algo;
+    r.queries = stream.size();
+    r.reps = reps;
+    answers.assign(stream.size(), 0);
+
+    std::vector<double> samples;
+    std::uint64_t probeTotal = 0;
+    for (int rep = 0; rep < reps; ++rep) {
+        probeTotal = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t q = 0; q < stream.size(); ++q) {
+            int probes = 0;
+            answers[q] = search(stream[q], probes);
+            probeTotal += probes;
+        }
+        auto end = std::chrono::steady_clock::now();
+        samples.push_back(std::chrono::duration<double, std::nano>(end - start).count() / stream.size());
+    }
+    r.minNs = *std::min_element(samples.begin(), samples.end());
+    r.p50Ns = percentile(samples, 50);
+    r.meanProbes = static_cast<double>(probeTotal) / stream.size();
+    r.correct = expected.empty() || answers == expected;
+    return r;
+}
+
+void writeJson(std::ostream& os, const std::vector<Result>& results, std::uint64_t seed) {
+    os << "{\n  \"benchmark\": \"search\",\n  \"seed\": " << seed << ",\n  \"results\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        os << "    {\"gaps\": \"" << r.gaps << "\", \"stream\": \"" << r.stream
+           << "\", \"algorithm\": \"" << r.algo << "\", \"size\": " << r.size
+           << ", \"queries\": " << r.queries << ", \"reps\": " << r.reps
+           << ", \"ns_per_query\": {\"min\": " << r.minNs << ", \"p50\": " << r.p50Ns << "}"
+           << ", \"mean_probes\": " << r.meanProbes
+           << ", \"correct\": " << (r.correct ? "true" : "false") << "}"
+           << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n}\n";
+}
+
+std::vector<std::string> splitList(const std::string& list) {
+    std::vector<std::string> items;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::vector<std::size_t> sizes = { 1000, 100000, 10000000 };
+    std::vector<std::string> gapNames = { "uniform", "clustered" };
+    std::vector<std::string> streams = { "sequential", "clustered", "random" };
+    std::size_t queries = 1000000;
+    int reps = 5;
+    std::uint64_t seed = 42;
+    std::string outPath;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        std::string value = argv[i + 1];
+        if (flag == "--sizes") {
+            sizes.clear();
+            for (const auto& s : splitList(value)) sizes.push_back(static_cast<std::size_t>(std::stod(s)));
+        } else if (flag == "--gaps") {
+            gapNames = splitList(value);
+        } else if (flag == "--streams") {
+            streams = splitList(value);
+        } else if (flag == "--queries") {
+            queries = static_cast<std::size_t>(std::stod(value));
+        } else if (flag == "--reps") {
+            reps = std::max(1, std::stoi(value));
+        } else if (flag == "--seed") {
+            seed = std::stoull(value);
+        } else if (flag == "--out") {
+            outPath = value;
+        } else {
+            std::cerr << "Unknown option: " << flag << std::endl;
+            return 1;
+        }
+    }
+
+    const std::string tablePath = "search_benchmark_stations.bin";
+    std::vector<Result> results;
+    for (const auto& gaps : gapNames) {
+        for (std::size_t size : sizes) {
+            bool known = false;
+            StationGeneratorOptions options = gapOptions(gaps, size, seed, known);
+            if (!known || size == 0) {
+                std::cerr << "Skipping gaps=" << gaps << " n=" << size << std::endl;
+                continue;
+            }
+            Algo algo;
+            std::vector<std::int64_t> ids;
+            try {
+                StationGenerator::generate(tablePath, options);
+                ids = StationGenerator::readSnapshot(tablePath);
+            } catch (const std::exception& e) {
+                std::cerr << "ERROR: " << e.what() << std::endl;
+                return 1;
+            }
+            bool loaded = algo.loadStationSnapshot(tablePath);
+            std::remove(tablePath.c_str());
+            if (!loaded) return 1;
+
+            for (const auto& name : streams) {
+                std::vector<std::int64_t> stream = generateStream(name, ids, queries, seed + 1);
+                if (stream.empty()) continue;
+                std::cerr << gaps << " n=" << size << " " << name << std::endl;
+
+                std::vector<int> expected, answers;
+                Result plain = measure("interpolation", stream, reps,
+                    [&algo](std::int64_t id, int& probes) { return algo.interpolationSearch(id, probes); },
+                    {}, expected);
+
+                // The cursor persists across reps, as it would across batches.
+                SearchCursor cursor;
+                Result finger = measure("finger", stream, reps,
+                    [&algo, &cursor](std::int64_t id, int& probes) { return algo.fingerSearch(id, cursor, probes); },
+                    expected, answers);
+                if (!finger.correct) {
+                    std::cerr << "ERROR: finger search disagrees on " << gaps << "/" << name << std::endl;
+                }
+
+                for (Result* r : { &plain, &finger }) {
+                    r->gaps = gaps;
+                    r->stream = name;
+                    r->size = size;
+                    results.push_back(*r);
+                }
+            }
+        }
+    }
+
+    if (outPath.empty()) {
+        writeJson(std::cout, results, seed);
+    } else {
+        std::ofstream out(outPath);
+        if (!out.is_open()) {
+            std::cerr << "Failed to open file for writing: " << outPath << std::endl;
+            return 1;
+        }
+        writeJson(out, results, seed);
+    }
+    return 0;
+}
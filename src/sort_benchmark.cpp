@@ -0,0 +1,316 @@
+﻿// Sort benchmark suite: runs the BucketSort strategies against std::sort,
+// std::stable_sort and a plain LSD radix sort over seeded input
+// distributions and sizes, and reports JSON. The *_arena and *_pool
+// variants give the sorter an ArenaResource or SizeClassPool per run; their
+// "allocations" column shows the heap calls the resource saves.
+//
+// Usage:
+//   sortBenchmark [--sizes 1000,10000,...] [--dists uniform,zipf,...]
+//                 [--algos bucket,std_sort,...] [--reps N] [--seed S]
+//                 [--out results.json]
+//
+// Sizes up to 1e9 are accepted; each size needs roughly 3 * 4 bytes per
+// element (input, working copy, and the algorithm's own buffers). Build with
+// -DCMAKE_BUILD_TYPE=Release for meaningful numbers.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "alloc_stats.hpp"
+#include "bucket_sort.hpp"
+#include "memory_arena.hpp"
+
+namespace {
+
+//===================================================
+// Input distributions
+//===================================================
+std::vector<int> generateInput(const std::string& dist, std::size_t n, std::uint64_t seed) {
+    std::mt19937_64 gen(seed);
+    std::vector<int> data(n);
+
+    if (dist == "uniform") {
+        std::uniform_int_distribution<int> d(0, std::numeric_limits<int>::max());
+        for (int& v : data) v = d(gen);
+    } else if (dist == "normal") {
+        std::normal_distribution<double> d(0.0, 1e6);
+        for (int& v : data) v = static_cast<int>(std::max(-2e9, std::min(2e9, d(gen))));
+    } else if (dist == "zipf") {
+        // Rank r is drawn with probability proportional to 1 / r^1.1.
+        std::size_t ranks = std::min<std::size_t>(n, 1000000);
+        std::vector<double> cdf(ranks);
+        double total = 0.0;
+        for (std::size_t r = 0; r < ranks; ++r) {
+            total += 1.0 / std::pow(static_cast<double>(r + 1), 1.1);
+            cdf[r] = total;
+        }
+        std::uniform_real_distribution<double> d(0.0, total);
+        for (int& v : data) {
+            v = static_cast<int>(std::lower_bound(cdf.begin(), cdf.end(), d(gen)) - cdf.begin());
+        }
+    } else if (dist == "sorted" || dist == "reverse") {
+        for (std::size_t i = 0; i < n; ++i) data[i] = static_cast<int>(i * 2);
+        if (dist == "reverse") std::reverse(data.begin(), data.end());
+    } else if (dist == "few_unique") {
+        std::uniform_int_distribution<int> pick(0, 15);
+        std::uniform_int_distribution<int> d(std::numeric_limits<int>::min(), std::numeric_limits<int>::max());
+        int values[16];
+        for (int& v : values) v = d(gen);
+        for (int& v : data) v = values[pick(gen)];
+    } else if (dist == "outlier") {
+        // Dense small values plus 1% far-away outliers that stretch the range.
+        std::uniform_int_distribution<int> body(0, 999);
+        std::uniform_int_distribution<int> far(-1000000000, 1000000000);
+        std::uniform_int_distribution<int> coin(0, 99);
+        for (int& v : data) v = coin(gen) == 0 ? far(gen) : body(gen);
+    } else {
+        std::cerr << "Unknown distribution: " << dist << std::endl;
+        data.clear();
+    }
+    return data;
+}
+
+//===================================================
+// Reference LSD radix: four 8-bit passes over the sign-flipped keys.
+//===================================================
+void lsdRadixSort(std::vector<int>& data) {
+    std::vector<int> scratch(data.size());
+    int* src = data.data();
+    int* dst = scratch.data();
+    std::size_t n = data.size();
+
+    for (int shift = 0; shift < 32; shift += 8) {
+        std::size_t counts[256] = {};
+        for (std::size_t i = 0; i < n; ++i) {
+            ++counts[((static_cast<std::uint32_t>(src[i]) ^ 0x80000000u) >> shift) & 0xFF];
+        }
+        std::size_t offset = 0;
+        for (std::size_t& c : counts) {
+            std::size_t count = c;
+            c = offset;
+            offset += count;
+        }
+        for (std::size_t i = 0; i < n; ++i) {
+            dst[counts[((static_cast<std::uint32_t>(src[i]) ^ 0x80000000u) >> shift) & 0xFF]++] = src[i];
+        }
+        std::swap(src, dst);
+    }
+}
+
+//===================================================
+// Algorithms under test
+//===================================================
+struct Algorithm {
+    std::string name;
+    // Sorts data in place, returns the variant that actually ran.
+    std::function<std::string(std::vector<int>&)> run;
+};
+
+std::string runBucketSort(std::vector<int>& data, SortStrategy strategy,
+                          std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
+    BucketSort sorter(resource);
+    sorter.setStrategy(strategy);
+    sorter.getNumbers().swap(data);
+    sorter.bucketSort();
+    sorter.getNumbers().swap(data);
+    return sortStrategyName(sorter.getLastStrategy());
+}
+
+std::vector<Algorithm> allAlgorithms() {
+    std::vector<Algorithm> algos;
+    for (SortStrategy s : { SortStrategy::Auto, SortStrategy::Bucket, SortStrategy::Counting,
+                            SortStrategy::Radix, SortStrategy::InPlace }) {
+        algos.push_back({ std::string("bucket_sort_") + sortStrategyName(s),
+                          [s](std::vector<int>& d) { return runBucketSort(d, s); } });
+    }
+    // Same sorts with their scratch in a per-run arena or size-class pool.
+    for (SortStrategy s : { SortStrategy::Auto, SortStrategy::Bucket }) {
+        algos.push_back({ std::string("bucket_sort_") + sortStrategyName(s) + "_arena", [s](std::vector<int>& d) {
+            ArenaResource arena;
+            return runBucketSort(d, s, &arena);
+        } });
+        algos.push_back({ std::string("bucket_sort_") + sortStrategyName(s) + "_pool", [s](std::vector<int>& d) {
+            SizeClassPool pool;
+            return runBucketSort(d, s, &pool);
+        } });
+    }
+    algos.push_back({ "std_sort", [](std::vector<int>& d) {
+        std::sort(d.begin(), d.end());
+        return std::string("std_sort");
+    } });
+    algos.push_back({ "std_stable_sort", [](std::vector<int>& d) {
+        std::stable_sort(d.begin(), d.end());
+        return std::string("std_stable_sort");
+    } });
+    algos.push_back({ "lsd_radix", [](std::vector<int>& d) {
+        lsdRadixSort(d);
+        return std::string("lsd_radix");
+    } });
+    return algos;
+}
+
+//===================================================
+// Measurement
+//===================================================
+struct Result {
+    std::string dist;
+    std::string algo;
+    std::string variant;
+    std::size_t size = 0;
+    int reps = 0;
+    double minNs = 0, meanNs = 0, p50Ns = 0, p90Ns = 0, p99Ns = 0;
+    double elementsPerSec = 0;
+    std::int64_t peakHeapBytes = 0;
+    std::uint64_t allocations = 0;
+    bool sorted = true;
+};
+
+double percentile(std::vector<double> samples, double p) {
+    std::sort(samples.begin(), samples.end());
+    std::size_t rank = static_cast<std::size_t>(std::ceil(p / 100.0 * samples.size()));
+    return samples[rank == 0 ? 0 : rank - 1];
+}
+
+Result measure(const Algorithm& algo, const std::string& dist, const std::vector<int>& input, int reps) {
+    Result r;
+    r.dist = dist;
+    r.algo = algo.name;
+    r.size = input.size();
+    r.reps = reps;
+
+    std::vector<double> samples;
+    std::vector<int> work;
+    for (int rep = 0; rep < reps; ++rep) {
+        work = input;
+
+        resetPeakBytes();
+        AllocationStats before = currentAllocationStats();
+
+        auto start = std::chrono::steady_clock::now();
+        r.variant = algo.run(work);
+        auto end = std::chrono::steady_clock::now();
+
+        samples.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+        AllocationStats used = currentAllocationStats() - before;
+        r.peakHeapBytes = std::max(r.peakHeapBytes, used.peakBytes - before.liveBytes);
+        r.allocations = std::max(r.allocations, used.allocations);
+        r.sorted = r.sorted && std::is_sorted(work.begin(), work.end());
+    }
+
+    double sum = 0;
+    for (double s : samples) sum += s;
+    r.minNs = *std::min_element(samples.begin(), samples.end());
+    r.meanNs = sum / samples.size();
+    r.p50Ns = percentile(samples, 50);
+    r.p90Ns = percentile(samples, 90);
+    r.p99Ns = percentile(samples, 99);
+    r.elementsPerSec = r.p50Ns > 0 ? r.size / (r.p50Ns * 1e-9) : 0;
+    return r;
+}
+
+void writeJson(std::ostream& os, const std::vector<Result>& results, std::uint64_t seed) {
+    os << "{\n  \"benchmark\": \"sort\",\n  \"seed\": " << seed << ",\n  \"results\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        os << "    {\"distribution\": \"" << r.dist << "\", \"algorithm\": \"" << r.algo
+           << "\", \"variant\": \"" << r.variant << "\", \"size\": " << r.size
+           << ", \"reps\": " << r.reps
+           << ", \"elements_per_sec\": " << r.elementsPerSec
+           << ", \"ns\": {\"min\": " << r.minNs << ", \"mean\": " << r.meanNs
+           << ", \"p50\": " << r.p50Ns << ", \"p90\": " << r.p90Ns << ", \"p99\": " << r.p99Ns << "}"
+           << ", \"peak_heap_bytes\": " << r.peakHeapBytes
+           << ", \"allocations\": " << r.allocations
+           << ", \"sorted\": " << (r.sorted ? "true" : "false") << "}"
+           << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n}\n";
+}
+
+std::vector<std::string> splitList(const std::string& list) {
+    std::vector<std::string> items;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::vector<std::size_t> sizes = { 1000, 10000, 100000, 1000000 };
+    std::vector<std::string> dists = { "uniform", "normal", "zipf", "sorted", "reverse", "few_unique", "outlier" };
+    std::vector<std::string> algoNames;
+    std::uint64_t seed = 42;
+    int reps = 0; // 0: pick per size
+    std::string outPath;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        std::string value = argv[i + 1];
+        if (flag == "--sizes") {
+            sizes.clear();
+            for (const auto& s : splitList(value)) sizes.push_back(static_cast<std::size_t>(std::stod(s)));
+        } else if (flag == "--dists") {
+            dists = splitList(value);
+        } else if (flag == "--algos") {
+            algoNames = splitList(value);
+        } else if (flag == "--reps") {
+            reps = std::stoi(value);
+        } else if (flag == "--seed") {
+            seed = std::stoull(value);
+        } else if (flag == "--out") {
+            outPath = value;
+        } else {
+            std::cerr << "Unknown option: " << flag << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<Algorithm> algos;
+    for (auto& algo : allAlgorithms()) {
+        if (algoNames.empty() || std::find(algoNames.begin(), algoNames.end(), algo.name) != algoNames.end()) {
+            algos.push_back(algo);
+        }
+    }
+
+    std::vector<Result> results;
+    for (const auto& dist : dists) {
+        for (std::size_t size : sizes) {
+            std::vector<int> input = generateInput(dist, size, seed);
+            if (input.size() != size) continue;
+
+            // Enough repetitions for stable percentiles on small inputs.
+            int sizeReps = reps > 0 ? reps : (size <= 10000 ? 101 : size <= 1000000 ? 11 : 3);
+            for (const auto& algo : algos) {
+                std::cerr << dist << " n=" << size << " " << algo.name << std::endl;
+                results.push_back(measure(algo, dist, input, sizeReps));
+                if (!results.back().sorted) {
+                    std::cerr << "ERROR: " << algo.name << " failed to sort " << dist << std::endl;
+                }
+            }
+        }
+    }
+
+    if (outPath.empty()) {
+        writeJson(std::cout, results, seed);
+    } else {
+        std::ofstream out(outPath);
+        if (!out.is_open()) {
+            std::cerr << "Failed to open file for writing: " << outPath << std::endl;
+            return 1;
+        }
+        writeJson(out, results, seed);
+    }
+    return 0;
+}
@@ -0,0 +1,241 @@
+/**
+ * @file station_generator.cpp
+ * @brief Chunked parallel station generation and snapshot reading
+ */
+
+#include "station_generator.hpp"
+#include "counter_rng.hpp"
+#include "instrumentation.hpp"
+#include "task_pool.hpp"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+const char kSnapshotMagic[8] = { 'S', 'G', 'S', 'T', 'A', 'T', 'N', '1' };
+const char kStationPrefix[8] = { 'S', 't', 'a', 't', 'i', 'o', 'n', '_' };
+const std::size_t kMaxLineBytes = sizeof(kStationPrefix) + 20 + 1;  // prefix, int64 digits and sign, newline
+const std::uint32_t kGapStream = 0x53544E47u;                       // keeps station draws apart from other Philox users
+const std::size_t kLanes = 8;                                       // counters per generateLanes call
+const std::size_t kGapsPerBlock = 4 * kLanes;
+
+/**
+ * @brief Stations [begin, end) of the file and the buffers that produce them
+ */
+struct Chunk {
+    std::uint64_t begin = 0;
+    std::uint64_t end = 0;
+    std::vector<std::uint32_t> gaps;  // gaps[k]: from station begin + k to the next one
+    std::int64_t span = 0;            // sum of gaps
+    std::int64_t firstId = 0;
+    std::int64_t lastId = 0;
+    std::vector<char> bytes;          // formatted output, size bytes of it valid
+    std::size_t size = 0;
+};
+
+/**
+ * @brief Closes a stdio file when it goes out of scope
+ */
+struct FileCloser {
+    std::FILE* file;
+    ~FileCloser() { if (file) std::fclose(file); }
+};
+
+// Gap k of the whole file is word k % 4 of Philox counter k / 4; chunks
+// start on multiples of kGapsPerBlock, so whole blocks never straddle two.
+void drawGaps(Chunk& chunk, const StationGeneratorOptions& options, Philox4x32::Key key) {
+    chunk.gaps.resize(chunk.end - chunk.begin);
+    std::int64_t span = 0;
+    for (std::uint64_t base = chunk.begin; base < chunk.end; base += kGapsPerBlock) {
+        std::uint32_t words[4][kLanes];
+        for (std::size_t lane = 0; lane < kLanes; ++lane) {
+            std::uint64_t counter = base / 4 + lane;
+            words[0][lane] = static_cast<std::uint32_t>(counter);
+            words[1][lane] = static_cast<std::uint32_t>(counter >> 32);
+            words[2][lane] = kGapStream;
+            words[3][lane] = 0;
+        }
+        Philox4x32::generateLanes(words, key);
+        for (std::size_t lane = 0; lane < kLanes; ++lane) {
+            for (std::size_t word = 0; word < 4; ++word) {
+                std::uint64_t index = base + 4 * lane + word;
+                if (index < chunk.end) {
+                    std::uint32_t gap = StationGenerator::gap(options, index, words[word][lane]);
+                    chunk.gaps[index - chunk.begin] = gap;
+                    span += gap;
+                }
+            }
+        }
+    }
+    chunk.span = span;
+}
+
+void formatChunk(Chunk& chunk, StationFileFormat format) {
+    std::size_t count = chunk.gaps.size();
+    std::int64_t id = chunk.firstId;
+    if (format == StationFileFormat::Snapshot) {
+        chunk.bytes.resize(count * sizeof(std::int64_t));
+        char* out = chunk.bytes.data();
+        for (std::size_t k = 0; k < count; ++k) {
+            std::memcpy(out + k * sizeof(std::int64_t), &id, sizeof(id));
+            id += chunk.gaps[k];
+        }
+        chunk.size = chunk.bytes.size();
+    } else {
+        chunk.bytes.resize(count * kMaxLineBytes);
+        char* out = chunk.bytes.data();
+        for (std::size_t k = 0; k < count; ++k) {
+            std::memcpy(out, kStationPrefix, sizeof(kStationPrefix));
+            out = std::to_chars(out + sizeof(kStationPrefix), out + kMaxLineBytes, id).ptr;
+            *out++ = '\n';
+            id += chunk.gaps[k];
+        }
+        chunk.size = static_cast<std::size_t>(out - chunk.bytes.data());
+    }
+    chunk.lastId = count ? id - chunk.gaps[count - 1] : chunk.firstId;
+}
+
+} // namespace
+
+std::uint32_t StationGenerator::gap(const StationGeneratorOptions& options, std::uint64_t index, std::uint32_t random) {
+    auto scaled = [random](std::uint32_t low, std::uint32_t high) {
+        return low + static_cast<std::uint32_t>((static_cast<std::uint64_t>(random) * (high - low + 1)) >> 32);
+    };
+    switch (options.gaps) {
+    case GapDistribution::Uniform:
+        return scaled(1, 2 * options.meanGap - 1);
+    case GapDistribution::Bursty:
+        if ((random & 63) == 0) {
+            return 1000 + static_cast<std::uint32_t>((static_cast<std::uint64_t>(random >> 6) * 19001) >> 26);
+        }
+        return 1 + ((random >> 6) & 3);
+    case GapDistribution::Pareto: {
+        double u = (random + 1.0) * (1.0 / 4294967296.0);
+        double value = std::ceil(std::pow(u, -1.0 / options.paretoAlpha));
+        return value >= 1e9 ? 1000000000u : static_cast<std::uint32_t>(value);
+    }
+    case GapDistribution::Clustered:
+        if (index % 10 == 0) return scaled(5000, 20000);
+        if (index % 3 == 0) return scaled(50, 200);
+        return scaled(1, 5);
+    }
+    return 1;
+}
+
+StationGeneratorStats StationGenerator::generate(const std::string& path, const StationGeneratorOptions& options) {
+    ALGO_SPAN("stations.generate");
+    if (options.meanGap == 0 || options.meanGap > (1u << 31)) {
+        throw std::invalid_argument("StationGenerator: meanGap must be in [1, 2^31]");
+    }
+    if (!(options.paretoAlpha > 0.0)) {
+        throw std::invalid_argument("StationGenerator: paretoAlpha must be positive");
+    }
+    auto start = std::chrono::steady_clock::now();
+
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        throw std::runtime_error("StationGenerator: cannot create " + path);
+    }
+    FileCloser closer{ file };
+    std::setvbuf(file, nullptr, _IONBF, 0);  // every write is already a whole chunk
+
+    StationGeneratorStats stats;
+    bool ok = true;
+    if (options.format == StationFileFormat::Snapshot) {
+        ok = std::fwrite(kSnapshotMagic, 1, sizeof(kSnapshotMagic), file) == sizeof(kSnapshotMagic)
+            && std::fwrite(&options.count, sizeof(options.count), 1, file) == 1;
+        stats.bytesWritten = sizeof(kSnapshotMagic) + sizeof(options.count);
+    }
+
+    TaskPool pool(options.threads);
+    const std::size_t chunkStations =
+        (std::max<std::size_t>(options.chunkStations, 1) + kGapsPerBlock - 1) / kGapsPerBlock * kGapsPerBlock;
+    const std::size_t roundChunks = pool.threadCount() + 1;  // the waiting caller runs tasks too
+    const Philox4x32::Key key = Philox4x32::keyFromSeed(options.seed);
+
+    // Two rounds of buffers: the pool formats one while the other is written.
+    std::vector<Chunk> rounds[2] = { std::vector<Chunk>(roundChunks), std::vector<Chunk>(roundChunks) };
+    std::size_t pending = 0;  // formatted chunks in the other round, not yet written
+    std::uint64_t nextIndex = 0;
+    std::int64_t nextId = options.firstId;
+    int current = 0;
+
+    while (nextIndex < options.count || pending > 0) {
+        std::vector<Chunk>& round = rounds[current];
+        std::size_t chunks = 0;
+        TaskPool::TaskGroup draws;
+        for (; chunks < roundChunks && nextIndex < options.count; ++chunks) {
+            Chunk& chunk = round[chunks];
+            chunk.begin = nextIndex;
+            chunk.end = std::min<std::uint64_t>(options.count, nextIndex + chunkStations);
+            nextIndex = chunk.end;
+            pool.run(draws, [&chunk, &options, key] { drawGaps(chunk, options, key); });
+        }
+        pool.wait(draws);
+
+        TaskPool::TaskGroup formats;
+        for (std::size_t k = 0; k < chunks; ++k) {
+            Chunk& chunk = round[k];
+            chunk.firstId = nextId;
+            nextId += chunk.span;
+            pool.run(formats, [&chunk, &options] { formatChunk(chunk, options.format); });
+        }
+
+        std::vector<Chunk>& previous = rounds[current ^ 1];
+        for (std::size_t k = 0; k < pending; ++k) {
+            ok = ok && std::fwrite(previous[k].bytes.data(), 1, previous[k].size, file) == previous[k].size;
+            stats.bytesWritten += previous[k].size;
+            stats.stations += previous[k].end - previous[k].begin;
+            stats.lastId = previous[k].lastId;
+        }
+        pool.wait(formats);
+
+        pending = chunks;
+        current ^= 1;
+    }
+
+    ok = ok && std::fflush(file) == 0;
+    if (!ok) {
+        throw std::runtime_error("StationGenerator: write failed for " + path);
+    }
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ALGO_COUNT("stations.generated", stats.stations);
+    return stats;
+}
+
+std::vector<std::int64_t> StationGenerator::readSnapshot(const std::string& path) {
+    ALGO_SPAN("stations.read_snapshot");
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        throw std::runtime_error("StationGenerator: cannot open " + path);
+    }
+    FileCloser closer{ file };
+
+    char magic[sizeof(kSnapshotMagic)];
+    std::uint64_t count = 0;
+    if (std::fread(magic, 1, sizeof(magic), file) != sizeof(magic)
+        || std::memcmp(magic, kSnapshotMagic, sizeof(magic)) != 0
+        || std::fread(&count, sizeof(count), 1, file) != 1) {
+        throw std::runtime_error("StationGenerator: " + path + " is not a station snapshot");
+    }
+
+    // Check the size before allocating, so a corrupt count cannot ask for terabytes.
+    long headerEnd = std::ftell(file);
+    std::fseek(file, 0, SEEK_END);
+    std::uint64_t payload = static_cast<std::uint64_t>(std::ftell(file) - headerEnd);
+    std::fseek(file, headerEnd, SEEK_SET);
+    if (payload / sizeof(std::int64_t) < count) {
+        throw std::runtime_error("StationGenerator: " + path + " is truncated");
+    }
+
+    std::vector<std::int64_t> ids(count);
+    if (std::fread(ids.data(), sizeof(std::int64_t), ids.size(), file) != ids.size()) {
+        throw std::runtime_error("StationGenerator: read failed for " + path);
+    }
+    return ids;
+}
@@ -0,0 +1,116 @@
+/**
+ * @file station_generator.hpp
+ * @brief Bulk station dataset generation and the binary station snapshot
+ *
+ * @section description Description
+ * StationGenerator writes ascending station IDs, either as the text files
+ * Algo::loadStations reads ("Station_<id>" per line) or as a binary
+ * snapshot. Each gap between consecutive IDs is drawn from a counter-based
+ * generator (Philox, see counter_rng.hpp) indexed by the gap's position.
+ * The file therefore depends only on the options and the seed, not on the
+ * thread count or chunk size, and chunks can be produced in any order:
+ * - each task draws the gaps of one chunk and sums them,
+ * - a prefix sum over the chunk sums gives every chunk its first ID,
+ * - the tasks format their chunks into private buffers,
+ * - the calling thread writes each buffer with one fwrite while the pool
+ *   formats the next round.
+ *
+ * @section snapshot Snapshot format
+ * 8-byte magic "SGSTATN1", the station count as uint64, then that many
+ * int64 IDs in ascending order, all in host byte order. Station k is named
+ * "Station_<id>", as in the text format.
+ *
+ * @section usage Usage
+ * StationGeneratorOptions options;
+ * options.count = 1000000000;
+ * options.gaps = GapDistribution::Bursty;
+ * options.format = StationFileFormat::Snapshot;
+ * StationGeneratorStats stats = StationGenerator::generate("stations.bin", options);
+ */
+
+#ifndef STATION_GENERATOR_HPP
+#define STATION_GENERATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @enum GapDistribution
+ * @brief How far apart consecutive station IDs are
+ */
+enum class GapDistribution {
+    Uniform,   ///< Uniform in [1, 2 * meanGap - 1]; meanGap 1 gives sequential IDs
+    Bursty,    ///< Runs of gaps in [1, 4], broken with probability 1/64 by a gap in [1000, 20000]
+    Pareto,    ///< Heavy-tailed: ceil(u^(-1 / paretoAlpha)) for u uniform in (0, 1]
+    Clustered  ///< Groups of ten: gaps in [1, 5], every third in [50, 200], every tenth in [5000, 20000]
+};
+
+/**
+ * @enum StationFileFormat
+ * @brief Encoding of a generated station file
+ */
+enum class StationFileFormat {
+    Text,     ///< One "Station_<id>" line per station
+    Snapshot  ///< Binary snapshot, see the file comment
+};
+
+/**
+ * @struct StationGeneratorOptions
+ * @brief What StationGenerator::generate writes, and with how many threads
+ */
+struct StationGeneratorOptions {
+    std::uint64_t count = 1000000;                    ///< Stations to write
+    GapDistribution gaps = GapDistribution::Uniform;  ///< Gap between consecutive IDs
+    StationFileFormat format = StationFileFormat::Text;
+    std::int64_t firstId = 1;                         ///< ID of the first station
+    std::uint32_t meanGap = 10;                       ///< Uniform only
+    double paretoAlpha = 1.5;                         ///< Pareto only; gaps are capped at 10^9
+    std::uint64_t seed = 1;                           ///< Same seed, same file
+    unsigned threads = 0;                             ///< Pool threads; 0 uses the hardware concurrency
+    std::size_t chunkStations = 1 << 18;              ///< Stations per task, rounded up to a multiple of 32
+};
+
+/**
+ * @struct StationGeneratorStats
+ * @brief Outcome of one StationGenerator::generate call
+ */
+struct StationGeneratorStats {
+    std::uint64_t stations = 0;      ///< Stations written
+    std::uint64_t bytesWritten = 0;  ///< File size
+    std::int64_t lastId = 0;         ///< ID of the last station
+    double seconds = 0.0;            ///< Wall time, including the final flush
+};
+
+/**
+ * @class StationGenerator
+ * @brief Parallel station file writer and snapshot reader
+ */
+class StationGenerator {
+public:
+    /**
+     * @brief Writes options.count stations to path
+     * @throws std::invalid_argument for meanGap outside [1, 2^31] or a non-positive paretoAlpha
+     * @throws std::runtime_error if the file cannot be created or written
+     */
+    static StationGeneratorStats generate(const std::string& path, const StationGeneratorOptions& options);
+
+    /**
+     * @brief Reads every station ID of a binary snapshot
+     * @throws std::runtime_error if path is missing, not a snapshot, or truncated
+     */
+    static std::vector<std::int64_t> readSnapshot(const std::string& path);
+
+    /**
+     * @brief Gap between station index and station index + 1
+     *
+     * @details
+     * Follows options.gaps; random is the 32-bit Philox word drawn for
+     * that index. Exposed so tests can check the distributions without
+     * writing files.
+     */
+    static std::uint32_t gap(const StationGeneratorOptions& options, std::uint64_t index, std::uint32_t random);
+};
+
+#endif
@@ -0,0 +1,143 @@
+/**
+ * @file task_pool.cpp
+ * @brief Work-stealing task pool implementation
+ */
+
+#include "task_pool.hpp"
+#include <algorithm>
+
+namespace {
+
+// Which pool (if any) the current thread is a worker of, and its slot.
+thread_local const TaskPool* tlsPool = nullptr;
+thread_local size_t tlsWorker = 0;
+
+const size_t kNotAWorker = static_cast<size_t>(-1);
+
+} // namespace
+
+TaskPool::TaskPool(unsigned threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (unsigned i = 0; i < threadCount; ++i) {
+        queues_.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (unsigned i = 0; i < threadCount; ++i) {
+        workers_.emplace_back([this, i] { workerLoop(i); });
+    }
+}
+
+TaskPool::~TaskPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+size_t TaskPool::currentWorker() const {
+    return tlsPool == this ? tlsWorker : kNotAWorker;
+}
+
+void TaskPool::run(TaskGroup& group, std::function<void()> task) {
+    group.pending_.fetch_add(1, std::memory_order_relaxed);
+
+    // Workers push onto their own deque; outside threads spread round-robin.
+    size_t index = currentWorker();
+    if (index == kNotAWorker) {
+        index = nextQueue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+        queues_[index]->tasks.push_back({ std::move(task), &group });
+    }
+    queued_.fetch_add(1, std::memory_order_release);
+
+    // Taking the sleep mutex orders this notify after any idle worker has
+    // either seen queued_ > 0 or started waiting.
+    { std::lock_guard<std::mutex> lock(sleepMutex_); }
+    wake_.notify_one();
+}
+
+bool TaskPool::popLocal(size_t index, Task& task) {
+    WorkerQueue& queue = *queues_[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) return false;
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    queued_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool TaskPool::steal(size_t thief, Task& task) {
+    size_t count = queues_.size();
+    size_t start = thief == kNotAWorker ? 0 : thief + 1;
+    for (size_t k = 0; k < count; ++k) {
+        size_t victim = (start + k) % count;
+        if (victim == thief) continue;
+
+        WorkerQueue& queue = *queues_[victim];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) continue;
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        queued_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+bool TaskPool::tryRunOne(size_t self) {
+    Task task;
+    if ((self != kNotAWorker && popLocal(self, task)) || steal(self, task)) {
+        execute(task);
+        return true;
+    }
+    return false;
+}
+
+void TaskPool::execute(Task& task) {
+    try {
+        task.fn();
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(task.group->errorMutex_);
+        if (!task.group->error_) task.group->error_ = std::current_exception();
+    }
+    task.group->pending_.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void TaskPool::wait(TaskGroup& group) {
+    size_t self = currentWorker();
+    while (group.pending_.load(std::memory_order_acquire) > 0) {
+        if (!tryRunOne(self)) {
+            std::this_thread::yield();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(group.errorMutex_);
+    if (group.error_) {
+        std::exception_ptr error = group.error_;
+        group.error_ = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void TaskPool::workerLoop(size_t index) {
+    tlsPool = this;
+    tlsWorker = index;
+
+    while (true) {
+        if (tryRunOne(index)) continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        wake_.wait(lock, [this] {
+            return stopping_.load() || queued_.load(std::memory_order_acquire) > 0;
+        });
+        if (stopping_ && queued_.load() == 0) return;
+    }
+}
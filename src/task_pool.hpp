@@ -0,0 +1,118 @@
+/**
+ * @file task_pool.hpp
+ * @brief Work-stealing task pool for fork-join recursion
+ *
+ * @section description Description
+ * Defines TaskPool, a fixed set of worker threads that each own a task deque.
+ * A worker pushes and pops its own deque at the back (newest first, which
+ * keeps recursive subproblems cache-warm) and steals from the front of other
+ * workers' deques when it runs dry. Threads waiting on a TaskGroup execute
+ * queued tasks instead of blocking, so nested fork-join recursion cannot
+ * deadlock the pool.
+ *
+ * @section usage Usage
+ * TaskPool pool(4);
+ * TaskPool::TaskGroup group;
+ * pool.run(group, [&] { left = solve(a); });
+ * right = solve(b);
+ * pool.wait(group);
+ */
+
+#ifndef TASK_POOL_HPP
+#define TASK_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class TaskPool
+ * @brief Fixed-size pool of worker threads with per-worker stealing deques
+ */
+class TaskPool {
+public:
+    /**
+     * @class TaskGroup
+     * @brief Set of tasks that a caller waits on together
+     */
+    class TaskGroup {
+    public:
+        TaskGroup() = default;
+        TaskGroup(const TaskGroup&) = delete;
+        TaskGroup& operator=(const TaskGroup&) = delete;
+
+    private:
+        friend class TaskPool;
+        std::atomic<size_t> pending_{ 0 };  ///< Tasks submitted but not finished
+        std::mutex errorMutex_;             ///< Guards error_
+        std::exception_ptr error_;          ///< First exception thrown by a task
+    };
+
+    /**
+     * @brief Starts the worker threads
+     * @param threadCount Number of workers; 0 uses the hardware concurrency
+     */
+    explicit TaskPool(unsigned threadCount = 0);
+
+    /**
+     * @brief Finishes all queued tasks and joins the workers
+     */
+    ~TaskPool();
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    /**
+     * @brief Number of worker threads (callers of wait() help in addition)
+     */
+    unsigned threadCount() const { return static_cast<unsigned>(workers_.size()); }
+
+    /**
+     * @brief Queues a task as part of a group
+     * @param group Group the task belongs to
+     * @param task Work to run on some pool thread
+     */
+    void run(TaskGroup& group, std::function<void()> task);
+
+    /**
+     * @brief Runs queued tasks until every task of the group has finished
+     * @param group Group to wait for
+     * @throws Rethrows the first exception raised by a task of the group
+     */
+    void wait(TaskGroup& group);
+
+private:
+    struct Task {
+        std::function<void()> fn;
+        TaskGroup* group = nullptr;
+    };
+
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    bool popLocal(size_t index, Task& task);
+    bool steal(size_t thief, Task& task);
+    bool tryRunOne(size_t self);
+    void execute(Task& task);
+    void workerLoop(size_t index);
+    size_t currentWorker() const;
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;  ///< One deque per worker
+    std::vector<std::thread> workers_;                  ///< Worker threads
+    std::mutex sleepMutex_;                             ///< Guards idle sleeping
+    std::condition_variable wake_;                      ///< Signalled when work is queued
+    std::atomic<size_t> queued_{ 0 };                   ///< Tasks sitting in any deque
+    std::atomic<size_t> nextQueue_{ 0 };                ///< Round-robin slot for external submits
+    std::atomic<bool> stopping_{ false };               ///< Set by the destructor
+};
+
+#endif
@@ -23,112 +23,1651 @@
  */
 
 #include "transport.hpp"
+#include "alloc_stats.hpp"
+#include "counter_rng.hpp"
+#include "instrumentation.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <stdexcept>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if defined(__linux__)
+#include <fcntl.h>
+#endif
 
-SingaporeTransportOptimizer::SingaporeTransportOptimizer(int network_size)
-    : networkSize_(network_size) {
+TransportMatrix::TransportMatrix(size_t rows, size_t cols, int fill)
+    : rows_(rows), cols_(cols), data_(rows * cols, fill) {
 }
 
-int SingaporeTransportOptimizer::baseOptimization(const std::vector<std::vector<int>>& subnetwork) {
-    if (subnetwork.empty() || subnetwork[0].empty()) {
+TransportMatrix::TransportMatrix(const std::vector<std::vector<int>>& network)
+    : rows_(network.size()), cols_(network.empty() ? 0 : network[0].size()) {
+    data_.reserve(rows_ * cols_);
+    for (const auto& row : network) {
+        if (row.size() != cols_) {
+            throw std::invalid_argument("TransportMatrix: network rows must all have the same length");
+        }
+        data_.insert(data_.end(), row.begin(), row.end());
+    }
+}
+
+std::vector<std::vector<int>> TransportMatrix::toNested() const {
+    std::vector<std::vector<int>> nested(rows_);
+    for (size_t i = 0; i < rows_; ++i) {
+        nested[i].assign(data_.begin() + i * cols_, data_.begin() + (i + 1) * cols_);
+    }
+    return nested;
+}
+
+namespace {
+
+/**
+ * @brief Spreads the low 32 bits of x so that bit k moves to bit 2k
+ */
+std::uint64_t spreadBits(std::uint64_t x) {
+    x &= 0xFFFFFFFFull;
+    x = (x | (x << 16)) & 0x0000FFFF0000FFFFull;
+    x = (x | (x << 8)) & 0x00FF00FF00FF00FFull;
+    x = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0Full;
+    x = (x | (x << 2)) & 0x3333333333333333ull;
+    x = (x | (x << 1)) & 0x5555555555555555ull;
+    return x;
+}
+
+/**
+ * @brief Inverse of spreadBits: gathers the even bits of x
+ */
+std::uint64_t compactBits(std::uint64_t x) {
+    x &= 0x5555555555555555ull;
+    x = (x | (x >> 1)) & 0x3333333333333333ull;
+    x = (x | (x >> 2)) & 0x0F0F0F0F0F0F0F0Full;
+    x = (x | (x >> 4)) & 0x00FF00FF00FF00FFull;
+    x = (x | (x >> 8)) & 0x0000FFFF0000FFFFull;
+    x = (x | (x >> 16)) & 0x00000000FFFFFFFFull;
+    return x;
+}
+
+/**
+ * @brief Z-order index of tile (row, col); the row bit is the high bit of
+ *        each pair so that NE, NW, SE, SW come out as 0, 1, 2, 3
+ */
+size_t mortonIndex(size_t row, size_t col) {
+    return static_cast<size_t>((spreadBits(row) << 1) | spreadBits(col));
+}
+
+bool isPowerOfTwo(size_t n) {
+    return n != 0 && (n & (n - 1)) == 0;
+}
+
+} // namespace
+
+MortonMatrix::MortonMatrix(const MatrixView& network, size_t tileSize)
+    : size_(network.rows) {
+    if (network.rows != network.cols) {
+        throw std::invalid_argument("MortonMatrix: network must be square");
+    }
+    if (size_ == 0) {
+        return;
+    }
+    if (!isPowerOfTwo(size_)) {
+        throw std::invalid_argument("MortonMatrix: network size must be a power of 2");
+    }
+
+    tileSize_ = 1;
+    while (tileSize_ * 2 <= tileSize && tileSize_ * 2 <= size_) {
+        tileSize_ *= 2;
+    }
+
+    // Write the tiles in storage order; each tile row is one contiguous copy.
+    data_.resize(size_ * size_);
+    size_t tilesPerSide = size_ / tileSize_;
+    int* out = data_.data();
+    for (size_t index = 0; index < tilesPerSide * tilesPerSide; ++index) {
+        size_t r0 = static_cast<size_t>(compactBits(index >> 1)) * tileSize_;
+        size_t c0 = static_cast<size_t>(compactBits(index)) * tileSize_;
+        for (size_t i = 0; i < tileSize_; ++i) {
+            const int* row = network.row(r0 + i) + c0;
+            out = std::copy(row, row + tileSize_, out);
+        }
+    }
+}
+
+int MortonMatrix::operator()(size_t i, size_t j) const {
+    size_t index = mortonIndex(i / tileSize_, j / tileSize_);
+    return data_[index * tileSize_ * tileSize_ + (i % tileSize_) * tileSize_ + (j % tileSize_)];
+}
+
+TransportMatrix MortonMatrix::toRowMajor() const {
+    TransportMatrix matrix(size_, size_);
+    size_t tilesPerSide = tileSize_ == 0 ? 0 : size_ / tileSize_;
+    for (size_t index = 0; index < tilesPerSide * tilesPerSide; ++index) {
+        size_t r0 = static_cast<size_t>(compactBits(index >> 1)) * tileSize_;
+        size_t c0 = static_cast<size_t>(compactBits(index)) * tileSize_;
+        MatrixView source = tile(index);
+        for (size_t i = 0; i < tileSize_; ++i) {
+            std::copy(source.row(i), source.row(i) + tileSize_, &matrix(r0 + i, c0));
+        }
+    }
+    return matrix;
+}
+
+SparseTransportMatrix::SparseTransportMatrix(size_t rows, size_t cols, std::vector<SparseLink> links)
+    : rows_(rows), cols_(cols), links_(std::move(links)) {
+    const size_t maxIndex = static_cast<size_t>(UINT32_MAX) + 1;
+    if (rows_ > maxIndex || cols_ > maxIndex) {
+        throw std::invalid_argument("SparseTransportMatrix: dimensions must fit in 32-bit indices");
+    }
+    for (const SparseLink& link : links_) {
+        if (link.row >= rows_ || link.col >= cols_) {
+            throw std::out_of_range("SparseTransportMatrix: link outside the network");
+        }
+    }
+
+    std::sort(links_.begin(), links_.end(), [](const SparseLink& a, const SparseLink& b) {
+        return a.row != b.row ? a.row < b.row : a.col < b.col;
+    });
+
+    // Sum duplicate cells and drop zeros in one compaction pass.
+    size_t out = 0;
+    for (size_t k = 0; k < links_.size();) {
+        SparseLink merged = links_[k];
+        for (++k; k < links_.size() && links_[k].row == merged.row && links_[k].col == merged.col; ++k) {
+            merged.weight += links_[k].weight;
+        }
+        if (merged.weight != 0) {
+            links_[out++] = merged;
+        }
+    }
+    links_.resize(out);
+    links_.shrink_to_fit();
+}
+
+SparseTransportMatrix SparseTransportMatrix::fromDense(const MatrixView& network) {
+    std::vector<SparseLink> links;
+    for (size_t i = 0; i < network.rows; ++i) {
+        const int* row = network.row(i);
+        for (size_t j = 0; j < network.cols; ++j) {
+            if (row[j] != 0) {
+                links.push_back({ static_cast<std::uint32_t>(i), static_cast<std::uint32_t>(j), row[j] });
+            }
+        }
+    }
+    return SparseTransportMatrix(network.rows, network.cols, std::move(links));
+}
+
+TransportMatrix SparseTransportMatrix::toDense() const {
+    TransportMatrix matrix(rows_, cols_);
+    for (const SparseLink& link : links_) {
+        matrix(link.row, link.col) = link.weight;
+    }
+    return matrix;
+}
+
+NetworkBatch::NetworkBatch(size_t count, size_t rows, size_t cols, BatchLayout layout)
+    : count_(count), rows_(rows), cols_(cols), layout_(layout), data_(count * rows * cols, 0) {
+}
+
+NetworkBatch NetworkBatch::fromNetworks(const std::vector<TransportMatrix>& networks, BatchLayout layout) {
+    size_t rows = networks.empty() ? 0 : networks[0].rows();
+    size_t cols = networks.empty() ? 0 : networks[0].cols();
+    NetworkBatch batch(networks.size(), rows, cols, layout);
+    for (size_t k = 0; k < networks.size(); ++k) {
+        batch.setSnapshot(k, networks[k].view());
+    }
+    return batch;
+}
+
+void NetworkBatch::setSnapshot(size_t snapshot, const MatrixView& network) {
+    if (snapshot >= count_) {
+        throw std::out_of_range("NetworkBatch: snapshot index out of range");
+    }
+    if (network.rows != rows_ || network.cols != cols_) {
+        throw std::invalid_argument("NetworkBatch: every snapshot must have the batch's shape");
+    }
+    for (size_t i = 0; i < rows_; ++i) {
+        const int* row = network.row(i);
+        if (layout_ == BatchLayout::Planar) {
+            std::copy(row, row + cols_, &data_[index(snapshot, i, 0)]);
+            continue;
+        }
+        for (size_t j = 0; j < cols_; ++j) {
+            data_[index(snapshot, i, j)] = row[j];
+        }
+    }
+}
+
+TransportMatrix NetworkBatch::snapshot(size_t snapshot) const {
+    if (snapshot >= count_) {
+        throw std::out_of_range("NetworkBatch: snapshot index out of range");
+    }
+    TransportMatrix matrix(rows_, cols_);
+    for (size_t i = 0; i < rows_; ++i) {
+        for (size_t j = 0; j < cols_; ++j) {
+            matrix(i, j) = data_[index(snapshot, i, j)];
+        }
+    }
+    return matrix;
+}
+
+SingaporeTransportOptimizer::SingaporeTransportOptimizer(int network_size, std::pmr::memory_resource* resource)
+    : networkSize_(network_size), resource_(resource) {
+}
+
+std::int64_t SingaporeTransportOptimizer::baseOptimization(const MatrixView& subnetwork) {
+    if (subnetwork.rows == 0 || subnetwork.cols == 0) {
         return 0;
     }
 
-    int sum = 0;
-    for (const auto& row : subnetwork) {
-        for (int val : row) {
-            sum += val;
+    std::int64_t sum = 0;
+    for (size_t i = 0; i < subnetwork.rows; ++i) {
+        const int* row = subnetwork.row(i);
+        for (size_t j = 0; j < subnetwork.cols; ++j) {
+            sum += row[j];
         }
     }
     return sum;
 }
 
-void SingaporeTransportOptimizer::divideIntoRegions(const std::vector<std::vector<int>>& network, std::vector<std::vector<int>>& ne, std::vector<std::vector<int>>& nw, std::vector<std::vector<int>>& se, std::vector<std::vector<int>>& sw) {
-    size_t n = network.size();
-    size_t mid = n / 2;
+void SingaporeTransportOptimizer::divideIntoRegions(const MatrixView& network, MatrixView& ne, MatrixView& nw, MatrixView& se, MatrixView& sw) {
+    // The top and left halves take the extra row/column of an odd dimension.
+    size_t top = (network.rows + 1) / 2;
+    size_t left = (network.cols + 1) / 2;
+    size_t bottom = network.rows - top;
+    size_t right = network.cols - left;
 
-    ne.clear(); nw.clear(); se.clear(); sw.clear();
-    ne.resize(mid, std::vector<int>(mid));
-    nw.resize(mid, std::vector<int>(mid));
-    se.resize(mid, std::vector<int>(mid));
-    sw.resize(mid, std::vector<int>(mid));
+    ne = network.block(0, 0, top, left);
+    nw = network.block(0, left, top, right);
+    se = network.block(top, 0, bottom, left);
+    sw = network.block(top, left, bottom, right);
+}
 
-    for (size_t i = 0; i < mid; ++i) {
-        for (size_t j = 0; j < mid; ++j) {
-            ne[i][j] = network[i][j];
-            nw[i][j] = network[i][j + mid];
-            se[i][j] = network[i + mid][j];
-            sw[i][j] = network[i + mid][j + mid];
+void SingaporeTransportOptimizer::testDivideIntoRegions(const std::vector<std::vector<int>>& network, std::vector<std::vector<int>>& ne, std::vector<std::vector<int>>& nw, std::vector<std::vector<int>>& se, std::vector<std::vector<int>>& sw) {
+    TransportMatrix matrix(network);
+    MatrixView ne_view, nw_view, se_view, sw_view;
+    divideIntoRegions(matrix.view(), ne_view, nw_view, se_view, sw_view);
+
+    auto copyOut = [](const MatrixView& view, std::vector<std::vector<int>>& out) {
+        out.assign(view.rows, std::vector<int>(view.cols));
+        for (size_t i = 0; i < view.rows; ++i) {
+            for (size_t j = 0; j < view.cols; ++j) {
+                out[i][j] = view.at(i, j);
+            }
         }
-    }
+    };
+    copyOut(ne_view, ne);
+    copyOut(nw_view, nw);
+    copyOut(se_view, se);
+    copyOut(sw_view, sw);
 }
 
-int SingaporeTransportOptimizer::combineSolutions(int ne_sol, int nw_sol, int se_sol, int sw_sol, const std::vector<std::vector<int>>& original_network) {
-    int total = ne_sol + nw_sol + se_sol + sw_sol;
+std::int64_t SingaporeTransportOptimizer::combineSolutions(std::int64_t ne_sol, std::int64_t nw_sol, std::int64_t se_sol, std::int64_t sw_sol, const MatrixView& original_network) {
+    std::int64_t total = ne_sol + nw_sol + se_sol + sw_sol;
 
-    size_t n = original_network.size();
+    size_t n = std::min(original_network.rows, original_network.cols);
     for (size_t i = 0; i < n; ++i) {
-        total += original_network[i][i % n];
+        total += original_network.at(i, i);
+    }
+
+    return total;
+}
+
+namespace {
+
+/**
+ * @brief Adds the recursion's per-cell multiplicities for a rows x cols region
+ *
+ * Mirrors optimizeTransport exactly: a base case (a single row or column)
+ * counts each of its cells once, and every larger region counts its own
+ * diagonal once more after recursing into its four ceil/floor quadrants.
+ */
+void accumulateWeights(std::vector<int>& weights, size_t stride, size_t r0, size_t c0, size_t rows, size_t cols) {
+    if (rows <= 1 || cols <= 1) {
+        for (size_t i = 0; i < rows; ++i) {
+            for (size_t j = 0; j < cols; ++j) {
+                weights[(r0 + i) * stride + c0 + j] += 1;
+            }
+        }
+        return;
+    }
+
+    size_t top = (rows + 1) / 2;
+    size_t left = (cols + 1) / 2;
+    accumulateWeights(weights, stride, r0, c0, top, left);
+    accumulateWeights(weights, stride, r0, c0 + left, top, cols - left);
+    accumulateWeights(weights, stride, r0 + top, c0, rows - top, left);
+    accumulateWeights(weights, stride, r0 + top, c0 + left, rows - top, cols - left);
+
+    for (size_t i = 0; i < std::min(rows, cols); ++i) {
+        weights[(r0 + i) * stride + c0 + i] += 1;
+    }
+}
+
+/**
+ * @brief 64-bit dot product of one tile row with its weight row
+ */
+std::int64_t weightedRowSum(const int* row, const int* weights, size_t n) {
+    size_t j = 0;
+#if defined(__AVX2__)
+    __m256i acc = _mm256_setzero_si256();
+    for (; j + 4 <= n; j += 4) {
+        __m256i v = _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + j)));
+        __m256i w = _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + j)));
+        acc = _mm256_add_epi64(acc, _mm256_mul_epi32(v, w)); // signed 32x32 -> 64 per lane
+    }
+    alignas(32) std::int64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+    std::int64_t sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#else
+    // Four independent accumulators let the compiler vectorize the loop.
+    std::int64_t acc0 = 0, acc1 = 0, acc2 = 0, acc3 = 0;
+    for (; j + 4 <= n; j += 4) {
+        acc0 += static_cast<std::int64_t>(row[j]) * weights[j];
+        acc1 += static_cast<std::int64_t>(row[j + 1]) * weights[j + 1];
+        acc2 += static_cast<std::int64_t>(row[j + 2]) * weights[j + 2];
+        acc3 += static_cast<std::int64_t>(row[j + 3]) * weights[j + 3];
+    }
+    std::int64_t sum = acc0 + acc1 + acc2 + acc3;
+#endif
+    for (; j < n; ++j) {
+        sum += static_cast<std::int64_t>(row[j]) * weights[j];
+    }
+    return sum;
+}
+
+/**
+ * @brief Adds each cell's weight times every snapshot lane of an
+ *        interleaved batch into the per-snapshot scores
+ * @param partial Scratch of one double per lane
+ *
+ * Lanes accumulate in doubles, which vectorize on every x86-64 target
+ * (unlike 64-bit integer multiplies): each product is below 2^31 * 2^7 and
+ * a chunk sums at most 2^12 of them, so the partial sums stay under 2^53
+ * and are exact when flushed into the 64-bit scores.
+ */
+void accumulateInterleaved(std::int64_t* scores, double* partial, const int* cells,
+                           const std::uint8_t* weights, size_t count, size_t lanes) {
+    const size_t chunk = 4096;
+    for (size_t c0 = 0; c0 < count; c0 += chunk) {
+        std::fill(partial, partial + lanes, 0.0);
+        for (size_t c = c0; c < std::min(count, c0 + chunk); ++c) {
+            double weight = weights[c];
+            const int* lane = cells + c * lanes;
+            for (size_t k = 0; k < lanes; ++k) {
+                partial[k] += weight * lane[k];
+            }
+        }
+        for (size_t k = 0; k < lanes; ++k) {
+            scores[k] += static_cast<std::int64_t>(partial[k]);
+        }
+    }
+}
+
+/**
+ * @brief 64-bit dot product of one planar snapshot with the cell weights
+ */
+std::int64_t weightedSum(const int* cells, const std::uint8_t* weights, size_t count) {
+    std::int64_t acc0 = 0, acc1 = 0, acc2 = 0, acc3 = 0;
+    size_t c = 0;
+    for (; c + 4 <= count; c += 4) {
+        acc0 += static_cast<std::int64_t>(cells[c]) * weights[c];
+        acc1 += static_cast<std::int64_t>(cells[c + 1]) * weights[c + 1];
+        acc2 += static_cast<std::int64_t>(cells[c + 2]) * weights[c + 2];
+        acc3 += static_cast<std::int64_t>(cells[c + 3]) * weights[c + 3];
+    }
+    for (; c < count; ++c) {
+        acc0 += static_cast<std::int64_t>(cells[c]) * weights[c];
+    }
+    return acc0 + acc1 + acc2 + acc3;
+}
+
+} // namespace
+
+const std::vector<int>& SingaporeTransportOptimizer::leafWeights(size_t rows, size_t cols) {
+    auto it = leafWeights_.find({ rows, cols });
+    if (it == leafWeights_.end()) {
+        std::vector<int> weights(rows * cols, 0);
+        accumulateWeights(weights, cols, 0, 0, rows, cols);
+        it = leafWeights_.emplace(std::make_pair(rows, cols), std::move(weights)).first;
     }
+    return it->second;
+}
+
+void SingaporeTransportOptimizer::prepareLeafWeights(size_t rows, size_t cols) {
+    // Walk the recursion a level at a time, keeping each distinct region
+    // shape once: lengths on one level differ by at most one, so a level
+    // holds at most four shapes.
+    std::vector<std::pair<size_t, size_t>> level = { { rows, cols } };
+    while (!level.empty()) {
+        std::vector<std::pair<size_t, size_t>> next;
+        for (const auto& shape : level) {
+            size_t r = shape.first;
+            size_t c = shape.second;
+            if (r <= 1 || c <= 1) {
+                continue;  // base case, no tile weights
+            }
+            // Above the grain the parallel recursion splits even tile-sized regions.
+            if (r <= tileSize_ && c <= tileSize_ && std::max(r, c) <= parallelGrain_) {
+                leafWeights(r, c);
+                continue;
+            }
+            size_t top = (r + 1) / 2;
+            size_t left = (c + 1) / 2;
+            for (const auto& child : { std::make_pair(top, left), std::make_pair(top, c - left),
+                                       std::make_pair(r - top, left), std::make_pair(r - top, c - left) }) {
+                if (std::find(next.begin(), next.end(), child) == next.end()) {
+                    next.push_back(child);
+                }
+            }
+        }
+        level.swap(next);
+    }
+}
+
+std::int64_t SingaporeTransportOptimizer::tileOptimization(const MatrixView& tile) {
+    const std::vector<int>& weights = leafWeights(tile.rows, tile.cols);
 
+    std::int64_t total = 0;
+    for (size_t i = 0; i < tile.rows; ++i) {
+        total += weightedRowSum(tile.row(i), weights.data() + i * tile.cols, tile.cols);
+    }
     return total;
 }
 
-int SingaporeTransportOptimizer::optimizeTransport(const std::vector<std::vector<int>>& network) {
-    size_t n = network.size();
+std::int64_t SingaporeTransportOptimizer::optimizeTransport(const std::vector<std::vector<int>>& network) {
+    ALGO_SPAN("transport.optimize_nested");
+    size_t rows = network.size();
+    size_t cols = network.empty() ? 0 : network[0].size();
+    std::pmr::vector<int> flat(resource_);
+    flat.reserve(rows * cols);
+    for (const auto& row : network) {
+        if (row.size() != cols) {
+            throw std::invalid_argument("TransportMatrix: network rows must all have the same length");
+        }
+        flat.insert(flat.end(), row.begin(), row.end());
+    }
+    bytesCopied_ += rows * cols * sizeof(int);
+    return optimizeTransport(MatrixView{ flat.data(), 0, rows, cols, cols });
+}
 
-    if (n <= 1) {
+std::int64_t SingaporeTransportOptimizer::optimizeTransport(const TransportMatrix& network) {
+    ALGO_SPAN("transport.optimize");
+    return optimizeTransport(network.view());
+}
+
+std::int64_t SingaporeTransportOptimizer::optimizeTransport(const MatrixView& network) {
+    ALGO_DEPTH("transport.optimize");
+    if (network.rows <= 1 || network.cols <= 1) {
         return baseOptimization(network);
     }
+    if (network.rows <= tileSize_ && network.cols <= tileSize_) {
+        return tileOptimization(network);
+    }
+
+    MatrixView ne, nw, se, sw;
+    divideIntoRegions(network, ne, nw, se, sw);
+
+    std::int64_t ne_solution = optimizeTransport(ne);
+    std::int64_t nw_solution = optimizeTransport(nw);
+    std::int64_t se_solution = optimizeTransport(se);
+    std::int64_t sw_solution = optimizeTransport(sw);
+
+    return combineSolutions(ne_solution, nw_solution, se_solution, sw_solution, network);
+}
+
+std::int64_t SingaporeTransportOptimizer::optimizeTransport(const MortonMatrix& network) {
+    ALGO_SPAN("transport.optimize_morton");
+    struct Partial {
+        std::int64_t score;  ///< Recursion result for the region
+        std::int64_t trace;  ///< Sum of the region's diagonal
+    };
+
+    size_t tiles = network.tileCount();
+    if (tiles == 0) {
+        return 0;
+    }
+
+    // At most three finished siblings wait on each level of the quadtree.
+    std::pmr::vector<Partial> pending(resource_);
+    pending.reserve(3 * 32 + 1);
+
+    for (size_t index = 0; index < tiles; ++index) {
+        MatrixView tile = network.tile(index);
+        std::int64_t diagonal = 0;
+        for (size_t i = 0; i < tile.rows; ++i) {
+            diagonal += tile.at(i, i);
+        }
+        pending.push_back({ tileOptimization(tile), diagonal });
+
+        // Every fourth completed region closes a group of NE, NW, SE, SW
+        // siblings; fold them into their parent, then check the next level up.
+        for (size_t done = index + 1; done % 4 == 0; done /= 4) {
+            Partial sw = pending.back(); pending.pop_back();
+            Partial se = pending.back(); pending.pop_back();
+            Partial nw = pending.back(); pending.pop_back();
+            Partial ne = pending.back(); pending.pop_back();
+            std::int64_t trace = ne.trace + sw.trace;
+            pending.push_back({ ne.score + nw.score + se.score + sw.score + trace, trace });
+        }
+    }
+    return pending.back().score;
+}
+
+std::int64_t SingaporeTransportOptimizer::optimizeTransport(const SparseTransportMatrix& network) {
+    ALGO_SPAN("transport.optimize_sparse");
+    ALGO_COUNT("transport.sparse_links", network.links().size());
+    std::pmr::vector<SparseLink> links(network.links().begin(), network.links().end(), resource_);
+    return sparseOptimization(links.data(), links.data() + links.size(),
+        0, 0, network.rows(), network.cols());
+}
+
+std::int64_t SingaporeTransportOptimizer::sparseOptimization(SparseLink* first, SparseLink* last,
+    size_t r0, size_t c0, size_t rows, size_t cols) {
+    if (first == last) {
+        return 0;  // empty region: every cell, and so its diagonal, is zero
+    }
+
+    std::int64_t total = 0;
+    if (rows <= 1 || cols <= 1) {
+        for (SparseLink* link = first; link != last; ++link) {
+            total += link->weight;
+        }
+        return total;
+    }
+
+    for (SparseLink* link = first; link != last; ++link) {
+        if (link->row - r0 == link->col - c0) {
+            total += link->weight;
+        }
+    }
+
+    size_t top = (rows + 1) / 2;
+    size_t left = (cols + 1) / 2;
+    SparseLink* bottomStart = std::partition(first, last, [&](const SparseLink& link) { return link.row < r0 + top; });
+    SparseLink* nwStart = std::partition(first, bottomStart, [&](const SparseLink& link) { return link.col < c0 + left; });
+    SparseLink* swStart = std::partition(bottomStart, last, [&](const SparseLink& link) { return link.col < c0 + left; });
+
+    total += sparseOptimization(first, nwStart, r0, c0, top, left);
+    total += sparseOptimization(nwStart, bottomStart, r0, c0 + left, top, cols - left);
+    total += sparseOptimization(bottomStart, swStart, r0 + top, c0, rows - top, left);
+    total += sparseOptimization(swStart, last, r0 + top, c0 + left, rows - top, cols - left);
+    return total;
+}
+
+std::vector<std::int64_t> SingaporeTransportOptimizer::optimizeTransportBatch(const NetworkBatch& batch) {
+    ALGO_SPAN("transport.optimize_batch");
+    ALGO_COUNT("transport.batch_snapshots", batch.count());
+    const size_t count = batch.count();
+    const size_t cells = batch.rows() * batch.cols();
+    std::vector<std::int64_t> scores(count, 0);
+    if (count == 0 || cells == 0) {
+        return scores;
+    }
+
+    const std::uint8_t* weights = batchWeights(batch.rows(), batch.cols()).data();
+    if (batch.layout() == BatchLayout::Interleaved) {
+        std::pmr::vector<double> partial(count, resource_);
+        accumulateInterleaved(scores.data(), partial.data(), batch.data(), weights, cells, count);
+    } else {
+        for (size_t k = 0; k < count; ++k) {
+            scores[k] = weightedSum(batch.data() + k * cells, weights, cells);
+        }
+    }
+    return scores;
+}
+
+const std::vector<std::uint8_t>& SingaporeTransportOptimizer::batchWeights(size_t rows, size_t cols) {
+    if (batchWeightsShape_ != std::make_pair(rows, cols)) {
+        batchWeights_.assign(rows * cols, 0);
+        fillBatchWeights(batchWeights_.data(), cols, 0, 0, rows, cols);
+        batchWeightsShape_ = { rows, cols };
+    }
+    return batchWeights_;
+}
+
+void SingaporeTransportOptimizer::fillBatchWeights(std::uint8_t* weights, size_t stride,
+    size_t r0, size_t c0, size_t rows, size_t cols) {
+    if (rows <= 1 || cols <= 1 || (rows <= tileSize_ && cols <= tileSize_)) {
+        // A single row or column has all-ones weights, so it shares the leaf path.
+        const std::vector<int>& leaf = leafWeights(rows, cols);
+        for (size_t i = 0; i < rows; ++i) {
+            std::copy(leaf.begin() + i * cols, leaf.begin() + (i + 1) * cols, weights + (r0 + i) * stride + c0);
+        }
+        return;
+    }
+
+    size_t top = (rows + 1) / 2;
+    size_t left = (cols + 1) / 2;
+    fillBatchWeights(weights, stride, r0, c0, top, left);
+    fillBatchWeights(weights, stride, r0, c0 + left, top, cols - left);
+    fillBatchWeights(weights, stride, r0 + top, c0, rows - top, left);
+    fillBatchWeights(weights, stride, r0 + top, c0 + left, rows - top, cols - left);
+
+    for (size_t i = 0; i < std::min(rows, cols); ++i) {
+        weights[(r0 + i) * stride + c0 + i] += 1;
+    }
+}
+
+namespace {
+
+const char kTiledMagic[8] = { 'S', 'G', 'T', 'I', 'L', 'E', 'S', '1' };
+const size_t kTiledHeaderBytes = sizeof(kTiledMagic) + 3 * sizeof(std::uint64_t);
+const size_t kTiledIoBuffer = 1 << 20;  // stdio buffer; the OS read-ahead does the rest
+
+bool isTiledLeaf(size_t rows, size_t cols, size_t tileSize) {
+    return rows <= 1 || cols <= 1 || (rows <= tileSize && cols <= tileSize);
+}
+
+/**
+ * @brief Calls visit(r0, c0, rows, cols) for every leaf in recursion order
+ */
+template <typename Visit>
+void forEachTiledLeaf(size_t r0, size_t c0, size_t rows, size_t cols, size_t tileSize, Visit& visit) {
+    if (isTiledLeaf(rows, cols, tileSize)) {
+        visit(r0, c0, rows, cols);
+        return;
+    }
+    size_t top = (rows + 1) / 2;
+    size_t left = (cols + 1) / 2;
+    forEachTiledLeaf(r0, c0, top, left, tileSize, visit);
+    forEachTiledLeaf(r0, c0 + left, top, cols - left, tileSize, visit);
+    forEachTiledLeaf(r0 + top, c0, rows - top, left, tileSize, visit);
+    forEachTiledLeaf(r0 + top, c0 + left, rows - top, cols - left, tileSize, visit);
+}
+
+/**
+ * @brief Closes a stdio file when it goes out of scope
+ */
+struct FileCloser {
+    std::FILE* file;
+    ~FileCloser() { if (file) std::fclose(file); }
+};
+
+} // namespace
+
+void TiledNetworkFile::write(const std::string& path, const MatrixView& network, size_t tileSize) {
+    write(path, network.rows, network.cols, tileSize,
+        [&network](size_t i, size_t j) { return network.at(i, j); });
+}
+
+void TiledNetworkFile::write(const std::string& path, size_t rows, size_t cols, size_t tileSize,
+    const std::function<int(size_t, size_t)>& cell) {
+    ALGO_SPAN("transport.write_tiled_file");
+    tileSize = tileSize < 1 ? 1 : tileSize;
+
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        throw std::runtime_error("TiledNetworkFile: cannot create " + path);
+    }
+    FileCloser closer{ file };
+    std::setvbuf(file, nullptr, _IOFBF, kTiledIoBuffer);
+
+    std::uint64_t header[3] = { rows, cols, tileSize };
+    bool ok = std::fwrite(kTiledMagic, 1, sizeof(kTiledMagic), file) == sizeof(kTiledMagic)
+        && std::fwrite(header, sizeof(std::uint64_t), 3, file) == 3;
+
+    std::vector<int> leaf;
+    auto writeLeaf = [&](size_t r0, size_t c0, size_t leafRows, size_t leafCols) {
+        leaf.resize(leafRows * leafCols);
+        for (size_t i = 0; i < leafRows; ++i) {
+            for (size_t j = 0; j < leafCols; ++j) {
+                leaf[i * leafCols + j] = cell(r0 + i, c0 + j);
+            }
+        }
+        ok = ok && std::fwrite(leaf.data(), sizeof(int), leaf.size(), file) == leaf.size();
+    };
+    if (rows > 0 && cols > 0) {
+        forEachTiledLeaf(0, 0, rows, cols, tileSize, writeLeaf);
+    }
+
+    ok = ok && std::fflush(file) == 0;
+    if (!ok) {
+        throw std::runtime_error("TiledNetworkFile: write failed for " + path);
+    }
+}
+
+TiledNetworkFile::Header TiledNetworkFile::readHeader(const std::string& path) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        throw std::runtime_error("TiledNetworkFile: cannot open " + path);
+    }
+    FileCloser closer{ file };
+
+    char magic[sizeof(kTiledMagic)];
+    std::uint64_t fields[3];
+    if (std::fread(magic, 1, sizeof(magic), file) != sizeof(magic)
+        || std::memcmp(magic, kTiledMagic, sizeof(magic)) != 0
+        || std::fread(fields, sizeof(std::uint64_t), 3, file) != 3
+        || fields[2] == 0) {
+        throw std::runtime_error("TiledNetworkFile: " + path + " is not a tiled network file");
+    }
+    return { static_cast<size_t>(fields[0]), static_cast<size_t>(fields[1]), static_cast<size_t>(fields[2]) };
+}
+
+/**
+ * @brief Open file, leaf buffer and ancestor chain of one streaming run
+ */
+struct SingaporeTransportOptimizer::TiledStream {
+    struct Ancestor {
+        size_t r0, c0;       ///< Top-left cell of the region
+        size_t length;       ///< Diagonal length, min(rows, cols)
+        std::int64_t trace;  ///< Diagonal sum gathered so far
+    };
+
+    std::FILE* file = nullptr;
+    size_t tileSize = 0;
+    std::vector<int> leaf;
+    std::vector<Ancestor> ancestors;
+    TiledFileStats stats;
+};
+
+std::int64_t SingaporeTransportOptimizer::streamRegion(TiledStream& stream, size_t r0, size_t c0, size_t rows, size_t cols) {
+    if (isTiledLeaf(rows, cols, stream.tileSize)) {
+        stream.leaf.resize(rows * cols);
+        if (std::fread(stream.leaf.data(), sizeof(int), stream.leaf.size(), stream.file) != stream.leaf.size()) {
+            throw std::runtime_error("TiledNetworkFile: file is truncated");
+        }
+        stream.stats.bytesRead += stream.leaf.size() * sizeof(int);
+        ++stream.stats.leaves;
+
+        const std::vector<int>& weights = leafWeights(rows, cols);
+        std::int64_t score = 0;
+        for (size_t i = 0; i < rows; ++i) {
+            score += weightedRowSum(stream.leaf.data() + i * cols, weights.data() + i * cols, cols);
+        }
+
+        // Hand each open ancestor the cells of this leaf on its diagonal.
+        for (auto& ancestor : stream.ancestors) {
+            for (size_t i = 0; i < rows; ++i) {
+                size_t d = r0 + i - ancestor.r0;
+                size_t j = ancestor.c0 + d;
+                if (d >= ancestor.length) break;
+                if (j >= c0 && j < c0 + cols) {
+                    ancestor.trace += stream.leaf[i * cols + (j - c0)];
+                }
+            }
+        }
+        return score;
+    }
 
-    std::vector<std::vector<int>> ne, nw, se, sw;
+    stream.ancestors.push_back({ r0, c0, std::min(rows, cols), 0 });
+    size_t top = (rows + 1) / 2;
+    size_t left = (cols + 1) / 2;
+    std::int64_t total = streamRegion(stream, r0, c0, top, left);
+    total += streamRegion(stream, r0, c0 + left, top, cols - left);
+    total += streamRegion(stream, r0 + top, c0, rows - top, left);
+    total += streamRegion(stream, r0 + top, c0 + left, rows - top, cols - left);
+    total += stream.ancestors.back().trace;
+    stream.ancestors.pop_back();
+    return total;
+}
+
+std::int64_t SingaporeTransportOptimizer::optimizeTransportFile(const std::string& path, TiledFileStats* stats) {
+    ALGO_SPAN("transport.optimize_file");
+    auto start = std::chrono::steady_clock::now();
+    TiledNetworkFile::Header header = TiledNetworkFile::readHeader(path);
+
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        throw std::runtime_error("TiledNetworkFile: cannot open " + path);
+    }
+    FileCloser closer{ file };
+    std::setvbuf(file, nullptr, _IOFBF, kTiledIoBuffer);
+#if defined(__linux__)
+    posix_fadvise(fileno(file), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    if (std::fseek(file, static_cast<long>(kTiledHeaderBytes), SEEK_SET) != 0) {
+        throw std::runtime_error("TiledNetworkFile: cannot seek in " + path);
+    }
+
+    TiledStream stream;
+    stream.file = file;
+    stream.tileSize = header.tileSize;
+    stream.stats.bytesRead = kTiledHeaderBytes;
+
+    std::int64_t result = 0;
+    if (header.rows > 0 && header.cols > 0) {
+        result = streamRegion(stream, 0, 0, header.rows, header.cols);
+    }
+
+    stream.stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (stats) {
+        *stats = stream.stats;
+    }
+    return result;
+}
+
+void SingaporeTransportOptimizer::setThreadCount(unsigned threads) {
+    pool_ = std::make_unique<TaskPool>(threads);
+}
+
+std::int64_t SingaporeTransportOptimizer::optimizeTransportParallel(const TransportMatrix& network) {
+    ALGO_SPAN("transport.optimize_parallel");
+    return optimizeTransportParallel(network.view());
+}
+
+std::int64_t SingaporeTransportOptimizer::optimizeTransportParallel(const MatrixView& network) {
+    prepareLeafWeights(network.rows, network.cols);
+    return parallelRegion(network);
+}
+
+std::int64_t SingaporeTransportOptimizer::parallelRegion(const MatrixView& network) {
+    ALGO_DEPTH("transport.optimize_parallel");
+    if (network.rows <= 1 || network.cols <= 1 || std::max(network.rows, network.cols) <= parallelGrain_) {
+        return optimizeTransport(network);
+    }
+    if (!pool_) {
+        setThreadCount(0);
+    }
+
+    MatrixView ne, nw, se, sw;
     divideIntoRegions(network, ne, nw, se, sw);
 
-    int ne_solution = optimizeTransport(ne);
-    int nw_solution = optimizeTransport(nw);
-    int se_solution = optimizeTransport(se);
-    int sw_solution = optimizeTransport(sw);
+    std::int64_t nw_solution = 0, se_solution = 0, sw_solution = 0;
+    TaskPool::TaskGroup group;
+    pool_->run(group, [&] { nw_solution = parallelRegion(nw); });
+    pool_->run(group, [&] { se_solution = parallelRegion(se); });
+    pool_->run(group, [&] { sw_solution = parallelRegion(sw); });
+    std::int64_t ne_solution = 0;
+    try {
+        ne_solution = parallelRegion(ne);
+    } catch (...) {
+        // The queued quadrants write into this frame; let them finish first.
+        try {
+            pool_->wait(group);
+        } catch (...) {
+        }
+        throw;
+    }
+    pool_->wait(group);
 
     return combineSolutions(ne_solution, nw_solution, se_solution, sw_solution, network);
 }
 
+IncrementalTransportOptimizer::IncrementalTransportOptimizer(TransportMatrix network, size_t tileSize)
+    : network_(std::move(network)), tileSize_(tileSize < 1 ? 1 : tileSize) {
+    if (network_.rows() == 0 || network_.cols() == 0) {
+        return;
+    }
+    build(0, 0, network_.rows(), network_.cols(), -1, 0);
+}
+
+const std::vector<int>& IncrementalTransportOptimizer::leafWeights(size_t rows, size_t cols) {
+    auto it = leafWeights_.find({ rows, cols });
+    if (it == leafWeights_.end()) {
+        std::vector<int> weights(rows * cols, 0);
+        accumulateWeights(weights, cols, 0, 0, rows, cols);
+        it = leafWeights_.emplace(std::make_pair(rows, cols), std::move(weights)).first;
+    }
+    return it->second;
+}
+
+int IncrementalTransportOptimizer::build(size_t r0, size_t c0, size_t rows, size_t cols, int parent, int depth) {
+    int index = static_cast<int>(nodes_.size());
+    nodes_.emplace_back();
+    {
+        Node& node = nodes_.back();
+        node.r0 = r0;
+        node.c0 = c0;
+        node.rows = rows;
+        node.cols = cols;
+        node.parent = parent;
+        node.depth = depth;
+    }
+    if (static_cast<size_t>(depth) >= dirtyByDepth_.size()) {
+        dirtyByDepth_.resize(depth + 1);
+    }
+
+    MatrixView region = network_.view().block(r0, c0, rows, cols);
+
+    // Same stopping rule as SingaporeTransportOptimizer::optimizeTransport.
+    if (rows <= 1 || cols <= 1 || (rows <= tileSize_ && cols <= tileSize_)) {
+        const std::vector<int>& weights = leafWeights(rows, cols);
+        std::int64_t score = 0;
+        for (size_t i = 0; i < rows; ++i) {
+            score += weightedRowSum(region.row(i), weights.data() + i * cols, cols);
+        }
+        nodes_[index].score = score;
+        return index;
+    }
+
+    size_t top = (rows + 1) / 2;
+    size_t left = (cols + 1) / 2;
+    // nodes_ may reallocate while children are built, so index rather than hold a reference.
+    int ne = build(r0, c0, top, left, index, depth + 1);
+    int nw = build(r0, c0 + left, top, cols - left, index, depth + 1);
+    int se = build(r0 + top, c0, rows - top, left, index, depth + 1);
+    int sw = build(r0 + top, c0 + left, rows - top, cols - left, index, depth + 1);
+
+    std::int64_t score = nodes_[ne].score + nodes_[nw].score + nodes_[se].score + nodes_[sw].score;
+    for (size_t i = 0; i < std::min(rows, cols); ++i) {
+        score += region.at(i, i);
+    }
+
+    Node& node = nodes_[index];
+    node.children[0] = ne;
+    node.children[1] = nw;
+    node.children[2] = se;
+    node.children[3] = sw;
+    node.score = score;
+    return index;
+}
+
+void IncrementalTransportOptimizer::addDelta(size_t row, size_t col, std::int64_t delta) {
+    int index = 0;
+    while (true) {
+        Node& node = nodes_[index];
+        if (!node.dirty) {
+            node.dirty = true;
+            dirtyByDepth_[node.depth].push_back(index);
+        }
+
+        size_t i = row - node.r0;
+        size_t j = col - node.c0;
+        if (node.children[0] < 0) {
+            node.pending += delta * leafWeights(node.rows, node.cols)[i * node.cols + j];
+            return;
+        }
+
+        // An internal region counts its own diagonal once on top of its children.
+        if (i == j) {
+            node.pending += delta;
+        }
+        size_t top = (node.rows + 1) / 2;
+        size_t left = (node.cols + 1) / 2;
+        index = node.children[(i >= top ? 2 : 0) + (j >= left ? 1 : 0)];
+    }
+}
+
+void IncrementalTransportOptimizer::propagate() {
+    for (size_t depth = dirtyByDepth_.size(); depth-- > 0;) {
+        for (int index : dirtyByDepth_[depth]) {
+            Node& node = nodes_[index];
+            node.score += node.pending;
+            if (node.parent >= 0) {
+                nodes_[node.parent].pending += node.pending;
+            }
+            node.pending = 0;
+            node.dirty = false;
+        }
+        dirtyByDepth_[depth].clear();
+    }
+}
+
+void IncrementalTransportOptimizer::updateEdge(size_t row, size_t col, int weight) {
+    updateEdges({ { row, col, weight } });
+}
+
+void IncrementalTransportOptimizer::updateEdges(const std::vector<EdgeUpdate>& updates) {
+    ALGO_SPAN("transport.incremental_update");
+    ALGO_COUNT("transport.incremental_updates", updates.size());
+    for (const EdgeUpdate& update : updates) {
+        if (update.row >= network_.rows() || update.col >= network_.cols()) {
+            throw std::out_of_range("IncrementalTransportOptimizer: edge outside the network");
+        }
+    }
+
+    for (const EdgeUpdate& update : updates) {
+        int& cell = network_(update.row, update.col);
+        std::int64_t delta = static_cast<std::int64_t>(update.weight) - cell;
+        cell = update.weight;
+        if (delta != 0) {
+            addDelta(update.row, update.col, delta);
+        }
+    }
+    propagate();
+}
+
+namespace {
+
+/**
+ * @brief splitmix64 finalizer: a bijective 64-bit mix
+ */
+std::uint64_t mix64(std::uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBull;
+    x ^= x >> 31;
+    return x;
+}
+
+const std::uint64_t kFingerprintSeedLo = 0x9E3779B97F4A7C15ull;
+const std::uint64_t kFingerprintSeedHi = 0xC2B2AE3D27D4EB4Full;
+
+} // namespace
+
+/**
+ * @brief Overrides for the regions a scenario changes
+ *
+ * Keyed by node index; nodes without an entry keep the base fingerprint,
+ * trace and cells.
+ */
+struct MemoizedTransportOptimizer::Scenario {
+    struct Region {
+        Fingerprint fingerprint;
+        std::int64_t trace = 0;
+        TransportMatrix cells;  ///< Patched copy of a leaf's cells
+    };
+    std::unordered_map<int, Region> regions;
+};
+
+MemoizedTransportOptimizer::MemoizedTransportOptimizer(size_t capacity, size_t tileSize)
+    : capacity_(capacity < 1 ? 1 : capacity), tileSize_(tileSize < 1 ? 1 : tileSize) {}
+
+std::int64_t MemoizedTransportOptimizer::optimizeTransport(const TransportMatrix& network) {
+    return optimizeTransport(network.view());
+}
+
+std::int64_t MemoizedTransportOptimizer::optimizeTransport(const MatrixView& network) {
+    ALGO_SPAN("transport.memo_optimize");
+    bool sameShape = hasBase_ && base_.rows() == network.rows && base_.cols() == network.cols;
+    hasBase_ = true;
+    if (base_.rows() != network.rows || base_.cols() != network.cols) {
+        base_ = TransportMatrix(network.rows, network.cols);
+    }
+    for (size_t i = 0; i < network.rows; ++i) {
+        std::copy(network.row(i), network.row(i) + network.cols, base_.data() + i * network.cols);
+    }
+    if (network.rows == 0 || network.cols == 0) {
+        nodes_.clear();
+        return 0;
+    }
+
+    if (!sameShape) {
+        nodes_.clear();
+        build(0, 0, network.rows, network.cols);
+    }
+    fingerprintBase(0);
+    return evaluate(0, nullptr);
+}
+
+const std::vector<int>& MemoizedTransportOptimizer::leafWeights(size_t rows, size_t cols) {
+    auto it = leafWeights_.find({ rows, cols });
+    if (it == leafWeights_.end()) {
+        std::vector<int> weights(rows * cols, 0);
+        accumulateWeights(weights, cols, 0, 0, rows, cols);
+        it = leafWeights_.emplace(std::make_pair(rows, cols), std::move(weights)).first;
+    }
+    return it->second;
+}
+
+int MemoizedTransportOptimizer::build(size_t r0, size_t c0, size_t rows, size_t cols) {
+    int index = static_cast<int>(nodes_.size());
+    nodes_.emplace_back();
+    {
+        Node& node = nodes_.back();
+        node.r0 = r0;
+        node.c0 = c0;
+        node.rows = rows;
+        node.cols = cols;
+    }
+
+    // Same stopping rule as SingaporeTransportOptimizer::optimizeTransport.
+    if (rows <= 1 || cols <= 1 || (rows <= tileSize_ && cols <= tileSize_)) {
+        // Key j of each lane depends only on j, so growing the key sets for a
+        // wider leaf leaves every cached fingerprint valid.
+        for (size_t key = loKeys_.size(); key < cols; ++key) {
+            loKeys_.push_back(static_cast<std::uint32_t>(mix64(kFingerprintSeedLo * (key + 1))) | 1u);
+            hiKeys_.push_back(static_cast<std::uint32_t>(mix64(kFingerprintSeedHi * (key + 1))) | 1u);
+        }
+        return index;
+    }
+
+    size_t top = (rows + 1) / 2;
+    size_t left = (cols + 1) / 2;
+    // nodes_ may reallocate while children are built, so index rather than hold a reference.
+    int ne = build(r0, c0, top, left);
+    int nw = build(r0, c0 + left, top, cols - left);
+    int se = build(r0 + top, c0, rows - top, left);
+    int sw = build(r0 + top, c0 + left, rows - top, cols - left);
+
+    Node& node = nodes_[index];
+    node.children[0] = ne;
+    node.children[1] = nw;
+    node.children[2] = se;
+    node.children[3] = sw;
+    return index;
+}
+
+MemoizedTransportOptimizer::Fingerprint MemoizedTransportOptimizer::leafFingerprint(const MatrixView& leaf) const {
+    // Multilinear hash of each row under two independent key sets, chained
+    // row by row through mix64.
+    Fingerprint fp;
+    fp.rows = leaf.rows;
+    fp.cols = leaf.cols;
+    fp.lo = mix64(kFingerprintSeedLo ^ (leaf.rows * 0x100000001B3ull + leaf.cols));
+    fp.hi = mix64(kFingerprintSeedHi ^ (leaf.cols * 0x100000001B3ull + leaf.rows));
+    const std::uint32_t* loKeys = loKeys_.data();
+    const std::uint32_t* hiKeys = hiKeys_.data();
+    for (size_t i = 0; i < leaf.rows; ++i) {
+        const int* row = leaf.row(i);
+        std::uint64_t lo = 0, hi = 0;
+        for (size_t j = 0; j < leaf.cols; ++j) {
+            // 32 x 32 -> 64-bit products vectorize (pmuludq) where 64-bit ones do not.
+            std::uint64_t cell = static_cast<std::uint32_t>(row[j]);
+            lo += loKeys[j] * cell;
+            hi += hiKeys[j] * cell;
+        }
+        fp.lo = mix64(fp.lo + lo);
+        fp.hi = mix64(fp.hi ^ hi);
+    }
+    return fp;
+}
+
+MemoizedTransportOptimizer::Fingerprint
+MemoizedTransportOptimizer::parentFingerprint(const Node& node, const Fingerprint* children) const {
+    // The children's fingerprints cover every cell of the region, the
+    // diagonal included, so together with the shape they identify it.
+    Fingerprint fp;
+    fp.rows = node.rows;
+    fp.cols = node.cols;
+    fp.lo = mix64(kFingerprintSeedHi ^ (node.rows * 0x100000001B3ull + node.cols));
+    fp.hi = mix64(kFingerprintSeedLo ^ (node.cols * 0x100000001B3ull + node.rows));
+    for (int k = 0; k < 4; ++k) {
+        fp.lo = mix64(fp.lo + children[k].lo);
+        fp.hi = mix64(fp.hi ^ children[k].hi);
+    }
+    return fp;
+}
+
+void MemoizedTransportOptimizer::fingerprintBase(int index) {
+    Node& node = nodes_[index];
+    MatrixView region = base_.view().block(node.r0, node.c0, node.rows, node.cols);
+    if (node.children[0] < 0) {
+        node.fingerprint = leafFingerprint(region);
+        return;
+    }
+
+    Fingerprint children[4];
+    for (int k = 0; k < 4; ++k) {
+        fingerprintBase(node.children[k]);
+        children[k] = nodes_[node.children[k]].fingerprint;
+    }
+    std::int64_t trace = 0;
+    for (size_t i = 0; i < std::min(node.rows, node.cols); ++i) {
+        trace += region.at(i, i);
+    }
+    node.trace = trace;
+    node.fingerprint = parentFingerprint(node, children);
+}
+
+bool MemoizedTransportOptimizer::lookup(const Fingerprint& fp, std::int64_t& score) {
+    auto it = cache_.find(fp);
+    if (it == cache_.end()) {
+        ++stats_.misses;
+        ALGO_COUNT("transport.memo_misses", 1);
+        return false;
+    }
+    ++stats_.hits;
+    ALGO_COUNT("transport.memo_hits", 1);
+    lru_.splice(lru_.begin(), lru_, it->second);
+    score = it->second->second;
+    return true;
+}
+
+void MemoizedTransportOptimizer::insert(const Fingerprint& fp, std::int64_t score) {
+    if (cache_.count(fp)) {
+        return;
+    }
+    if (cache_.size() >= capacity_) {
+        cache_.erase(lru_.back().first);
+        lru_.pop_back();
+        ++stats_.evictions;
+    }
+    lru_.emplace_front(fp, score);
+    cache_.emplace(fp, lru_.begin());
+}
+
+std::int64_t MemoizedTransportOptimizer::evaluate(int index, const Scenario* scenario) {
+    const Node& node = nodes_[index];
+    const Scenario::Region* changed = nullptr;
+    if (scenario) {
+        auto it = scenario->regions.find(index);
+        if (it != scenario->regions.end()) {
+            changed = &it->second;
+        }
+    }
+    const Fingerprint& fp = changed ? changed->fingerprint : node.fingerprint;
+
+    std::int64_t score = 0;
+    if (lookup(fp, score)) {
+        return score;
+    }
+
+    if (node.children[0] < 0) {
+        MatrixView region = changed ? changed->cells.view()
+                                    : base_.view().block(node.r0, node.c0, node.rows, node.cols);
+        const std::vector<int>& weights = leafWeights(node.rows, node.cols);
+        for (size_t i = 0; i < node.rows; ++i) {
+            score += weightedRowSum(region.row(i), weights.data() + i * node.cols, node.cols);
+        }
+    } else {
+        score = changed ? changed->trace : node.trace;
+        for (int k = 0; k < 4; ++k) {
+            score += evaluate(node.children[k], scenario);
+        }
+    }
+    insert(fp, score);
+    return score;
+}
+
+std::int64_t MemoizedTransportOptimizer::optimizeScenario(const std::vector<EdgeUpdate>& edits) {
+    ALGO_SPAN("transport.memo_scenario");
+    if (!hasBase_) {
+        throw std::logic_error("MemoizedTransportOptimizer: no base network to edit");
+    }
+    for (const EdgeUpdate& edit : edits) {
+        if (edit.row >= base_.rows() || edit.col >= base_.cols()) {
+            throw std::out_of_range("MemoizedTransportOptimizer: edge outside the network");
+        }
+    }
+    if (nodes_.empty()) {
+        return 0;
+    }
+
+    // Later edits of the same cell win.
+    std::map<std::pair<size_t, size_t>, int> cells;
+    for (const EdgeUpdate& edit : edits) {
+        cells[{ edit.row, edit.col }] = edit.weight;
+    }
+
+    Scenario scenario;
+    for (const auto& cell : cells) {
+        size_t row = cell.first.first;
+        size_t col = cell.first.second;
+        std::int64_t delta = static_cast<std::int64_t>(cell.second) - base_(row, col);
+        if (delta == 0) {
+            continue;
+        }
+
+        int index = 0;
+        while (true) {
+            const Node& node = nodes_[index];
+            auto inserted = scenario.regions.emplace(index, Scenario::Region());
+            Scenario::Region& region = inserted.first->second;
+            size_t i = row - node.r0;
+            size_t j = col - node.c0;
+            if (node.children[0] < 0) {
+                if (inserted.second) {
+                    region.cells = TransportMatrix(node.rows, node.cols);
+                    MatrixView source = base_.view().block(node.r0, node.c0, node.rows, node.cols);
+                    for (size_t r = 0; r < node.rows; ++r) {
+                        std::copy(source.row(r), source.row(r) + node.cols, region.cells.data() + r * node.cols);
+                    }
+                }
+                region.cells(i, j) = cell.second;
+                break;
+            }
+
+            if (inserted.second) {
+                region.trace = node.trace;
+            }
+            if (i == j) {
+                region.trace += delta;
+            }
+            size_t top = (node.rows + 1) / 2;
+            size_t left = (node.cols + 1) / 2;
+            index = node.children[(i >= top ? 2 : 0) + (j >= left ? 1 : 0)];
+        }
+    }
+
+    // Pre-order puts every child after its parent, so walking the changed
+    // nodes by descending index fingerprints children first.
+    std::vector<int> changed;
+    changed.reserve(scenario.regions.size());
+    for (const auto& region : scenario.regions) {
+        changed.push_back(region.first);
+    }
+    std::sort(changed.begin(), changed.end(), std::greater<int>());
+    for (int index : changed) {
+        const Node& node = nodes_[index];
+        Scenario::Region& region = scenario.regions[index];
+        if (node.children[0] < 0) {
+            region.fingerprint = leafFingerprint(region.cells.view());
+            continue;
+        }
+        Fingerprint children[4];
+        for (int k = 0; k < 4; ++k) {
+            auto it = scenario.regions.find(node.children[k]);
+            children[k] = it != scenario.regions.end() ? it->second.fingerprint : nodes_[node.children[k]].fingerprint;
+        }
+        region.fingerprint = parentFingerprint(node, children);
+    }
+
+    return evaluate(0, &scenario);
+}
+
+void MemoizedTransportOptimizer::clear() {
+    lru_.clear();
+    cache_.clear();
+}
+
 std::vector<std::vector<int>> SingaporeTransportOptimizer::generateNetwork(int size) {
-    std::vector<std::vector<int>> network(size, std::vector<int>(size));
     std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(1, 100);
+    NetworkSpec spec;
+    spec.rows = spec.cols = static_cast<size_t>(size < 0 ? 0 : size);
+    spec.seed = (static_cast<std::uint64_t>(rd()) << 32) | rd();
+    return generateNetwork(spec, 1).toNested();
+}
 
-    for (int i = 0; i < size; ++i) {
-        for (int j = 0; j < size; ++j) {
-            network[i][j] = dis(gen);
+namespace {
+
+const size_t kGeneratorLanes = 8;      // Philox counters evaluated together
+const size_t kGeneratorRowBlock = 16;  // rows per parallel task
+
+/**
+ * @brief Fills one row of a generated network
+ *
+ * Columns are taken in groups of 4 * kGeneratorLanes cells, one Philox
+ * call per lane: cell j is word (j % 32) / 8 of the output for counter
+ * (j / 32 * 8 + j % 8, i, 0). Stream 1 of the same counter decides which
+ * links a sparse distribution keeps. Word-major order keeps both the
+ * generation and the mapping below in straight vectorizable loops.
+ */
+void generateRow(int* out, size_t row, const NetworkSpec& spec, Philox4x32::Key key) {
+    const size_t cellsPerBatch = 4 * kGeneratorLanes;
+    bool masked = spec.distribution == WeightDistribution::Sparse
+        || spec.distribution == WeightDistribution::Clustered;
+    double density = std::min(1.0, std::max(0.0, spec.density));
+    std::uint64_t threshold = static_cast<std::uint64_t>(density * 4294967296.0);
+    size_t regions = std::max<size_t>(1, spec.regions);
+    size_t rowRegion = row * regions / spec.rows;
+
+    for (size_t j0 = 0; j0 < spec.cols; j0 += cellsPerBatch) {
+        std::uint32_t values[4][kGeneratorLanes];
+        std::uint32_t masks[4][kGeneratorLanes];
+        for (size_t lane = 0; lane < kGeneratorLanes; ++lane) {
+            std::uint32_t block = static_cast<std::uint32_t>(j0 / 4 + lane);
+            values[0][lane] = masks[0][lane] = block;
+            values[1][lane] = masks[1][lane] = static_cast<std::uint32_t>(row);
+            values[2][lane] = 0;
+            masks[2][lane] = 1;
+            values[3][lane] = masks[3][lane] = 0;
+        }
+        Philox4x32::generateLanes(values, key);
+        if (masked) {
+            Philox4x32::generateLanes(masks, key);
         }
+
+        int cells[cellsPerBatch];
+        const std::uint32_t* bits = &values[0][0];
+        for (size_t k = 0; k < cellsPerBatch; ++k) {
+            cells[k] = Philox4x32::uniformInt(bits[k], spec.minWeight, spec.maxWeight);
+        }
+
+        size_t count = std::min(cellsPerBatch, spec.cols - j0);
+        const std::uint32_t* keepBits = &masks[0][0];
+        switch (spec.distribution) {
+        case WeightDistribution::Uniform:
+            break;
+        case WeightDistribution::Banded:
+            for (size_t k = 0; k < count; ++k) {
+                size_t j = j0 + k;
+                if ((row > j ? row - j : j - row) > spec.bandWidth) cells[k] = 0;
+            }
+            break;
+        case WeightDistribution::Sparse:
+            for (size_t k = 0; k < count; ++k) {
+                if (keepBits[k] >= threshold) cells[k] = 0;
+            }
+            break;
+        case WeightDistribution::Clustered:
+            for (size_t k = 0; k < count; ++k) {
+                if ((j0 + k) * regions / spec.cols != rowRegion && keepBits[k] >= threshold) cells[k] = 0;
+            }
+            break;
+        }
+        std::copy(cells, cells + count, out + j0);
     }
+}
+
+} // namespace
+
+TransportMatrix SingaporeTransportOptimizer::generateNetwork(const NetworkSpec& spec, unsigned threads) {
+    ALGO_SPAN("transport.generate_network");
+    TransportMatrix network(spec.rows, spec.cols);
+    if (spec.rows == 0 || spec.cols == 0) {
+        return network;
+    }
+
+    Philox4x32::Key key = Philox4x32::keyFromSeed(spec.seed);
+    auto fillRows = [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            generateRow(network.data() + i * spec.cols, i, spec, key);
+        }
+    };
+
+    size_t blocks = (spec.rows + kGeneratorRowBlock - 1) / kGeneratorRowBlock;
+    if (threads == 1 || blocks == 1) {
+        fillRows(0, spec.rows);
+        return network;
+    }
+
+    TaskPool pool(threads);
+    TaskPool::TaskGroup group;
+    for (size_t b = 0; b < blocks; ++b) {
+        size_t first = b * kGeneratorRowBlock;
+        size_t last = std::min(spec.rows, first + kGeneratorRowBlock);
+        pool.run(group, [&fillRows, first, last] { fillRows(first, last); });
+    }
+    pool.wait(group);
     return network;
 }
 
-void SingaporeTransportOptimizer::analyzeComplexity() {
-    std::cout << "\n-----COMPLEXITY ANALYSIS-----" << std::endl;
-    std::cout << "Recurrence: T(n) = 4T(n/2) + n" << std::endl;
-    std::cout << "Expected Complexity: O(n^2)" << std::endl;
-    std::cout << "Empirical validation below:" << std::endl << std::endl;
+SparseTransportMatrix SingaporeTransportOptimizer::generateSparseNetwork(size_t size, size_t links, unsigned seed) {
+    ALGO_SPAN("transport.generate_sparse_network");
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<std::uint32_t> cell(0, static_cast<std::uint32_t>(size == 0 ? 0 : size - 1));
+    std::uniform_int_distribution<> dis(1, 100);
+
+    std::vector<SparseLink> list(size == 0 ? 0 : links);
+    for (SparseLink& link : list) {
+        link = { cell(gen), cell(gen), dis(gen) };
+    }
+    return SparseTransportMatrix(size, size, std::move(list));
+}
+
+namespace {
+
+/**
+ * @brief Two-sided 95% Student's t quantile for the given degrees of freedom
+ */
+double tQuantile95(size_t df) {
+    static const double table[] = { 0.0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086 };
+    if (df == 0) return 0.0;
+    if (df <= 20) return table[df];
+    return df < 30 ? 2.060 : 1.960;
+}
+
+/**
+ * @brief Least-squares fit of log(median time) against log(size)
+ */
+void fitExponent(ScalingReport& report, size_t fitMinSize) {
+    std::vector<double> xs, ys;
+    for (const ScalingSample& sample : report.samples) {
+        if (sample.size >= fitMinSize && sample.size > 0 && sample.medianNs > 0) {
+            xs.push_back(std::log(static_cast<double>(sample.size)));
+            ys.push_back(std::log(sample.medianNs));
+        }
+    }
+    report.fittedPoints = xs.size();
+    if (xs.size() < 2) return;
+
+    double n = static_cast<double>(xs.size());
+    double meanX = 0, meanY = 0;
+    for (size_t k = 0; k < xs.size(); ++k) {
+        meanX += xs[k] / n;
+        meanY += ys[k] / n;
+    }
+    double sxx = 0, sxy = 0, syy = 0;
+    for (size_t k = 0; k < xs.size(); ++k) {
+        sxx += (xs[k] - meanX) * (xs[k] - meanX);
+        sxy += (xs[k] - meanX) * (ys[k] - meanY);
+        syy += (ys[k] - meanY) * (ys[k] - meanY);
+    }
+    if (sxx == 0) return;
+
+    double slope = sxy / sxx;
+    double sse = std::max(0.0, syy - slope * sxy);
+    report.exponent = slope;
+    report.rSquared = syy > 0 ? 1.0 - sse / syy : 1.0;
+
+    double margin = 0.0;
+    if (xs.size() > 2) {
+        margin = tQuantile95(xs.size() - 2) * std::sqrt(sse / (n - 2) / sxx);
+    }
+    report.exponentLow = slope - margin;
+    report.exponentHigh = slope + margin;
+}
+
+} // namespace
 
-    std::vector<int> sizes = { 2, 4, 8, 16, 32 };
-    std::vector<long long> durations;
+void ScalingReport::writeCsv(std::ostream& os) const {
+    os << "size,repetitions,runs_per_sample,median_ns,min_ns,stddev_ns,"
+          "allocations_per_run,bytes_allocated_per_run,bytes_copied_per_run" << std::endl;
+    for (const ScalingSample& sample : samples) {
+        os << sample.size << "," << sample.repetitions << "," << sample.runsPerSample << ","
+           << sample.medianNs << "," << sample.minNs << "," << sample.stddevNs << ","
+           << sample.allocationsPerRun << "," << sample.bytesAllocatedPerRun << ","
+           << sample.bytesCopiedPerRun << std::endl;
+    }
+}
 
-    for (int size : sizes) {
-        auto network = generateNetwork(size);
-        auto start = std::chrono::high_resolution_clock::now();
-        optimizeTransport(network);
-        auto end = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-        durations.push_back(duration.count());
-        std::cout << "Size: " << size << " | Time: " << duration.count() << " microseconds" << std::endl;
+void ScalingReport::writeJson(std::ostream& os) const {
+    os << "{\n  \"samples\": [\n";
+    for (size_t k = 0; k < samples.size(); ++k) {
+        const ScalingSample& sample = samples[k];
+        os << "    {\"size\": " << sample.size
+           << ", \"repetitions\": " << sample.repetitions
+           << ", \"runs_per_sample\": " << sample.runsPerSample
+           << ", \"median_ns\": " << sample.medianNs
+           << ", \"min_ns\": " << sample.minNs
+           << ", \"stddev_ns\": " << sample.stddevNs
+           << ", \"allocations_per_run\": " << sample.allocationsPerRun
+           << ", \"bytes_allocated_per_run\": " << sample.bytesAllocatedPerRun
+           << ", \"bytes_copied_per_run\": " << sample.bytesCopiedPerRun << "}"
+           << (k + 1 < samples.size() ? "," : "") << "\n";
     }
+    os << "  ],\n  \"fit\": {\"exponent\": " << exponent
+       << ", \"ci95_low\": " << exponentLow
+       << ", \"ci95_high\": " << exponentHigh
+       << ", \"r_squared\": " << rSquared
+       << ", \"points\": " << fittedPoints << "}\n}" << std::endl;
+}
+
+ScalingReport SingaporeTransportOptimizer::measureScaling(const ScalingOptions& options) {
+    ALGO_SPAN("transport.measure_scaling");
+    using Clock = std::chrono::steady_clock;
+    ScalingReport report;
+
+    for (size_t size : options.sizes) {
+        NetworkSpec spec;
+        spec.rows = spec.cols = size;
+        spec.seed = options.seed + size;
+        TransportMatrix matrix = generateNetwork(spec);
+        std::vector<std::vector<int>> nested;
+        if (options.nestedInput) {
+            nested = matrix.toNested();
+        }
+
+        ScalingSample sample;
+        sample.size = size;
+        auto runBatch = [&](std::uint64_t runs) {
+            auto start = Clock::now();
+            for (std::uint64_t r = 0; r < runs; ++r) {
+                sample.result = options.nestedInput ? optimizeTransport(nested) : optimizeTransport(matrix);
+            }
+            return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        };
+
+        for (int w = 0; w < options.warmup; ++w) {
+            runBatch(1);
+        }
+
+        // Double the batch until one sample is long enough to time reliably.
+        std::uint64_t runs = 1;
+        while (runBatch(runs) < options.minSampleSeconds * 1e9 && runs < (std::uint64_t(1) << 24)) {
+            runs *= 2;
+        }
+        sample.runsPerSample = runs;
+        sample.repetitions = std::max(1, options.repetitions);
 
-    std::cout << "\nGrowth Ratios (should approach 4 for O(n^2)):" << std::endl;
-    for (size_t i = 1; i < durations.size(); ++i) {
-        double ratio = static_cast<double>(durations[i]) / durations[i - 1];
-        std::cout << sizes[i] << "/" << sizes[i - 1] << ": " << ratio << " (expected ~4)" << std::endl;
+        std::vector<double> perRun;
+        perRun.reserve(sample.repetitions);  // no allocations inside the counted window
+        AllocationStats before = currentAllocationStats();
+        std::uint64_t copiedBefore = bytesCopied_;
+        for (int rep = 0; rep < sample.repetitions; ++rep) {
+            perRun.push_back(runBatch(runs) / static_cast<double>(runs));
+        }
+        AllocationStats used = currentAllocationStats() - before;
+        double totalRuns = static_cast<double>(runs) * sample.repetitions;
+        sample.allocationsPerRun = used.allocations / totalRuns;
+        sample.bytesAllocatedPerRun = used.bytesAllocated / totalRuns;
+        sample.bytesCopiedPerRun = (bytesCopied_ - copiedBefore) / totalRuns;
+
+        std::vector<double> sorted = perRun;
+        std::sort(sorted.begin(), sorted.end());
+        size_t mid = sorted.size() / 2;
+        sample.medianNs = sorted.size() % 2 ? sorted[mid] : (sorted[mid - 1] + sorted[mid]) / 2;
+        sample.minNs = sorted.front();
+        double mean = 0;
+        for (double t : perRun) mean += t / perRun.size();
+        double variance = 0;
+        for (double t : perRun) variance += (t - mean) * (t - mean);
+        sample.stddevNs = perRun.size() > 1 ? std::sqrt(variance / (perRun.size() - 1)) : 0.0;
+
+        report.samples.push_back(sample);
     }
 
-    std::cout << "\nEmpirical Conclusion: Growth ratios confirm O(n^2) complexity" << std::endl;
-}
\ No newline at end of file
+    fitExponent(report, options.fitMinSize);
+    return report;
+}
+
+void SingaporeTransportOptimizer::analyzeComplexity(std::ostream& out) {
+    // the table switches out to fixed point; the caller gets its format back
+    std::ios saved(nullptr);
+    saved.copyfmt(out);
+    out << "\n-----COMPLEXITY ANALYSIS-----" << std::endl;
+    out << "Recurrence: T(n) = 4T(n/2) + n" << std::endl;
+    out << "Expected Complexity: O(n^2)" << std::endl;
+    out << "Empirical validation below:" << std::endl << std::endl;
+
+    ScalingReport report = measureScaling();
+
+    out << std::setw(7) << "Size" << std::setw(16) << "Median (ns)" << std::setw(16) << "Min (ns)"
+              << std::setw(10) << "Stddev%" << std::setw(10) << "Runs" << std::setw(12) << "Allocs/run"
+              << std::setw(14) << "Copied B/run" << std::endl;
+    for (const ScalingSample& sample : report.samples) {
+        double spread = sample.medianNs > 0 ? 100.0 * sample.stddevNs / sample.medianNs : 0.0;
+        out << std::setw(7) << sample.size << std::setw(16) << std::fixed << std::setprecision(0)
+                  << sample.medianNs << std::setw(16) << sample.minNs << std::setw(10) << std::setprecision(1)
+                  << spread << std::setw(10) << sample.runsPerSample << std::setw(12) << std::setprecision(2);
+        if (allocationCountingEnabled()) {
+            out << sample.allocationsPerRun;
+        } else {
+            out << "n/a";  // this program keeps the standard allocator
+        }
+        out << std::setw(14) << std::setprecision(0) << sample.bytesCopiedPerRun << std::endl;
+    }
+    out.unsetf(std::ios::floatfield);
+    out << std::setprecision(4);
+
+    out << "\nFitted exponent (log-log, " << report.fittedPoints << " sizes): " << report.exponent
+              << "  95% CI [" << report.exponentLow << ", " << report.exponentHigh << "]"
+              << "  R^2 = " << report.rSquared << std::endl;
+
+    bool consistent = report.fittedPoints >= 2
+        && ((report.exponentLow <= 2.0 && 2.0 <= report.exponentHigh) || std::fabs(report.exponent - 2.0) <= 0.15);
+    if (consistent) {
+        out << "Empirical Conclusion: growth is consistent with O(n^2)" << std::endl;
+    } else {
+        out << "Empirical Conclusion: measured exponent differs from the expected 2 "
+                     "(typically cache effects once the network outgrows the caches)" << std::endl;
+    }
+    out.copyfmt(saved);
+}
@@ -17,18 +17,37 @@
  *
  * @section features Features
  * - Implements recurrence relation T(n) = 4T(n/2) + n
- * - Empirical complexity analysis with timing measurements
+ * - Empirical scaling analysis: repeated nanosecond timings, allocation
+ *   counts and a log-log fit of the growth exponent, exported as CSV/JSON
  * - Singapore-specific regional division
- * - Configurable network generation for testing
+ * - Configurable network generation for testing, seeded and parallel
+ * - Optional task-parallel quadrant recursion on a work-stealing pool
+ * - Optional Z-order (Morton) tiled storage with a stackless bottom-up evaluator
+ * - IncrementalTransportOptimizer for cheap re-optimization after link updates
+ * - Sparse (COO) networks whose empty quadrants cost O(1)
+ * - Out-of-core evaluation of networks stored in a binary tiled file
+ * - Batch evaluation of many same-sized snapshots in a single traversal
+ * - MemoizedTransportOptimizer: cached scores of repeated regions and
+ *   scenario variants that re-evaluate only what changed
+ * - All-pairs shortest travel times and routes by recursive Kleene closure
  *
  * @section usage Usage
  * #include "transport.hpp"
  * SingaporeTransportOptimizer optimizer(network_size);
- * int result = optimizer.optimizeTransport(network_matrix);
+ * std::int64_t result = optimizer.optimizeTransport(network_matrix);
  * optimizer.analyzeComplexity();
+ * optimizer.measureScaling().writeJson(std::cout);
+ *
+ * Networks can also be passed as a TransportMatrix (contiguous row-major
+ * storage) or a MatrixView into one; the nested-vector overload converts once
+ * and then recurses over zero-copy quadrant views. A MortonMatrix stores the
+ * network tile by tile in Z-order so that every quadrant is one contiguous
+ * block; its overload evaluates the tiles in a single forward pass.
  *
  * @section notes Notes
- * - Network sizes must be powers of 2 for proper division
+ * - Networks may be any N x M size; odd dimensions split into ceil/floor
+ *   halves, so nothing is padded to the next power of 2
+ * - Only MortonMatrix requires a square power-of-2 network
  * - Algorithm designed for Singapore's geographical context
  * - Includes testing utilities for unit validation
  */
@@ -41,6 +60,460 @@
 #include <iostream>
 #include <random>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <limits>
+#include <list>
+#include <map>
+#include <memory_resource>
+#include <unordered_map>
+#include <utility>
+#include "task_pool.hpp"
+
+/**
+ * @struct MatrixView
+ * @brief Non-owning strided view of a row-major integer matrix
+ *
+ * @details
+ * Element (i, j) of the view lives at base[offset + i * stride + j]. A
+ * sub-block of a view is another view over the same storage, so splitting a
+ * network into quadrants copies nothing.
+ */
+struct MatrixView {
+    const int* base = nullptr; ///< Start of the underlying storage
+    size_t offset = 0;         ///< Index of element (0, 0) of this view in base
+    size_t rows = 0;           ///< Number of rows in the view
+    size_t cols = 0;           ///< Number of columns in the view
+    size_t stride = 0;         ///< Distance between consecutive rows in base
+
+    int at(size_t i, size_t j) const { return base[offset + i * stride + j]; }
+    const int* row(size_t i) const { return base + offset + i * stride; }
+
+    /**
+     * @brief Returns the r x c sub-block whose top-left corner is (r0, c0)
+     */
+    MatrixView block(size_t r0, size_t c0, size_t r, size_t c) const {
+        return { base, offset + r0 * stride + c0, r, c, stride };
+    }
+};
+
+/**
+ * @class TransportMatrix
+ * @brief Contiguous row-major storage for a transport network
+ *
+ * @details
+ * Replaces std::vector<std::vector<int>> on the hot path: one allocation for
+ * the whole network, rows adjacent in memory, and cheap MatrixView access.
+ */
+class TransportMatrix {
+public:
+    TransportMatrix() = default;
+
+    /**
+     * @brief Creates a rows x cols matrix filled with a constant value
+     */
+    TransportMatrix(size_t rows, size_t cols, int fill = 0);
+
+    /**
+     * @brief Copies a nested-vector network into contiguous storage
+     * @throws std::invalid_argument if the rows have different lengths
+     */
+    explicit TransportMatrix(const std::vector<std::vector<int>>& network);
+
+    size_t rows() const { return rows_; }
+    size_t cols() const { return cols_; }
+    int* data() { return data_.data(); }
+    const int* data() const { return data_.data(); }
+
+    int& operator()(size_t i, size_t j) { return data_[i * cols_ + j]; }
+    int operator()(size_t i, size_t j) const { return data_[i * cols_ + j]; }
+
+    MatrixView view() const { return { data_.data(), 0, rows_, cols_, cols_ }; }
+
+    /**
+     * @brief Copies the matrix back out as nested vectors
+     */
+    std::vector<std::vector<int>> toNested() const;
+
+private:
+    size_t rows_ = 0;        ///< Number of rows
+    size_t cols_ = 0;        ///< Number of columns
+    std::vector<int> data_;  ///< Row-major elements
+};
+
+/**
+ * @class MortonMatrix
+ * @brief Tiled Z-order (Morton) storage for a power-of-two transport network
+ *
+ * @details
+ * The network is cut into tileSize x tileSize tiles, each stored row-major,
+ * and the tiles are laid out in Morton order: NE, NW, SE, SW quadrant by
+ * quadrant, recursively. Any quadrant at least one tile wide therefore
+ * occupies one contiguous range of data(), in the same order the quadrant
+ * recursion visits it.
+ */
+class MortonMatrix {
+public:
+    MortonMatrix() = default;
+
+    /**
+     * @brief Converts a row-major network into tiled Z-order storage
+     * @param network Square view whose size is a power of 2
+     * @param tileSize Tile edge; rounded down to a power of 2 and capped at
+     *                 the network size
+     * @throws std::invalid_argument if the network is not square or its
+     *         size is not a power of 2
+     */
+    explicit MortonMatrix(const MatrixView& network, size_t tileSize = 32);
+    explicit MortonMatrix(const TransportMatrix& network, size_t tileSize = 32)
+        : MortonMatrix(network.view(), tileSize) {}
+
+    size_t size() const { return size_; }
+    size_t tileSize() const { return tileSize_; }
+    size_t tileCount() const { return tileSize_ == 0 ? 0 : (size_ / tileSize_) * (size_ / tileSize_); }
+    const int* data() const { return data_.data(); }
+
+    /**
+     * @brief Returns the tile at a position in Z-order as a row-major view
+     */
+    MatrixView tile(size_t index) const {
+        return { data_.data(), index * tileSize_ * tileSize_, tileSize_, tileSize_, tileSize_ };
+    }
+
+    /**
+     * @brief Element (i, j) of the network
+     */
+    int operator()(size_t i, size_t j) const;
+
+    /**
+     * @brief Converts back to row-major storage
+     */
+    TransportMatrix toRowMajor() const;
+
+private:
+    size_t size_ = 0;        ///< Rows (and columns) of the network
+    size_t tileSize_ = 0;    ///< Rows (and columns) of each tile
+    std::vector<int> data_;  ///< Tiles in Z-order, each row-major
+};
+
+/**
+ * @struct SparseLink
+ * @brief One non-zero cell of a sparse transport network
+ */
+struct SparseLink {
+    std::uint32_t row = 0;  ///< Row of the cell
+    std::uint32_t col = 0;  ///< Column of the cell
+    int weight = 0;         ///< Value of the cell
+};
+
+/**
+ * @class SparseTransportMatrix
+ * @brief Coordinate-list (COO) storage for mostly-empty transport networks
+ *
+ * @details
+ * Only the non-zero links are stored, sorted row-major with one entry per
+ * cell, so memory is proportional to the number of links rather than to
+ * rows x cols. Row and column indices are 32-bit.
+ */
+class SparseTransportMatrix {
+public:
+    SparseTransportMatrix() = default;
+
+    /**
+     * @brief Creates a rows x cols network from a list of links
+     * @param links Links in any order; duplicate cells are summed and zero
+     *              results dropped
+     * @throws std::invalid_argument if a dimension does not fit in 32 bits
+     * @throws std::out_of_range if a link lies outside the network
+     */
+    SparseTransportMatrix(size_t rows, size_t cols, std::vector<SparseLink> links);
+
+    /**
+     * @brief Collects the non-zero cells of a dense network
+     */
+    static SparseTransportMatrix fromDense(const MatrixView& network);
+
+    size_t rows() const { return rows_; }
+    size_t cols() const { return cols_; }
+    size_t nonZeros() const { return links_.size(); }
+    const std::vector<SparseLink>& links() const { return links_; }
+
+    /**
+     * @brief Bytes held by the link list
+     */
+    size_t memoryBytes() const { return links_.capacity() * sizeof(SparseLink); }
+
+    /**
+     * @brief Expands into dense row-major storage
+     */
+    TransportMatrix toDense() const;
+
+private:
+    size_t rows_ = 0;                ///< Number of rows
+    size_t cols_ = 0;                ///< Number of columns
+    std::vector<SparseLink> links_;  ///< Non-zero cells, row-major, unique
+};
+
+/**
+ * @enum BatchLayout
+ * @brief How a NetworkBatch orders its snapshots in memory
+ */
+enum class BatchLayout {
+    Planar,      ///< Snapshot-major: count row-major networks back to back
+    Interleaved  ///< Cell-major: the count snapshots of each cell are adjacent
+};
+
+/**
+ * @class NetworkBatch
+ * @brief Many same-sized networks (e.g. hourly snapshots) in one array
+ *
+ * @details
+ * Planar keeps every snapshot a plain row-major matrix. Interleaved puts
+ * cell (i, j) of all snapshots side by side, so a kernel that walks the
+ * cells once updates every snapshot with contiguous, vector-width loads.
+ */
+class NetworkBatch {
+public:
+    NetworkBatch() = default;
+
+    /**
+     * @brief Creates count zero-filled rows x cols snapshots
+     */
+    NetworkBatch(size_t count, size_t rows, size_t cols, BatchLayout layout = BatchLayout::Interleaved);
+
+    /**
+     * @brief Packs networks of one shape into a batch
+     * @throws std::invalid_argument if the networks differ in shape
+     */
+    static NetworkBatch fromNetworks(const std::vector<TransportMatrix>& networks,
+        BatchLayout layout = BatchLayout::Interleaved);
+
+    size_t count() const { return count_; }
+    size_t rows() const { return rows_; }
+    size_t cols() const { return cols_; }
+    BatchLayout layout() const { return layout_; }
+    int* data() { return data_.data(); }
+    const int* data() const { return data_.data(); }
+
+    int& operator()(size_t snapshot, size_t i, size_t j) { return data_[index(snapshot, i, j)]; }
+    int operator()(size_t snapshot, size_t i, size_t j) const { return data_[index(snapshot, i, j)]; }
+
+    /**
+     * @brief Overwrites one snapshot
+     * @throws std::out_of_range if snapshot >= count()
+     * @throws std::invalid_argument if the network has a different shape
+     */
+    void setSnapshot(size_t snapshot, const MatrixView& network);
+
+    /**
+     * @brief Copies one snapshot out as a row-major matrix
+     * @throws std::out_of_range if snapshot >= count()
+     */
+    TransportMatrix snapshot(size_t snapshot) const;
+
+private:
+    size_t index(size_t snapshot, size_t i, size_t j) const {
+        return layout_ == BatchLayout::Interleaved ? (i * cols_ + j) * count_ + snapshot
+                                                   : (snapshot * rows_ + i) * cols_ + j;
+    }
+
+    size_t count_ = 0;                               ///< Number of snapshots
+    size_t rows_ = 0;                                ///< Rows of every snapshot
+    size_t cols_ = 0;                                ///< Columns of every snapshot
+    BatchLayout layout_ = BatchLayout::Interleaved;  ///< Element order
+    std::vector<int> data_;                          ///< All snapshots
+};
+
+/**
+ * @struct TiledFileStats
+ * @brief I/O volume and wall time of one out-of-core evaluation
+ */
+struct TiledFileStats {
+    std::uint64_t bytesRead = 0;  ///< Payload and header bytes read
+    std::uint64_t leaves = 0;     ///< Leaf regions streamed
+    double seconds = 0.0;         ///< Wall time of the evaluation
+};
+
+/**
+ * @class TiledNetworkFile
+ * @brief Binary tiled file format for networks larger than memory
+ *
+ * @details
+ * Layout: the 8-byte magic "SGTILES1", then rows, cols and tileSize as
+ * 64-bit integers, then the leaf regions of the quadrant recursion in the
+ * order it visits them (NE, NW, SE, SW, depth first), each stored row-major
+ * as 32-bit ints. Leaves are the regions of at most tileSize rows and
+ * columns, or single rows/columns, under the same ceil/floor split as
+ * optimizeTransport. For square power-of-2 networks this is Z-order. All
+ * values use the native byte order of the writing machine.
+ */
+class TiledNetworkFile {
+public:
+    struct Header {
+        size_t rows = 0;      ///< Number of rows
+        size_t cols = 0;      ///< Number of columns
+        size_t tileSize = 0;  ///< Largest leaf edge
+    };
+
+    /**
+     * @brief Writes a network held in memory
+     * @throws std::runtime_error if the file cannot be written
+     */
+    static void write(const std::string& path, const MatrixView& network, size_t tileSize = 32);
+
+    /**
+     * @brief Writes a network produced cell by cell, without materializing it
+     * @param cell Returns the value of cell (i, j); called once per cell
+     * @throws std::runtime_error if the file cannot be written
+     */
+    static void write(const std::string& path, size_t rows, size_t cols, size_t tileSize,
+        const std::function<int(size_t, size_t)>& cell);
+
+    /**
+     * @brief Reads and validates the header of a tiled file
+     * @throws std::runtime_error if the file cannot be read or is not a tiled network
+     */
+    static Header readHeader(const std::string& path);
+};
+
+/**
+ * @enum WeightDistribution
+ * @brief Shape of the link weights produced by the network generator
+ */
+enum class WeightDistribution {
+    Uniform,   ///< Every link weighted uniformly in [minWeight, maxWeight]
+    Banded,    ///< Only links with |i - j| <= bandWidth are non-zero
+    Sparse,    ///< Each link is non-zero with probability density
+    Clustered  ///< Dense inside each of `regions` diagonal blocks, sparse between them
+};
+
+/**
+ * @struct NetworkSpec
+ * @brief Parameters of a generated transport network
+ *
+ * @details
+ * Cell (i, j) is a pure function of the seed, i and j, so the same spec
+ * always yields the same matrix however the work is split across threads.
+ * Rows and columns are limited to 2^32.
+ */
+struct NetworkSpec {
+    size_t rows = 0;                                          ///< Number of rows
+    size_t cols = 0;                                          ///< Number of columns
+    std::uint64_t seed = 0;                                   ///< Generator seed
+    WeightDistribution distribution = WeightDistribution::Uniform;
+    int minWeight = 1;                                        ///< Smallest non-zero weight
+    int maxWeight = 100;                                      ///< Largest weight
+    size_t bandWidth = 8;                                     ///< Banded: half-width of the band
+    double density = 0.01;                                    ///< Sparse/Clustered: share of links kept
+    size_t regions = 4;                                       ///< Clustered: number of dense blocks
+};
+
+/**
+ * @struct ScalingOptions
+ * @brief What SingaporeTransportOptimizer::measureScaling measures
+ */
+struct ScalingOptions {
+    std::vector<size_t> sizes = { 16, 32, 64, 128, 256, 512, 1024 };  ///< Kept small: transportBenchmark sweeps to 16384
+    int warmup = 2;                   ///< Untimed runs per size
+    int repetitions = 7;              ///< Timed samples per size
+    double minSampleSeconds = 0.001;  ///< Small sizes repeat inside a sample to reach this
+    size_t fitMinSize = 64;           ///< Sizes below this are reported but not fitted
+    bool nestedInput = false;         ///< Time the nested-vector entry point instead of TransportMatrix
+    std::uint64_t seed = 42;          ///< Seed of the generated networks
+};
+
+/**
+ * @struct ScalingSample
+ * @brief Measurements for one network size
+ */
+struct ScalingSample {
+    size_t size = 0;                   ///< Rows (and columns) of the network
+    int repetitions = 0;               ///< Timed samples
+    std::uint64_t runsPerSample = 0;   ///< Optimizations per timed sample
+    double medianNs = 0.0;             ///< Median time per optimization
+    double minNs = 0.0;                ///< Fastest time per optimization
+    double stddevNs = 0.0;             ///< Standard deviation across samples
+    double allocationsPerRun = 0.0;    ///< Heap allocations per optimization
+    double bytesAllocatedPerRun = 0.0; ///< Heap bytes requested per optimization
+    double bytesCopiedPerRun = 0.0;    ///< Network bytes copied into internal storage per optimization
+    std::int64_t result = 0;           ///< Score returned, to keep the work observable
+};
+
+/**
+ * @struct ScalingReport
+ * @brief Per-size samples and the fitted growth exponent
+ *
+ * @details
+ * The exponent is the slope of an ordinary least-squares fit of
+ * log(median time) against log(size); the interval is its 95% confidence
+ * interval from Student's t. O(n^2) work predicts an exponent near 2.
+ */
+struct ScalingReport {
+    std::vector<ScalingSample> samples;
+    double exponent = 0.0;       ///< Fitted slope
+    double exponentLow = 0.0;    ///< Lower end of the 95% interval
+    double exponentHigh = 0.0;   ///< Upper end of the 95% interval
+    double rSquared = 0.0;       ///< Goodness of fit
+    size_t fittedPoints = 0;     ///< Sizes used by the fit
+
+    void writeCsv(std::ostream& os) const;
+    void writeJson(std::ostream& os) const;
+};
+
+/**
+ * @class ShortestPaths
+ * @brief All-pairs travel times and next-hop routes of a transport network
+ *
+ * @details
+ * Produced by SingaporeTransportOptimizer::shortestPaths. Stores the n x n
+ * distance matrix and, for every pair, the first node after the origin on
+ * one shortest route; following next hops rebuilds the whole route.
+ */
+class ShortestPaths {
+public:
+    static constexpr std::int64_t kUnreachable = std::numeric_limits<std::int64_t>::max();
+    static constexpr size_t kNoRoute = static_cast<size_t>(-1);
+
+    size_t nodeCount() const { return nodes_; }
+
+    /**
+     * @brief Shortest travel time from one node to another
+     * @return kUnreachable if no route exists
+     * @throws std::out_of_range if either node is outside the network
+     */
+    std::int64_t distance(size_t from, size_t to) const;
+
+    bool reachable(size_t from, size_t to) const { return distance(from, to) != kUnreachable; }
+
+    /**
+     * @brief Node after from on a shortest route to to
+     * @return to itself when from == to, kNoRoute if no route exists
+     * @throws std::out_of_range if either node is outside the network
+     */
+    size_t nextHop(size_t from, size_t to) const;
+
+    /**
+     * @brief Every node of a shortest route, from first to to last
+     * @return Empty if no route exists
+     * @throws std::out_of_range if either node is outside the network
+     */
+    std::vector<size_t> route(size_t from, size_t to) const;
+
+    /**
+     * @brief Row-major n x n distances (kUnreachable where no route exists)
+     */
+    const std::vector<std::int64_t>& distances() const { return distances_; }
+
+private:
+    friend class SingaporeTransportOptimizer;
+
+    size_t nodes_ = 0;                       ///< Nodes of the network
+    std::vector<std::int64_t> distances_;    ///< Row-major shortest travel times
+    std::vector<std::uint32_t> nextHops_;    ///< Row-major first hops, UINT32_MAX if unreachable
+};
 
  /**
   * @class SingaporeTransportOptimizer
@@ -56,30 +529,217 @@ public:
     /**
      * @brief Constructs a transport optimizer for given network size
      * @param network_size The dimension of the square transport network
+     * @param resource Source of per-call scratch storage (see setMemoryResource)
+     */
+    SingaporeTransportOptimizer(int network_size,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    /**
+     * @brief Sets where per-call scratch storage is allocated
+     *
+     * @details
+     * Covers the flat copy made by the nested-vector entry point, the
+     * working copy of a sparse network's links, the Morton evaluator's
+     * stack and the batch partial sums. Only the calling thread allocates
+     * from it, so an unsynchronized ArenaResource or SizeClassPool is fine
+     * even with parallel evaluation. Cached leaf weights stay on the heap
+     * since they outlive any one call.
      */
-    SingaporeTransportOptimizer(int network_size);
+    void setMemoryResource(std::pmr::memory_resource* resource) { resource_ = resource; }
+    std::pmr::memory_resource* memoryResource() const { return resource_; }
 
     /**
      * @brief Main algorithm implementing T(n) = 4T(n/2) + n recurrence
-     * @param network Square matrix representing transport connectivity
+     * @param network Matrix representing transport connectivity (any N x M)
      * @return Optimized transport route combination score
      *
      * @details
      * Recursively divides the network into 4 Singapore regions (NE, NW, SE, SW),
      * optimizes each sub-region, and combines results with linear-time work
-     * for inter-region connectivity optimization.
+     * for inter-region connectivity optimization. Regions of at most
+     * tileSize rows are evaluated by a tiled leaf kernel that gives the
+     * same result as recursing further. Scores accumulate in 64 bits.
+     */
+    std::int64_t optimizeTransport(const std::vector<std::vector<int>>& network);
+
+    /**
+     * @brief Runs the optimization over contiguous storage
+     * @param network Transport network in row-major storage
+     * @return Optimized transport route combination score
+     */
+    std::int64_t optimizeTransport(const TransportMatrix& network);
+
+    /**
+     * @brief Runs the optimization over a (possibly strided) view
+     * @param network View of the transport network to optimize
+     * @return Optimized transport route combination score
+     *
+     * @details
+     * The recursion works entirely on views: each quadrant is a MatrixView
+     * into the caller's storage, so no level allocates or copies.
+     */
+    std::int64_t optimizeTransport(const MatrixView& network);
+
+    /**
+     * @brief Bottom-up evaluation over Z-order storage
+     * @param network Transport network in tiled Morton order
+     * @return Same score as optimizeTransport on the row-major network
+     *
+     * @details
+     * Walks the tiles once, front to back. Each tile is scored by the leaf
+     * kernel and pushed with its diagonal sum; whenever four siblings are
+     * complete they collapse into their parent, whose diagonal is the sum
+     * of its NE and SW children's. No recursion and no revisiting of memory.
+     */
+    std::int64_t optimizeTransport(const MortonMatrix& network);
+
+    /**
+     * @brief Runs the optimization over a sparse network
+     * @param network Non-zero links of the network
+     * @return Same score as optimizeTransport on the dense network
+     *
+     * @details
+     * Each level partitions the region's links into its four quadrants in
+     * place; a quadrant without links scores 0 (its cells and diagonal are
+     * all zero) and is not visited. The combine term only needs the links
+     * on the region's diagonal. Time is O(nnz log n) and memory one copy of
+     * the link list, independent of rows x cols.
+     */
+    std::int64_t optimizeTransport(const SparseTransportMatrix& network);
+
+    /**
+     * @brief Optimizes every snapshot of a batch in one traversal
+     * @param batch Same-sized networks, planar or interleaved
+     * @return One score per snapshot, equal to optimizeTransport on it
+     *
+     * @details
+     * Every score is the sum of the network's cells times a per-cell
+     * weight: 1 plus the number of recursion diagonals through the cell.
+     * The quadrant recursion runs once per shape to build those weights
+     * (one byte per cell, cached for the next batch of the same shape);
+     * each batch is then one sequential pass over memory. With the
+     * interleaved layout a cell's weight multiplies all snapshot lanes at
+     * once in a vectorized loop; planar batches take one dot product per
+     * snapshot.
+     */
+    std::vector<std::int64_t> optimizeTransportBatch(const NetworkBatch& batch);
+
+    /**
+     * @brief Streams a network from a TiledNetworkFile and optimizes it
+     * @param path File written by TiledNetworkFile::write
+     * @param[out] stats Optional I/O statistics of the run
+     * @return Same score as optimizeTransport on the in-memory network
+     * @throws std::runtime_error if the file is missing, malformed or truncated
+     *
+     * @details
+     * Replays the recursion from the header alone and reads each leaf in
+     * file order, so the file is read front to back exactly once. Only one
+     * leaf buffer and the chain of open ancestors are held in memory; each
+     * ancestor collects its diagonal from the leaves as they stream past.
+     */
+    std::int64_t optimizeTransportFile(const std::string& path, TiledFileStats* stats = nullptr);
+
+    /**
+     * @brief Task-parallel version of optimizeTransport
+     * @param network View of the transport network to optimize
+     * @return Same score as optimizeTransport for the same input
+     *
+     * @details
+     * Above the parallel grain size the NW, SE and SW quadrants are queued
+     * as tasks on the optimizer's work-stealing pool while the calling
+     * thread recurses into NE; below it the serial recursion takes over.
+     * Results are combined in a fixed order once all four quadrants finish,
+     * so the score does not depend on thread count or scheduling. The tile
+     * weights for every leaf shape are built before any task starts, so the
+     * tasks only read the cache and never lock.
+     */
+    std::int64_t optimizeTransportParallel(const MatrixView& network);
+    std::int64_t optimizeTransportParallel(const TransportMatrix& network);
+
+    /**
+     * @brief All-pairs shortest travel times over the network's links
+     * @param network Square matrix; cell (i, j) > 0 is the travel time of a
+     *                direct link from node i to node j, 0 means no link
+     * @return Distances and next-hop routes between every pair of nodes
+     * @throws std::invalid_argument if the network is not square or has a
+     *         negative travel time
+     *
+     * @details
+     * Recursive Kleene closure (R-Kleene) over the same quadrant split as
+     * optimizeTransport: close the NW block, update the off-diagonal blocks
+     * and the SE block by min-plus products, close SE, and propagate back.
+     * Products recurse on their largest dimension until all three fit the
+     * leaf tile, where a min-plus kernel keeps 64-byte strips of the
+     * output in vector registers across the whole inner dimension, so the
+     * O(n^3) work is cache-oblivious rather than streaming the whole matrix
+     * once per intermediate node as Floyd-Warshall does. Distances are kept
+     * in 32 bits whenever the longest possible route fits, which doubles
+     * the kernel's vector width; otherwise in 64 bits.
+     */
+    ShortestPaths shortestPaths(const MatrixView& network);
+    ShortestPaths shortestPaths(const TransportMatrix& network);
+
+    /**
+     * @brief Task-parallel version of shortestPaths
+     * @return Same distances and next hops as shortestPaths
+     *
+     * @details
+     * Independent products (the two off-diagonal updates, and the halves of
+     * a product whose output does not overlap its inputs) run as tasks on
+     * the work-stealing pool above the parallel grain size. Every block is
+     * still updated in the serial order, so the result is deterministic.
+     */
+    ShortestPaths shortestPathsParallel(const MatrixView& network);
+    ShortestPaths shortestPathsParallel(const TransportMatrix& network);
+
+    /**
+     * @brief Sets the number of worker threads used by the parallel mode
+     * @param threads Worker count; 0 uses the hardware concurrency
+     */
+    void setThreadCount(unsigned threads);
+
+    /**
+     * @brief Sets the network size at or below which recursion runs serially
+     * @param grain Minimum rows of a subproblem that is split into tasks
+     */
+    void setParallelGrain(size_t grain) { parallelGrain_ = grain < 1 ? 1 : grain; }
+
+    /**
+     * @brief Sets the region size at which recursion stops for the leaf kernel
+     * @param tile Rows of the largest region evaluated without recursion;
+     *             1 recurses all the way down to single cells
      */
-    int optimizeTransport(const std::vector<std::vector<int>>& network);
+    void setTileSize(size_t tile) { tileSize_ = tile < 1 ? 1 : tile; }
 
     /**
      * @brief Performs empirical complexity analysis of the algorithm
      *
      * @details
-     * Measures execution times for networks of sizes 2, 4, 8, 16, 32 and
-     * calculates growth ratios to empirically validate O(n^2) complexity.
-     * Outputs timing data and compares with theoretical expectations.
+     * Runs measureScaling with the default options (sizes 16 to 1024),
+     * writes the per-size table and the fitted exponent with its
+     * confidence interval to out, and compares it with the expected 2.
      */
-    void analyzeComplexity();
+    void analyzeComplexity(std::ostream& out = std::cout);
+
+    /**
+     * @brief Measures how optimization time grows with network size
+     * @param options Sizes, repetitions and input mode
+     * @return Per-size timings and allocation counts plus the log-log fit
+     *
+     * @details
+     * Each size gets a seeded network, untimed warm-up runs, then timed
+     * samples at nanosecond resolution. Sizes too small to time reliably
+     * run several optimizations per sample. Allocations are counted
+     * through alloc_stats.hpp, and read 0 in programs that do not link
+     * alloc_counting; bytes copied are taken from bytesCopied().
+     */
+    ScalingReport measureScaling(const ScalingOptions& options = ScalingOptions());
+
+    /**
+     * @brief Bytes of caller-owned networks copied into internal storage
+     *        (the nested-vector entry point) since construction
+     */
+    std::uint64_t bytesCopied() const { return bytesCopied_; }
 
     /**
      * @brief Generates a random transport network for testing
@@ -89,9 +749,34 @@ public:
      * @details
      * Creates a test network with random integer values representing
      * transport connectivity weights or travel times between nodes.
+     * Seeds from std::random_device, so every call differs; use the
+     * NetworkSpec overload for reproducible networks.
      */
     static std::vector<std::vector<int>> generateNetwork(int size);
 
+    /**
+     * @brief Generates a reproducible network straight into flat storage
+     * @param spec Shape, seed and weight distribution of the network
+     * @param threads Worker threads; 0 uses the hardware concurrency
+     * @return Generated network; identical for every thread count
+     *
+     * @details
+     * Values come from a Philox4x32 counter-based RNG keyed by the seed,
+     * with counter (j / 4, i, stream): each call yields four adjacent cells,
+     * so row blocks are generated independently, in parallel, and several
+     * counters at a time in vector registers.
+     */
+    static TransportMatrix generateNetwork(const NetworkSpec& spec, unsigned threads = 0);
+
+    /**
+     * @brief Generates a random sparse transport network for testing
+     * @param size Dimension of the square network to generate
+     * @param links Number of random links to place (colliding links are summed)
+     * @param seed Seed of the random generator
+     * @return Sparse network with link values [1, 100]
+     */
+    static SparseTransportMatrix generateSparseNetwork(size_t size, size_t links, unsigned seed = 0);
+
     /**
      * @brief Public testing interface for region division functionality
      * @param network Input network to divide
@@ -103,18 +788,25 @@ public:
      * @details
      * Provides test access to the private divideIntoRegions method.
      * Used by unit tests to validate correct geographical division
-     * of Singapore transport networks.
+     * of Singapore transport networks. The quadrant views are copied
+     * out into the nested-vector outputs.
      */
     void testDivideIntoRegions(const std::vector<std::vector<int>>& network,
         std::vector<std::vector<int>>& ne,
         std::vector<std::vector<int>>& nw,
         std::vector<std::vector<int>>& se,
-        std::vector<std::vector<int>>& sw) {
-        divideIntoRegions(network, ne, nw, se, sw);
-    }
+        std::vector<std::vector<int>>& sw);
 
 private:
     int networkSize_; ///< Dimension of the transport network being optimized
+    size_t parallelGrain_ = 64;       ///< Serial recursion at or below this many rows
+    size_t tileSize_ = 32;            ///< Leaf kernel at or below this many rows
+    std::uint64_t bytesCopied_ = 0;   ///< See bytesCopied()
+    std::pmr::memory_resource* resource_;  ///< Per-call scratch storage
+    std::unique_ptr<TaskPool> pool_;  ///< Created on first parallel use
+    std::map<std::pair<size_t, size_t>, std::vector<int>> leafWeights_;  ///< Tile weights keyed by shape
+    std::pair<size_t, size_t> batchWeightsShape_;  ///< Shape batchWeights_ was built for
+    std::vector<std::uint8_t> batchWeights_;        ///< Whole-network weights for batches
 
     /**
      * @brief Handles base case optimization for small networks
@@ -122,10 +814,10 @@ private:
      * @return Optimization result for base case
      *
      * @details
-     * Implements constant-time optimization for networks of size 11.
+     * Sums a region that is a single row or column (including 11).
      * Serves as termination condition for the recursive algorithm.
      */
-    int baseOptimization(const std::vector<std::vector<int>>& subnetwork);
+    std::int64_t baseOptimization(const MatrixView& subnetwork);
 
     /**
      * @brief Divides network into 4 Singapore geographical regions
@@ -136,15 +828,14 @@ private:
      * @param[out] sw South-West region (bottom-right quadrant)
      *
      * @details
-     * Splits a square network into four equal quadrants representing
-     * Singapore's geographical divisions. Assumes network size is
-     * divisible by 2 for clean division.
+     * Splits an N x M network into four quadrants representing
+     * Singapore's geographical divisions. Odd dimensions are split into
+     * ceil/floor halves, the larger half going to the top and left, so
+     * every row and column is kept. The quadrants are views into the
+     * same storage; nothing is copied.
      */
-    void divideIntoRegions(const std::vector<std::vector<int>>& network,
-        std::vector<std::vector<int>>& ne,
-        std::vector<std::vector<int>>& nw,
-        std::vector<std::vector<int>>& se,
-        std::vector<std::vector<int>>& sw);
+    void divideIntoRegions(const MatrixView& network,
+        MatrixView& ne, MatrixView& nw, MatrixView& se, MatrixView& sw);
 
     /**
      * @brief Combines regional solutions with linear-time work
@@ -160,7 +851,273 @@ private:
      * inter-region connectivity. Implements the "+n" term in the
      * recurrence relation T(n) = 4T(n/2) + n.
      */
-    int combineSolutions(int ne_sol, int nw_sol, int se_sol, int sw_sol, const std::vector<std::vector<int>>& original_network);
+    std::int64_t combineSolutions(std::int64_t ne_sol, std::int64_t nw_sol, std::int64_t se_sol, std::int64_t sw_sol, const MatrixView& original_network);
+
+    /**
+     * @brief Evaluates a whole tile without recursing into it
+     * @param tile Subnetwork of at most tileSize_ rows and columns
+     * @return Exactly what the full recursion would return for the tile
+     *
+     * @details
+     * Every cell's contribution to the recursion is its value times a
+     * weight: 1 for the base-case sum plus 1 for every level below the
+     * tile whose diagonal passes through the cell. The kernel is a single
+     * 64-bit weighted reduction over the tile (AVX2 when available).
+     */
+    std::int64_t tileOptimization(const MatrixView& tile);
+
+    struct TiledStream;
+
+    /**
+     * @brief Recursion over one region of a tiled file
+     */
+    std::int64_t streamRegion(TiledStream& stream, size_t r0, size_t c0, size_t rows, size_t cols);
+
+    /**
+     * @brief Recursion over the links of one sparse region
+     * @param first, last Links inside the region; reordered in place
+     */
+    std::int64_t sparseOptimization(SparseLink* first, SparseLink* last,
+        size_t r0, size_t c0, size_t rows, size_t cols);
+
+    /**
+     * @brief Returns the cached per-cell weights for a rows x cols tile
+     *
+     * @details
+     * Builds and inserts them on a miss, which is not thread-safe; parallel
+     * callers run prepareLeafWeights first so that every lookup hits.
+     */
+    const std::vector<int>& leafWeights(size_t rows, size_t cols);
+
+    /**
+     * @brief Caches the weights of every tile shape parallelRegion reaches from rows x cols
+     *
+     * @details
+     * Each level of the ceil/floor split has at most two row and two column
+     * lengths, so this visits O(log n) shapes rather than every region.
+     */
+    void prepareLeafWeights(size_t rows, size_t cols);
+
+    /**
+     * @brief Recursive body of optimizeTransportParallel, after prepareLeafWeights
+     */
+    std::int64_t parallelRegion(const MatrixView& network);
+
+    /**
+     * @brief Per-cell multiplicities of the whole recursion for a shape
+     *
+     * @details
+     * A network's score is the sum of its cells times these weights, so
+     * batches of one shape share them. Cached for the last shape used.
+     */
+    const std::vector<std::uint8_t>& batchWeights(size_t rows, size_t cols);
+    void fillBatchWeights(std::uint8_t* weights, size_t stride, size_t r0, size_t c0, size_t rows, size_t cols);
+
+    /**
+     * @brief Shared body of shortestPaths and shortestPathsParallel
+     * @param pool Pool for independent products, nullptr to run serially
+     */
+    ShortestPaths solveShortestPaths(const MatrixView& network, TaskPool* pool);
+};
+
+/**
+ * @struct EdgeUpdate
+ * @brief New weight for one link of a transport network
+ */
+struct EdgeUpdate {
+    size_t row = 0;  ///< Row of the cell to change
+    size_t col = 0;  ///< Column of the cell to change
+    int weight = 0;  ///< New value of the cell
+};
+
+/**
+ * @class IncrementalTransportOptimizer
+ * @brief Keeps the quadtree of partial results so link updates are cheap
+ *
+ * @details
+ * Owns a copy of the network and the partial score of every region the
+ * recursion visits, down to the same leaf tiles SingaporeTransportOptimizer
+ * stops at. Changing one cell by d changes each ancestor region's score by
+ * the leaf's weight for that cell times d, plus d for every ancestor whose
+ * diagonal passes through the cell; only those O(log n) nodes are touched.
+ * score() always equals a full optimizeTransport over the current network.
+ */
+class IncrementalTransportOptimizer {
+public:
+    /**
+     * @brief Builds the quadtree and computes every partial score
+     * @param network Transport network (any N x M size)
+     * @param tileSize Regions of at most this many rows and columns are leaves
+     */
+    explicit IncrementalTransportOptimizer(TransportMatrix network, size_t tileSize = 32);
+
+    /**
+     * @brief Current optimization score of the whole network
+     */
+    std::int64_t score() const { return nodes_.empty() ? 0 : nodes_[0].score; }
+
+    /**
+     * @brief Sets one link weight and updates the affected partial scores
+     * @throws std::out_of_range if (row, col) is outside the network
+     */
+    void updateEdge(size_t row, size_t col, int weight);
+
+    /**
+     * @brief Applies several link updates, in order, sharing ancestor work
+     * @throws std::out_of_range if any cell is outside the network; no
+     *         update of the batch is applied in that case
+     *
+     * @details
+     * Each update only adds its delta to the nodes on its path; the deltas
+     * are then pushed up level by level, so an ancestor shared by many
+     * updates is recomputed once per batch instead of once per update.
+     */
+    void updateEdges(const std::vector<EdgeUpdate>& updates);
+
+    const TransportMatrix& network() const { return network_; }
+    size_t nodeCount() const { return nodes_.size(); }
+
+private:
+    struct Node {
+        size_t r0 = 0, c0 = 0;         ///< Top-left cell of the region
+        size_t rows = 0, cols = 0;     ///< Region shape
+        std::int64_t score = 0;        ///< Recursion result for the region
+        std::int64_t pending = 0;      ///< Delta gathered during a batch
+        int parent = -1;               ///< Index of the parent node, -1 at the root
+        int children[4] = { -1, -1, -1, -1 };  ///< NE, NW, SE, SW; -1 for leaves
+        int depth = 0;                 ///< Distance from the root
+        bool dirty = false;            ///< Queued for the current batch
+    };
+
+    int build(size_t r0, size_t c0, size_t rows, size_t cols, int parent, int depth);
+    void addDelta(size_t row, size_t col, std::int64_t delta);
+    void propagate();
+    const std::vector<int>& leafWeights(size_t rows, size_t cols);
+
+    TransportMatrix network_;                    ///< Current link weights
+    size_t tileSize_;                            ///< Largest leaf region edge
+    std::vector<Node> nodes_;                    ///< Quadtree, root first
+    std::vector<std::vector<int>> dirtyByDepth_; ///< Nodes with pending deltas per level
+    std::map<std::pair<size_t, size_t>, std::vector<int>> leafWeights_;  ///< Leaf weights keyed by shape; leaves look theirs up, so copies stay valid
+};
+
+/**
+ * @struct MemoStats
+ * @brief Lookups served by a MemoizedTransportOptimizer's region cache
+ */
+struct MemoStats {
+    std::uint64_t hits = 0;       ///< Regions whose score came from the cache
+    std::uint64_t misses = 0;     ///< Regions that had to be evaluated
+    std::uint64_t evictions = 0;  ///< Entries dropped to stay within capacity
+
+    double hitRate() const {
+        return hits + misses == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(hits + misses);
+    }
+};
+
+/**
+ * @class MemoizedTransportOptimizer
+ * @brief Optimizer that reuses the scores of identical regions
+ *
+ * @details
+ * Every region of the quadrant recursion gets a 128-bit fingerprint of its
+ * shape and cells, built bottom-up: leaves hash their cells, parents hash
+ * their four children's fingerprints. Scores are cached by fingerprint in
+ * an LRU table of bounded size, so any region seen before (earlier in the
+ * same network, in an earlier call, or in another scenario) is not
+ * evaluated again. The last network passed to optimizeTransport is kept as
+ * the base for optimizeScenario, which only re-fingerprints the regions
+ * on the paths to the changed cells.
+ */
+class MemoizedTransportOptimizer {
+public:
+    /**
+     * @param capacity Most region scores kept; the least recently used go first
+     * @param tileSize Regions of at most this many rows and columns are leaves
+     */
+    explicit MemoizedTransportOptimizer(size_t capacity = 65536, size_t tileSize = 32);
+
+    /**
+     * @brief Scores a network and makes it the base for scenarios
+     * @return Same score as SingaporeTransportOptimizer::optimizeTransport
+     *
+     * @details
+     * Reads every cell once to fingerprint the leaves; regions whose
+     * fingerprint is cached are then not evaluated.
+     */
+    std::int64_t optimizeTransport(const MatrixView& network);
+    std::int64_t optimizeTransport(const TransportMatrix& network);
+
+    /**
+     * @brief Scores the base network with some links changed
+     * @param edits Cells to change, applied in order; the base is not modified
+     * @return Same score as optimizeTransport on the edited network
+     * @throws std::logic_error if no base network has been optimized yet
+     * @throws std::out_of_range if any cell is outside the base network
+     *
+     * @details
+     * Only the leaves holding an edit are copied and re-hashed, and only
+     * their ancestors get new fingerprints; every other region keeps the
+     * base's fingerprint and is normally a cache hit. The cost grows with
+     * the number of changed regions, not with the network size.
+     */
+    std::int64_t optimizeScenario(const std::vector<EdgeUpdate>& edits);
+
+    const MemoStats& stats() const { return stats_; }
+    void resetStats() { stats_ = MemoStats(); }
+    size_t cachedRegions() const { return cache_.size(); }
+    size_t capacity() const { return capacity_; }
+
+    /**
+     * @brief Drops every cached score (the base network is kept)
+     */
+    void clear();
+
+private:
+    struct Fingerprint {
+        std::uint64_t lo = 0, hi = 0;  ///< Two independent 64-bit hashes
+        size_t rows = 0, cols = 0;     ///< Region shape
+
+        bool operator==(const Fingerprint& other) const {
+            return lo == other.lo && hi == other.hi && rows == other.rows && cols == other.cols;
+        }
+    };
+
+    struct FingerprintHash {
+        size_t operator()(const Fingerprint& fp) const { return static_cast<size_t>(fp.lo); }
+    };
+
+    struct Node {
+        size_t r0 = 0, c0 = 0;         ///< Top-left cell of the region
+        size_t rows = 0, cols = 0;     ///< Region shape
+        int children[4] = { -1, -1, -1, -1 };  ///< NE, NW, SE, SW; -1 for leaves
+        Fingerprint fingerprint;       ///< Of the base network's region
+        std::int64_t trace = 0;        ///< Base diagonal sum (internal regions)
+    };
+
+    struct Scenario;
+    using CacheList = std::list<std::pair<Fingerprint, std::int64_t>>;
+
+    int build(size_t r0, size_t c0, size_t rows, size_t cols);
+    void fingerprintBase(int index);
+    Fingerprint leafFingerprint(const MatrixView& leaf) const;
+    Fingerprint parentFingerprint(const Node& node, const Fingerprint* children) const;
+    std::int64_t evaluate(int index, const Scenario* scenario);
+    bool lookup(const Fingerprint& fp, std::int64_t& score);
+    void insert(const Fingerprint& fp, std::int64_t score);
+    const std::vector<int>& leafWeights(size_t rows, size_t cols);
+
+    size_t capacity_;                ///< Most cached scores
+    size_t tileSize_;                ///< Largest leaf region edge
+    TransportMatrix base_;           ///< Network of the last optimizeTransport
+    bool hasBase_ = false;           ///< optimizeTransport has been called
+    std::vector<Node> nodes_;        ///< Quadtree in pre-order, root first
+    std::vector<std::uint32_t> loKeys_;      ///< Random multiplier per leaf column, low lane
+    std::vector<std::uint32_t> hiKeys_;      ///< Random multiplier per leaf column, high lane
+    CacheList lru_;                  ///< Cached scores, most recently used first
+    std::unordered_map<Fingerprint, CacheList::iterator, FingerprintHash> cache_;  ///< Index into lru_
+    MemoStats stats_;                ///< Cache lookups since the last reset
+    std::map<std::pair<size_t, size_t>, std::vector<int>> leafWeights_;  ///< Leaf weights keyed by shape
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,765 @@
+/**
+ * @file transport_benchmark.cpp
+ * @brief Benchmarks for the Singapore transport optimizer
+ *
+ * @section description Description
+ * One benchmark per --bench mode; all but apsp run by default:
+ * - parallel: the parallel quadrant recursion against the serial one,
+ *   with the speedup per thread count.
+ * - layout: the row-major recursion against the bottom-up evaluator over
+ *   Z-order (Morton) storage, in time and last-level cache misses.
+ * - incremental: a link update through IncrementalTransportOptimizer
+ *   against a full re-optimization.
+ * - sparse: 1M x 1M networks with --links random links each.
+ * - file: writes each size as a TiledNetworkFile under --dir (never holding
+ *   the matrix in memory) and compares the streaming evaluator's read rate
+ *   with a plain sequential read. Drop the page cache between runs to
+ *   measure the disk rather than memory.
+ * - generate: the legacy nested generator against the seeded Philox
+ *   generator per thread count, checking every thread count agrees.
+ * - scaling: measureScaling over --sizes (16 to 16384 by default); the
+ *   table goes to --csv, the table plus exponent fit to --json.
+ * - batch: --snapshots same-sized networks, by looping optimizeTransport
+ *   and by one optimizeTransportBatch call per layout, in networks/s.
+ * - memo: MemoizedTransportOptimizer against the plain recursion: cold,
+ *   warm, on edited scenarios and on a network of repeated tiles.
+ * - memory: heap allocations of the nested-vector and sparse entry points,
+ *   with scratch on the heap and in an ArenaResource.
+ * - apsp: the recursive Kleene shortest-path solver against a naive
+ *   Floyd-Warshall. It is O(n^3); run it with --sizes 1024,2048,4096.
+ *
+ * @section usage Usage
+ * transportBenchmark [--sizes 1024,2048,4096] [--threads 1,2,4,8] [--grain 64]
+ *                    [--reps 3] [--bench parallel,layout,...,apsp]
+ *                    [--links 100000,1000000,4000000] [--dir .] [--snapshots 256]
+ *                    [--csv scaling.csv] [--json scaling.json]
+ *
+ * Cache misses are read from the Linux perf_event interface and reported as
+ * -1 where it is unavailable (other platforms, or perf_event_paranoid).
+ *
+ * Sizes up to 16384 are accepted (a 16384x16384 network is 1 GB of ints).
+ * Build with -DCMAKE_BUILD_TYPE=Release for meaningful numbers.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "alloc_stats.hpp"
+#include "memory_arena.hpp"
+#include "transport.hpp"
+
+#if defined(__linux__)
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+std::vector<std::string> parseNames(const std::string& list) {
+    std::vector<std::string> names;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) names.push_back(item);
+    }
+    return names;
+}
+
+/**
+ * @brief Counts hardware cache misses of the calling thread between
+ *        start() and stop(); stop() returns -1 if counting is unavailable
+ */
+class CacheMissCounter {
+public:
+    CacheMissCounter() {
+#if defined(__linux__)
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+
+    ~CacheMissCounter() {
+#if defined(__linux__)
+        if (fd_ >= 0) close(fd_);
+#endif
+    }
+
+    CacheMissCounter(const CacheMissCounter&) = delete;
+    CacheMissCounter& operator=(const CacheMissCounter&) = delete;
+
+    void start() {
+#if defined(__linux__)
+        if (fd_ < 0) return;
+        ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+
+    long long stop() {
+#if defined(__linux__)
+        if (fd_ < 0) return -1;
+        ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+        long long count = 0;
+        if (read(fd_, &count, sizeof(count)) != sizeof(count)) return -1;
+        return count;
+#else
+        return -1;
+#endif
+    }
+
+private:
+    int fd_ = -1;
+};
+
+std::vector<size_t> parseList(const std::string& list) {
+    std::vector<size_t> values;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) values.push_back(static_cast<size_t>(std::stoull(item)));
+    }
+    return values;
+}
+
+/**
+ * @brief Best-of-reps wall time of a callable in milliseconds
+ */
+template <typename F>
+double bestMillis(int reps, F&& run) {
+    double best = 0;
+    for (int r = 0; r < reps; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        auto end = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(end - start).count();
+        best = r == 0 ? ms : std::min(best, ms);
+    }
+    return best;
+}
+
+TransportMatrix makeNetwork(size_t size) {
+    return TransportMatrix(SingaporeTransportOptimizer::generateNetwork(static_cast<int>(size)));
+}
+
+void benchmarkParallel(const std::vector<size_t>& sizes, const std::vector<size_t>& threads,
+                       size_t grain, int reps) {
+    std::cout << "\n-----PARALLEL QUADRANT RECURSION-----" << std::endl;
+    std::cout << "size,threads,ms,speedup,matches_serial" << std::endl;
+
+    for (size_t size : sizes) {
+        TransportMatrix network = makeNetwork(size);
+        SingaporeTransportOptimizer optimizer(static_cast<int>(size));
+
+        std::int64_t serialResult = 0;
+        double serialMs = bestMillis(reps, [&] { serialResult = optimizer.optimizeTransport(network); });
+        std::cout << size << ",serial," << serialMs << ",1,true" << std::endl;
+
+        for (size_t t : threads) {
+            optimizer.setThreadCount(static_cast<unsigned>(t));
+            optimizer.setParallelGrain(grain);
+            std::int64_t result = 0;
+            double ms = bestMillis(reps, [&] { result = optimizer.optimizeTransportParallel(network); });
+            std::cout << size << "," << t << "," << ms << "," << serialMs / ms << ","
+                      << (result == serialResult ? "true" : "false") << std::endl;
+        }
+    }
+}
+
+/**
+ * @brief Row-major recursion vs Z-order bottom-up evaluation
+ *
+ * "recursive" recurses to single cells, "recursive_tiled" stops at the
+ * default leaf tile, and "morton" runs the stackless evaluator over a
+ * MortonMatrix built with the same tile (conversion timed separately).
+ * Cache misses are from the last repetition.
+ */
+void benchmarkLayout(const std::vector<size_t>& sizes, int reps) {
+    std::cout << "\n-----Z-ORDER LAYOUT-----" << std::endl;
+    std::cout << "size,layout,ms,cache_misses,matches_recursive" << std::endl;
+
+    const size_t tile = 32;
+    CacheMissCounter counter;
+    for (size_t size : sizes) {
+        TransportMatrix network = makeNetwork(size);
+        SingaporeTransportOptimizer optimizer(static_cast<int>(size));
+
+        auto measure = [&](const std::string& layout, std::int64_t expected, auto&& run) {
+            std::int64_t result = 0;
+            long long misses = -1;
+            double ms = bestMillis(reps, [&] {
+                counter.start();
+                result = run();
+                misses = counter.stop();
+            });
+            std::cout << size << "," << layout << "," << ms << "," << misses << ","
+                      << (result == expected ? "true" : "false") << std::endl;
+        };
+
+        std::int64_t expected = optimizer.optimizeTransport(network);
+        optimizer.setTileSize(1);
+        measure("recursive", expected, [&] { return optimizer.optimizeTransport(network); });
+        optimizer.setTileSize(tile);
+        measure("recursive_tiled", expected, [&] { return optimizer.optimizeTransport(network); });
+
+        MortonMatrix morton;
+        double convertMs = bestMillis(reps, [&] { morton = MortonMatrix(network, tile); });
+        std::cout << size << ",morton_convert," << convertMs << ",-1,true" << std::endl;
+        measure("morton", expected, [&] { return optimizer.optimizeTransport(morton); });
+    }
+}
+
+/**
+ * @brief Per-update cost of the cached quadtree vs a full recomputation
+ *
+ * Times 10000 random single-link updates, the same number in batches of
+ * 64, and one full optimizeTransport, then checks the cached score.
+ */
+void benchmarkIncremental(const std::vector<size_t>& sizes, int reps) {
+    std::cout << "\n-----INCREMENTAL UPDATES-----" << std::endl;
+    std::cout << "size,mode,total_ms,us_per_update,matches_full" << std::endl;
+
+    const size_t updates = 10000;
+    const size_t batchSize = 64;
+    for (size_t size : sizes) {
+        TransportMatrix network = makeNetwork(size);
+        SingaporeTransportOptimizer optimizer(static_cast<int>(size));
+
+        double buildMs = 0;
+        {
+            auto start = std::chrono::steady_clock::now();
+            IncrementalTransportOptimizer probe(network);
+            auto end = std::chrono::steady_clock::now();
+            buildMs = std::chrono::duration<double, std::milli>(end - start).count();
+        }
+        IncrementalTransportOptimizer incremental(network);
+
+        std::mt19937 gen(static_cast<unsigned>(size));
+        std::uniform_int_distribution<size_t> cell(0, size - 1);
+        std::uniform_int_distribution<int> weight(1, 100);
+        std::vector<EdgeUpdate> stream(updates);
+        for (EdgeUpdate& update : stream) {
+            update = { cell(gen), cell(gen), weight(gen) };
+        }
+
+        // Shift the weights every round so no repetition degenerates into no-op updates.
+        int round = 0;
+        double singleMs = bestMillis(reps, [&] {
+            ++round;
+            for (const EdgeUpdate& update : stream) {
+                incremental.updateEdge(update.row, update.col, update.weight + round);
+            }
+        });
+        double batchMs = bestMillis(reps, [&] {
+            ++round;
+            std::vector<EdgeUpdate> batch(batchSize);
+            for (size_t k = 0; k < updates; k += batchSize) {
+                size_t count = std::min(batchSize, updates - k);
+                batch.resize(count);
+                for (size_t b = 0; b < count; ++b) {
+                    batch[b] = stream[k + b];
+                    batch[b].weight += round;
+                }
+                incremental.updateEdges(batch);
+            }
+        });
+
+        std::int64_t full = 0;
+        double fullMs = bestMillis(reps, [&] { full = optimizer.optimizeTransport(incremental.network()); });
+        const char* matches = incremental.score() == full ? "true" : "false";
+
+        std::cout << size << ",build," << buildMs << ",-," << matches << std::endl;
+        std::cout << size << ",single," << singleMs << "," << singleMs * 1000.0 / updates << "," << matches << std::endl;
+        std::cout << size << ",batch" << batchSize << "," << batchMs << "," << batchMs * 1000.0 / updates << "," << matches << std::endl;
+        std::cout << size << ",full," << fullMs << "," << fullMs * 1000.0 << "," << matches << std::endl;
+    }
+}
+
+/**
+ * @brief Time and memory of the sparse path as the link count grows
+ */
+void benchmarkSparse(const std::vector<size_t>& linkCounts, int reps) {
+    std::cout << "\n-----SPARSE NETWORKS-----" << std::endl;
+    std::cout << "size,links,nonzeros,memory_mb,ms,ns_per_link" << std::endl;
+
+    const size_t size = 1000000;
+    SingaporeTransportOptimizer optimizer(static_cast<int>(size));
+    for (size_t links : linkCounts) {
+        SparseTransportMatrix network = SingaporeTransportOptimizer::generateSparseNetwork(size, links, 39);
+        std::int64_t result = 0;
+        double ms = bestMillis(reps, [&] { result = optimizer.optimizeTransport(network); });
+        (void)result;
+        std::cout << size << "," << links << "," << network.nonZeros() << ","
+                  << network.memoryBytes() / (1024.0 * 1024.0) << "," << ms << ","
+                  << (network.nonZeros() == 0 ? 0.0 : ms * 1e6 / network.nonZeros()) << std::endl;
+    }
+}
+
+/**
+ * @brief Deterministic cell values for networks that never sit in memory
+ */
+int hashedCell(size_t i, size_t j) {
+    std::uint64_t x = (static_cast<std::uint64_t>(i) << 32) ^ j;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    return static_cast<int>(x % 100) + 1;
+}
+
+/**
+ * @brief Streaming evaluation of tiled files vs raw sequential reads
+ */
+void benchmarkFile(const std::vector<size_t>& sizes, const std::string& dir, int reps) {
+    std::cout << "\n-----TILED FILE STREAMING-----" << std::endl;
+    std::cout << "size,file_mb,write_ms,read_ms,read_mb_s,stream_ms,stream_mb_s,matches_memory" << std::endl;
+
+    SingaporeTransportOptimizer optimizer(0);
+    for (size_t size : sizes) {
+        std::string path = dir + "/transport_tiled_" + std::to_string(size) + ".bin";
+        double writeMs = bestMillis(1, [&] { TiledNetworkFile::write(path, size, size, 32, hashedCell); });
+        double fileMb = (32.0 + static_cast<double>(size) * size * sizeof(int)) / (1024.0 * 1024.0);
+
+        std::vector<char> buffer(1 << 20);
+        double readMs = bestMillis(reps, [&] {
+            std::FILE* file = std::fopen(path.c_str(), "rb");
+            if (!file) return;
+            while (std::fread(buffer.data(), 1, buffer.size(), file) == buffer.size()) {
+            }
+            std::fclose(file);
+        });
+
+        std::int64_t streamed = 0;
+        double streamMs = bestMillis(reps, [&] { streamed = optimizer.optimizeTransportFile(path); });
+
+        // Only compare against memory while the dense matrix comfortably fits (256 MB).
+        std::string matches = "-";
+        if (size <= 8192) {
+            TransportMatrix network(size, size);
+            for (size_t i = 0; i < size; ++i) {
+                for (size_t j = 0; j < size; ++j) {
+                    network(i, j) = hashedCell(i, j);
+                }
+            }
+            matches = optimizer.optimizeTransport(network) == streamed ? "true" : "false";
+        }
+
+        std::cout << size << "," << fileMb << "," << writeMs << "," << readMs << ","
+                  << fileMb * 1000.0 / readMs << "," << streamMs << "," << fileMb * 1000.0 / streamMs << ","
+                  << matches << std::endl;
+        std::remove(path.c_str());
+    }
+}
+
+/**
+ * @brief The original generator: a fresh mt19937 filling nested rows serially
+ */
+std::vector<std::vector<int>> legacyGenerate(size_t size) {
+    std::vector<std::vector<int>> network(size, std::vector<int>(size));
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    std::uniform_int_distribution<> dis(1, 100);
+    for (auto& row : network) {
+        for (int& value : row) {
+            value = dis(gen);
+        }
+    }
+    return network;
+}
+
+/**
+ * @brief Legacy mt19937 generator vs seeded Philox generator
+ */
+void benchmarkGenerate(const std::vector<size_t>& sizes, const std::vector<size_t>& threads, int reps) {
+    std::cout << "\n-----NETWORK GENERATION-----" << std::endl;
+    std::cout << "size,generator,threads,ms,matches_serial" << std::endl;
+
+    for (size_t size : sizes) {
+        double legacyMs = bestMillis(reps, [&] {
+            auto network = legacyGenerate(size);
+            (void)network;
+        });
+        std::cout << size << ",mt19937_nested,1," << legacyMs << ",-" << std::endl;
+
+        NetworkSpec spec;
+        spec.rows = spec.cols = size;
+        spec.seed = 41;
+        TransportMatrix serial;
+        double serialMs = bestMillis(reps, [&] { serial = SingaporeTransportOptimizer::generateNetwork(spec, 1); });
+        std::cout << size << ",philox,1," << serialMs << ",true" << std::endl;
+
+        for (size_t t : threads) {
+            if (t == 1) continue;
+            TransportMatrix network;
+            double ms = bestMillis(reps, [&] {
+                network = SingaporeTransportOptimizer::generateNetwork(spec, static_cast<unsigned>(t));
+            });
+            bool same = std::equal(network.data(), network.data() + size * size, serial.data());
+            std::cout << size << ",philox," << t << "," << ms << "," << (same ? "true" : "false") << std::endl;
+        }
+    }
+}
+
+/**
+ * @brief Looping optimizeTransport vs one optimizeTransportBatch call
+ *
+ * Each size gets --snapshots seeded networks (fewer if the batch would
+ * exceed 512 MB). Throughput is networks per second; packing the batch is
+ * timed separately, since snapshots normally arrive already packed.
+ */
+void benchmarkBatch(const std::vector<size_t>& sizes, size_t snapshots, int reps) {
+    std::cout << "\n-----BATCH EVALUATION-----" << std::endl;
+    std::cout << "size,snapshots,mode,ms,networks_per_sec,speedup,matches_loop" << std::endl;
+
+    const size_t budgetBytes = size_t(512) << 20;
+    for (size_t size : sizes) {
+        size_t count = std::max<size_t>(1, std::min(snapshots, budgetBytes / (size * size * sizeof(int))));
+        std::vector<TransportMatrix> networks;
+        for (size_t k = 0; k < count; ++k) {
+            NetworkSpec spec;
+            spec.rows = spec.cols = size;
+            spec.seed = 44 + k;
+            networks.push_back(SingaporeTransportOptimizer::generateNetwork(spec));
+        }
+        SingaporeTransportOptimizer optimizer(static_cast<int>(size));
+
+        std::vector<std::int64_t> expected(count);
+        double loopMs = bestMillis(reps, [&] {
+            for (size_t k = 0; k < count; ++k) {
+                expected[k] = optimizer.optimizeTransport(networks[k]);
+            }
+        });
+        std::cout << size << "," << count << ",loop," << loopMs << "," << count / (loopMs / 1000) << ",1,true" << std::endl;
+
+        for (BatchLayout layout : { BatchLayout::Planar, BatchLayout::Interleaved }) {
+            const char* name = layout == BatchLayout::Planar ? "planar" : "interleaved";
+            NetworkBatch batch;
+            double packMs = bestMillis(reps, [&] { batch = NetworkBatch::fromNetworks(networks, layout); });
+            std::vector<std::int64_t> scores;
+            double ms = bestMillis(reps, [&] { scores = optimizer.optimizeTransportBatch(batch); });
+            std::cout << size << "," << count << "," << name << "," << ms << "," << count / (ms / 1000) << ","
+                      << loopMs / ms << "," << (scores == expected ? "true" : "false") << std::endl;
+            std::cout << size << "," << count << "," << name << "_pack," << packMs << ",-,-,-" << std::endl;
+        }
+    }
+}
+
+/**
+ * @brief Textbook Floyd-Warshall with next hops, the baseline for apsp
+ *
+ * Same 32-bit distances and branch-free inner loop as the recursive
+ * solver's leaf kernel, so the comparison isolates the memory traffic:
+ * every intermediate node streams the whole n x n matrix.
+ */
+std::vector<std::int64_t> naiveFloydWarshall(const TransportMatrix& network) {
+    const std::int32_t inf = std::numeric_limits<std::int32_t>::max() / 2;
+    size_t n = network.rows();
+    std::vector<std::int32_t> dist(n * n);
+    std::vector<std::uint32_t> next(n * n);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            bool linked = i != j && network(i, j) > 0;
+            dist[i * n + j] = i == j ? 0 : linked ? network(i, j) : inf;
+            next[i * n + j] = static_cast<std::uint32_t>(j);
+        }
+    }
+    for (size_t k = 0; k < n; ++k) {
+        const std::int32_t* via = &dist[k * n];
+        for (size_t i = 0; i < n; ++i) {
+            std::int32_t leg = dist[i * n + k];
+            if (i == k || leg >= inf) continue;
+            std::uint32_t hop = next[i * n + k];
+            std::int32_t* row = &dist[i * n];
+            std::uint32_t* hops = &next[i * n];
+            for (size_t j = 0; j < n; ++j) {
+                std::int32_t candidate = leg + via[j];
+                bool shorter = candidate < row[j];
+                row[j] = shorter ? candidate : row[j];
+                hops[j] = shorter ? hop : hops[j];
+            }
+        }
+    }
+    std::vector<std::int64_t> result(dist.begin(), dist.end());
+    for (std::int64_t& d : result) {
+        if (d >= inf) d = ShortestPaths::kUnreachable;
+    }
+    return result;
+}
+
+/**
+ * @brief Recursive Kleene APSP vs naive Floyd-Warshall
+ *
+ * Networks are seeded with 10% of links present (weights 1-100). Each
+ * thread count runs shortestPathsParallel; the naive baseline is serial.
+ */
+void benchmarkApsp(const std::vector<size_t>& sizes, const std::vector<size_t>& threads, size_t grain, int reps) {
+    std::cout << "\n-----ALL-PAIRS SHORTEST PATHS-----" << std::endl;
+    std::cout << "size,solver,threads,ms,speedup_vs_naive,matches_naive" << std::endl;
+
+    for (size_t size : sizes) {
+        NetworkSpec spec;
+        spec.rows = spec.cols = size;
+        spec.seed = 43;
+        spec.distribution = WeightDistribution::Sparse;
+        spec.density = 0.1;
+        TransportMatrix network = SingaporeTransportOptimizer::generateNetwork(spec);
+        SingaporeTransportOptimizer optimizer(static_cast<int>(size));
+
+        std::vector<std::int64_t> expected;
+        double naiveMs = bestMillis(reps, [&] { expected = naiveFloydWarshall(network); });
+        std::cout << size << ",floyd_warshall,1," << naiveMs << ",1,true" << std::endl;
+
+        ShortestPaths paths;
+        double serialMs = bestMillis(reps, [&] { paths = optimizer.shortestPaths(network); });
+        std::cout << size << ",r_kleene,1," << serialMs << "," << naiveMs / serialMs << ","
+                  << (paths.distances() == expected ? "true" : "false") << std::endl;
+
+        for (size_t t : threads) {
+            if (t == 1) continue;
+            optimizer.setThreadCount(static_cast<unsigned>(t));
+            optimizer.setParallelGrain(grain);
+            double ms = bestMillis(reps, [&] { paths = optimizer.shortestPathsParallel(network); });
+            std::cout << size << ",r_kleene," << t << "," << ms << "," << naiveMs / ms << ","
+                      << (paths.distances() == expected ? "true" : "false") << std::endl;
+        }
+    }
+}
+
+/**
+ * @brief Memoized evaluation against the plain recursion
+ *
+ * Per size: the plain optimizer, a cold and a warm MemoizedTransportOptimizer
+ * over the same random network, scenarios of 1, 16 and 256 random edits on
+ * top of it, and a network built from one repeated 32 x 32 tile. Each row
+ * reports the cache hit rate of its last run.
+ */
+void benchmarkMemo(const std::vector<size_t>& sizes, int reps) {
+    std::cout << "\n-----MEMOIZED EVALUATION-----" << std::endl;
+    std::cout << "size,mode,ms,speedup,hit_rate,matches_plain" << std::endl;
+
+    for (size_t size : sizes) {
+        TransportMatrix network = makeNetwork(size);
+        SingaporeTransportOptimizer optimizer(static_cast<int>(size));
+        std::int64_t expected = 0;
+        double plainMs = bestMillis(reps, [&] { expected = optimizer.optimizeTransport(network); });
+        std::cout << size << ",plain," << plainMs << ",1,-,true" << std::endl;
+
+        auto report = [&](const std::string& mode, double ms, const MemoizedTransportOptimizer& memo, bool matches) {
+            std::cout << size << "," << mode << "," << ms << "," << plainMs / ms << ","
+                      << memo.stats().hitRate() << "," << (matches ? "true" : "false") << std::endl;
+        };
+
+        MemoizedTransportOptimizer memo;
+        std::int64_t score = 0;
+        double coldMs = bestMillis(reps, [&] {
+            memo.clear();
+            memo.resetStats();
+            score = memo.optimizeTransport(network);
+        });
+        report("memo_cold", coldMs, memo, score == expected);
+
+        double warmMs = bestMillis(reps, [&] {
+            memo.resetStats();
+            score = memo.optimizeTransport(network);
+        });
+        report("memo_warm", warmMs, memo, score == expected);
+
+        std::mt19937 gen(static_cast<unsigned>(size));
+        std::uniform_int_distribution<size_t> cell(0, size - 1);
+        std::uniform_int_distribution<int> weight(1, 100);
+        for (size_t edits : { 1, 16, 256 }) {
+            std::vector<EdgeUpdate> scenario(edits);
+            TransportMatrix edited = network;
+            for (EdgeUpdate& edit : scenario) {
+                edit = { cell(gen), cell(gen), weight(gen) };
+                edited(edit.row, edit.col) = edit.weight;
+            }
+            double scenarioMs = bestMillis(reps, [&] {
+                memo.resetStats();
+                score = memo.optimizeScenario(scenario);
+            });
+            report("scenario" + std::to_string(edits), scenarioMs, memo,
+                   score == optimizer.optimizeTransport(edited));
+        }
+
+        TransportMatrix tiled(size, size);
+        for (size_t i = 0; i < size; ++i) {
+            for (size_t j = 0; j < size; ++j) {
+                tiled(i, j) = network(i % 32, j % 32);
+            }
+        }
+        expected = optimizer.optimizeTransport(tiled);
+        double tiledPlainMs = bestMillis(reps, [&] { optimizer.optimizeTransport(tiled); });
+        MemoizedTransportOptimizer tiledMemo;
+        double tiledMs = bestMillis(reps, [&] {
+            tiledMemo.clear();
+            tiledMemo.resetStats();
+            score = tiledMemo.optimizeTransport(tiled);
+        });
+        std::cout << size << ",repeated_tiles_plain," << tiledPlainMs << ",1,-,true" << std::endl;
+        std::cout << size << ",repeated_tiles_memo," << tiledMs << "," << tiledPlainMs / tiledMs << ","
+                  << tiledMemo.stats().hitRate() << "," << (score == expected ? "true" : "false") << std::endl;
+    }
+}
+
+/**
+ * @brief Heap allocations and time of the allocating entry points, with
+ *        scratch on the heap and in a reused ArenaResource
+ *
+ * Runs the nested-vector entry point at each size and a 1M x 1M sparse
+ * network with 100000 links; the arena is released after every run, as a
+ * request handler would.
+ */
+void benchmarkMemory(const std::vector<size_t>& sizes, int reps) {
+    std::cout << "\n-----SCRATCH MEMORY-----" << std::endl;
+    std::cout << "input,size,resource,ms,heap_allocations_per_run,matches" << std::endl;
+
+    auto measure = [&](const std::string& input, size_t size, auto&& run) {
+        ArenaResource arena;
+        std::int64_t expected = 0, score = 0;
+        for (int mode = 0; mode < 2; ++mode) {
+            SingaporeTransportOptimizer optimizer(static_cast<int>(size));
+            if (mode == 1) optimizer.setMemoryResource(&arena);
+            run(optimizer);  // warm-up: leaf weights and the arena's chunk
+            arena.release();
+
+            AllocationStats before = currentAllocationStats();
+            double ms = bestMillis(reps, [&] {
+                score = run(optimizer);
+                arena.release();
+            });
+            double allocations = static_cast<double>((currentAllocationStats() - before).allocations) / reps;
+            if (mode == 0) expected = score;
+            std::cout << input << "," << size << "," << (mode == 0 ? "heap" : "arena") << "," << ms << ","
+                      << allocations << "," << (score == expected ? "true" : "false") << std::endl;
+        }
+    };
+
+    for (size_t size : sizes) {
+        std::vector<std::vector<int>> nested = makeNetwork(size).toNested();
+        measure("nested", size, [&](SingaporeTransportOptimizer& optimizer) { return optimizer.optimizeTransport(nested); });
+    }
+    SparseTransportMatrix sparse = SingaporeTransportOptimizer::generateSparseNetwork(1 << 20, 100000, 46);
+    measure("sparse", size_t(1) << 20, [&](SingaporeTransportOptimizer& optimizer) { return optimizer.optimizeTransport(sparse); });
+}
+
+/**
+ * @brief Scaling harness over the requested sizes, exported as CSV/JSON
+ */
+void benchmarkScaling(const std::vector<size_t>& sizes, int reps,
+                      const std::string& csvPath, const std::string& jsonPath) {
+    std::cout << "\n-----SCALING-----" << std::endl;
+    ScalingOptions options;
+    options.sizes = sizes;
+    options.repetitions = std::max(3, reps);
+
+    SingaporeTransportOptimizer optimizer(0);
+    ScalingReport report = optimizer.measureScaling(options);
+    report.writeCsv(std::cout);
+    std::cout << "exponent," << report.exponent << ",ci95," << report.exponentLow << ","
+              << report.exponentHigh << ",r_squared," << report.rSquared << std::endl;
+
+    if (!csvPath.empty()) {
+        std::ofstream csv(csvPath);
+        report.writeCsv(csv);
+    }
+    if (!jsonPath.empty()) {
+        std::ofstream json(jsonPath);
+        report.writeJson(json);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::vector<size_t> sizes = { 1024, 2048, 4096 };
+    std::vector<size_t> scalingSizes = { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192, 16384 };
+    std::vector<size_t> threads;
+    for (size_t t = 1; t <= std::max(1u, std::thread::hardware_concurrency()); t *= 2) {
+        threads.push_back(t);
+    }
+    size_t grain = 64;
+    int reps = 3;
+    size_t snapshots = 256;
+    std::vector<size_t> links = { 100000, 1000000, 4000000 };
+    std::string dir = ".";
+    std::string csvPath;
+    std::string jsonPath;
+    std::vector<std::string> benches = { "parallel", "layout", "incremental", "sparse", "file", "generate", "scaling", "batch", "memo", "memory" };
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        std::string value = argv[i + 1];
+        if (flag == "--sizes") {
+            sizes = parseList(value);
+            scalingSizes = sizes;
+        } else if (flag == "--threads") {
+            threads = parseList(value);
+        } else if (flag == "--grain") {
+            grain = static_cast<size_t>(std::stoull(value));
+        } else if (flag == "--csv") {
+            csvPath = value;
+        } else if (flag == "--json") {
+            jsonPath = value;
+        } else if (flag == "--dir") {
+            dir = value;
+        } else if (flag == "--snapshots") {
+            snapshots = std::max<size_t>(1, std::stoull(value));
+        } else if (flag == "--links") {
+            links = parseList(value);
+        } else if (flag == "--bench") {
+            benches = parseNames(value);
+        } else if (flag == "--reps") {
+            reps = std::max(1, std::stoi(value));
+        } else {
+            std::cerr << "Unknown option: " << flag << std::endl;
+            return 1;
+        }
+    }
+
+    for (const std::string& bench : benches) {
+        if (bench == "parallel") {
+            benchmarkParallel(sizes, threads, grain, reps);
+        } else if (bench == "layout") {
+            benchmarkLayout(sizes, reps);
+        } else if (bench == "incremental") {
+            benchmarkIncremental(sizes, reps);
+        } else if (bench == "sparse") {
+            benchmarkSparse(links, reps);
+        } else if (bench == "file") {
+            benchmarkFile(sizes, dir, reps);
+        } else if (bench == "generate") {
+            benchmarkGenerate(sizes, threads, reps);
+        } else if (bench == "batch") {
+            benchmarkBatch(sizes, snapshots, reps);
+        } else if (bench == "memory") {
+            benchmarkMemory(sizes, reps);
+        } else if (bench == "memo") {
+            benchmarkMemo(sizes, reps);
+        } else if (bench == "apsp") {
+            benchmarkApsp(sizes, threads, grain, reps);
+        } else if (bench == "scaling") {
+            benchmarkScaling(scalingSizes, reps, csvPath, jsonPath);
+        } else {
+            std::cerr << "Unknown benchmark: " << bench << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,385 @@
+/**
+ * @file transport_paths.cpp
+ * @brief All-pairs shortest paths by recursive Kleene closure
+ *
+ * @section description Description
+ * Implements SingaporeTransportOptimizer::shortestPaths. The closure of the
+ * min-plus matrix is computed on quadrants (R-Kleene): with the network
+ * split into [A11 A12; A21 A22],
+ *
+ *   A11 = A11*;  A12 = A11 A12;  A21 = A21 A11;  A22 = min(A22, A21 A12);
+ *   A22 = A22*;  A21 = A22 A21;  A12 = A12 A22;  A11 = min(A11, A12 A21);
+ *
+ * where products are min-plus and accumulate into the existing block. Every
+ * block lives in the one n x n matrix, so the updates run in place; a value
+ * is only ever replaced by the length of a real, shorter route, which keeps
+ * in-place updates exact. Each improvement also copies the first hop of the
+ * route's first leg, so next hops stay consistent without a second pass.
+ */
+
+#include "transport.hpp"
+#include "instrumentation.hpp"
+#include <algorithm>
+#include <stdexcept>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+/**
+ * @brief Rectangle of the distance matrix: rows [r0, r0 + rows), columns
+ *        [c0, c0 + cols)
+ */
+struct Block {
+    size_t r0 = 0, c0 = 0;
+    size_t rows = 0, cols = 0;
+
+    Block topRows(size_t count) const { return { r0, c0, count, cols }; }
+    Block bottomRows(size_t count) const { return { r0 + count, c0, rows - count, cols }; }
+    Block leftCols(size_t count) const { return { r0, c0, rows, count }; }
+    Block rightCols(size_t count) const { return { r0, c0 + count, rows, cols - count }; }
+
+    bool overlaps(const Block& other) const {
+        return r0 < other.r0 + other.rows && other.r0 < r0 + rows
+            && c0 < other.c0 + other.cols && other.c0 < c0 + cols;
+    }
+};
+
+const std::uint32_t kNoHop = static_cast<std::uint32_t>(-1);
+
+/**
+ * @brief dist[j] = min(dist[j], base + via[j]) over one row, recording hop
+ *        wherever the route through via is shorter
+ *
+ * Written without branches so the compiler can vectorize it; with 32-bit
+ * distances every lane of dist lines up with a lane of next.
+ */
+template <typename Dist>
+inline void relaxRow(Dist* dist, std::uint32_t* next, const Dist* via, Dist base, std::uint32_t hop, size_t count) {
+    for (size_t j = 0; j < count; ++j) {
+        Dist candidate = base + via[j];
+        bool shorter = candidate < dist[j];
+        dist[j] = shorter ? candidate : dist[j];
+        next[j] = shorter ? hop : next[j];
+    }
+}
+
+/**
+ * @brief Min-plus product of one row of legs with a Width-wide column strip
+ *
+ * dist[j] = min(dist[j], legs[k] + via[k * stride + j]) over all k, with
+ * the strip's distances and hops held in registers for the whole k loop,
+ * so each step costs one load of via instead of a load and store of dist
+ * and next as well. Legs at or above infinity (no route) are skipped.
+ * Reading a stale copy of the strip through legs or via (in-place
+ * updates) is harmless: it only offers an older, no shorter route.
+ */
+template <typename Dist, size_t Width>
+inline void relaxStrip(Dist* dist, std::uint32_t* next, const Dist* legs, const std::uint32_t* legHops,
+                       const Dist* via, size_t stride, size_t count, Dist infinity) {
+    Dist best[Width];
+    std::uint32_t hops[Width];
+    std::copy(dist, dist + Width, best);
+    std::copy(next, next + Width, hops);
+    for (size_t k = 0; k < count; ++k, via += stride) {
+        Dist leg = legs[k];
+        if (leg >= infinity) continue;
+        std::uint32_t hop = legHops[k];
+        for (size_t j = 0; j < Width; ++j) {
+            Dist candidate = leg + via[j];
+            bool shorter = candidate < best[j];
+            best[j] = shorter ? candidate : best[j];
+            hops[j] = shorter ? hop : hops[j];
+        }
+    }
+    std::copy(best, best + Width, dist);
+    std::copy(hops, hops + Width, next);
+}
+
+#if defined(__SSE2__)
+/**
+ * @brief SSE2 strip for 32-bit distances: four registers of distances,
+ *        blended by the compare mask (SSE2 has no min_epi32)
+ *
+ * Hops stay in memory: late in the closure most legs improve nothing, so
+ * the blends and the hop update are skipped unless some lane got shorter.
+ */
+template <>
+inline void relaxStrip<std::int32_t, 16>(std::int32_t* dist, std::uint32_t* next, const std::int32_t* legs,
+                                         const std::uint32_t* legHops, const std::int32_t* via, size_t stride,
+                                         size_t count, std::int32_t infinity) {
+    __m128i best[4];
+    for (int q = 0; q < 4; ++q) {
+        best[q] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dist + 4 * q));
+    }
+    for (size_t k = 0; k < count; ++k, via += stride) {
+        if (legs[k] >= infinity) continue;
+        __m128i leg = _mm_set1_epi32(legs[k]);
+        __m128i candidate[4], shorter[4];
+        __m128i any = _mm_setzero_si128();
+        for (int q = 0; q < 4; ++q) {
+            candidate[q] = _mm_add_epi32(leg, _mm_loadu_si128(reinterpret_cast<const __m128i*>(via + 4 * q)));
+            shorter[q] = _mm_cmplt_epi32(candidate[q], best[q]);
+            any = _mm_or_si128(any, shorter[q]);
+        }
+        if (_mm_movemask_epi8(any) == 0) continue;
+        __m128i hop = _mm_set1_epi32(static_cast<int>(legHops[k]));
+        for (int q = 0; q < 4; ++q) {
+            __m128i* hops = reinterpret_cast<__m128i*>(next + 4 * q);
+            best[q] = _mm_or_si128(_mm_and_si128(shorter[q], candidate[q]), _mm_andnot_si128(shorter[q], best[q]));
+            _mm_storeu_si128(hops, _mm_or_si128(_mm_and_si128(shorter[q], hop),
+                                                _mm_andnot_si128(shorter[q], _mm_loadu_si128(hops))));
+        }
+    }
+    for (int q = 0; q < 4; ++q) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dist + 4 * q), best[q]);
+    }
+}
+#endif
+
+/**
+ * @brief In-place R-Kleene closure over one n x n distance / next-hop pair
+ *
+ * kInfinity is half the range of Dist, so adding two entries never
+ * overflows; the caller picks a Dist wide enough that no real route
+ * reaches it.
+ */
+template <typename Dist>
+class KleeneSolver {
+public:
+    static constexpr Dist kInfinity = std::numeric_limits<Dist>::max() / 2;
+
+    KleeneSolver(Dist* dist, std::uint32_t* next, size_t n, size_t tile, size_t grain, TaskPool* pool)
+        : dist_(dist), next_(next), n_(n), tile_(tile), grain_(grain), pool_(pool) {}
+
+    void closure(const Block& a) {
+        if (a.rows <= tile_) {
+            leafClosure(a);
+            return;
+        }
+
+        size_t half = (a.rows + 1) / 2;
+        Block a11 = a.topRows(half).leftCols(half);
+        Block a12 = a.topRows(half).rightCols(half);
+        Block a21 = a.bottomRows(half).leftCols(half);
+        Block a22 = a.bottomRows(half).rightCols(half);
+        bool parallel = pool_ && a.rows > grain_;
+
+        closure(a11);
+        fork(parallel, [&] { multiply(a12, a11, a12); }, [&] { multiply(a21, a21, a11); });
+        multiply(a22, a21, a12);
+        closure(a22);
+        fork(parallel, [&] { multiply(a21, a22, a21); }, [&] { multiply(a12, a12, a22); });
+        multiply(a11, a12, a21);
+    }
+
+private:
+    Dist* dist(size_t i, size_t j) { return dist_ + i * n_ + j; }
+    std::uint32_t* next(size_t i, size_t j) { return next_ + i * n_ + j; }
+
+    template <typename F, typename G>
+    void fork(bool parallel, F&& first, G&& second) {
+        if (!parallel) {
+            first();
+            second();
+            return;
+        }
+        TaskPool::TaskGroup group;
+        pool_->run(group, second);
+        first();
+        pool_->wait(group);
+    }
+
+    /**
+     * @brief c = min(c, a (x) b), splitting the largest of the three
+     *        dimensions until everything fits the leaf tile
+     *
+     * Splitting c's rows or columns gives two independent products unless
+     * one half writes what the other reads (in-place updates such as
+     * A12 = A11 A12); those, and splits of the inner dimension, run in order.
+     */
+    void multiply(const Block& c, const Block& a, const Block& b) {
+        size_t m = c.rows, k = a.cols, p = c.cols;
+        if (m <= tile_ && k <= tile_ && p <= tile_) {
+            leafMultiply(c, a, b);
+            return;
+        }
+
+        bool parallel = pool_ && std::max(m, p) > grain_;
+        if (m >= k && m >= p) {
+            size_t half = (m + 1) / 2;
+            Block cTop = c.topRows(half), cBottom = c.bottomRows(half);
+            Block aTop = a.topRows(half), aBottom = a.bottomRows(half);
+            bool independent = !c.overlaps(b) && !cTop.overlaps(aBottom) && !cBottom.overlaps(aTop);
+            fork(parallel && independent,
+                 [&] { multiply(cTop, aTop, b); }, [&] { multiply(cBottom, aBottom, b); });
+        } else if (p >= k) {
+            size_t half = (p + 1) / 2;
+            Block cLeft = c.leftCols(half), cRight = c.rightCols(half);
+            Block bLeft = b.leftCols(half), bRight = b.rightCols(half);
+            bool independent = !c.overlaps(a) && !cLeft.overlaps(bRight) && !cRight.overlaps(bLeft);
+            fork(parallel && independent,
+                 [&] { multiply(cLeft, a, bLeft); }, [&] { multiply(cRight, a, bRight); });
+        } else {
+            size_t half = (k + 1) / 2;
+            multiply(c, a.leftCols(half), b.topRows(half));
+            multiply(c, a.rightCols(half), b.bottomRows(half));
+        }
+    }
+
+    void leafMultiply(const Block& c, const Block& a, const Block& b) {
+        // One 64-byte strip: 16 distances and 16 hops in 32-bit mode.
+        const size_t width = 64 / sizeof(Dist);
+        for (size_t i = 0; i < c.rows; ++i) {
+            Dist* cRow = dist(c.r0 + i, c.c0);
+            std::uint32_t* hopRow = next(c.r0 + i, c.c0);
+            const Dist* legs = dist(a.r0 + i, a.c0);
+            const std::uint32_t* legHops = next(a.r0 + i, a.c0);
+            size_t j = 0;
+            for (; j + width <= c.cols; j += width) {
+                relaxStrip<Dist, width>(cRow + j, hopRow + j, legs, legHops, dist(b.r0, b.c0 + j), n_, a.cols, kInfinity);
+            }
+            if (j == c.cols) continue;
+            for (size_t k = 0; k < a.cols; ++k) {
+                if (legs[k] >= kInfinity) continue;
+                relaxRow(cRow + j, hopRow + j, dist(b.r0 + k, b.c0 + j), legs[k], legHops[k], c.cols - j);
+            }
+        }
+    }
+
+    /**
+     * @brief Floyd-Warshall on a diagonal block small enough to stay in cache
+     */
+    void leafClosure(const Block& a) {
+        for (size_t k = 0; k < a.rows; ++k) {
+            const Dist* via = dist(a.r0 + k, a.c0);
+            for (size_t i = 0; i < a.rows; ++i) {
+                Dist leg = *dist(a.r0 + i, a.c0 + k);
+                if (i == k || leg >= kInfinity) continue;
+                relaxRow(dist(a.r0 + i, a.c0), next(a.r0 + i, a.c0), via, leg, *next(a.r0 + i, a.c0 + k), a.cols);
+            }
+        }
+    }
+
+    Dist* dist_;            ///< Row-major n x n distances
+    std::uint32_t* next_;   ///< Row-major n x n first hops
+    size_t n_;              ///< Nodes
+    size_t tile_;           ///< Leaf size of closures and products
+    size_t grain_;          ///< Serial at or below this many rows or columns
+    TaskPool* pool_;        ///< nullptr for the serial solver
+};
+
+/**
+ * @brief Loads the links into Dist form, closes them and widens the
+ *        distances into the result
+ */
+template <typename Dist>
+void solveClosure(const MatrixView& network, std::vector<std::int64_t>& distances,
+                  std::vector<std::uint32_t>& nextHops, size_t tile, size_t grain, TaskPool* pool) {
+    const Dist infinity = KleeneSolver<Dist>::kInfinity;
+    size_t n = network.rows;
+    std::vector<Dist> dist(n * n);
+    for (size_t i = 0; i < n; ++i) {
+        const int* links = network.row(i);
+        for (size_t j = 0; j < n; ++j) {
+            bool linked = links[j] > 0 && i != j;
+            dist[i * n + j] = i == j ? 0 : linked ? static_cast<Dist>(links[j]) : infinity;
+            nextHops[i * n + j] = i == j || linked ? static_cast<std::uint32_t>(j) : kNoHop;
+        }
+    }
+
+    KleeneSolver<Dist> solver(dist.data(), nextHops.data(), n, tile, grain, pool);
+    solver.closure({ 0, 0, n, n });
+
+    for (size_t cell = 0; cell < n * n; ++cell) {
+        distances[cell] = dist[cell] >= infinity ? ShortestPaths::kUnreachable : static_cast<std::int64_t>(dist[cell]);
+    }
+}
+
+} // namespace
+
+std::int64_t ShortestPaths::distance(size_t from, size_t to) const {
+    if (from >= nodes_ || to >= nodes_) {
+        throw std::out_of_range("ShortestPaths: node outside the network");
+    }
+    return distances_[from * nodes_ + to];
+}
+
+size_t ShortestPaths::nextHop(size_t from, size_t to) const {
+    if (from >= nodes_ || to >= nodes_) {
+        throw std::out_of_range("ShortestPaths: node outside the network");
+    }
+    std::uint32_t hop = nextHops_[from * nodes_ + to];
+    return hop == kNoHop ? kNoRoute : hop;
+}
+
+std::vector<size_t> ShortestPaths::route(size_t from, size_t to) const {
+    std::vector<size_t> nodes;
+    if (nextHop(from, to) == kNoRoute) {
+        return nodes;
+    }
+    // Link times are positive, so each hop strictly shortens the remaining
+    // distance and the walk ends at to within nodes_ steps.
+    nodes.push_back(from);
+    while (from != to) {
+        from = nextHops_[from * nodes_ + to];
+        nodes.push_back(from);
+    }
+    return nodes;
+}
+
+ShortestPaths SingaporeTransportOptimizer::shortestPaths(const TransportMatrix& network) {
+    return shortestPaths(network.view());
+}
+
+ShortestPaths SingaporeTransportOptimizer::shortestPaths(const MatrixView& network) {
+    return solveShortestPaths(network, nullptr);
+}
+
+ShortestPaths SingaporeTransportOptimizer::shortestPathsParallel(const TransportMatrix& network) {
+    return shortestPathsParallel(network.view());
+}
+
+ShortestPaths SingaporeTransportOptimizer::shortestPathsParallel(const MatrixView& network) {
+    if (!pool_) {
+        setThreadCount(0);
+    }
+    return solveShortestPaths(network, pool_.get());
+}
+
+ShortestPaths SingaporeTransportOptimizer::solveShortestPaths(const MatrixView& network, TaskPool* pool) {
+    ALGO_SPAN("transport.shortest_paths");
+    if (network.rows != network.cols) {
+        throw std::invalid_argument("shortestPaths: network must be square");
+    }
+    size_t n = network.rows;
+    if (n >= kNoHop) {
+        throw std::invalid_argument("shortestPaths: too many nodes");
+    }
+
+    std::int64_t longestLink = 0;
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            if (network.at(i, j) < 0) {
+                throw std::invalid_argument("shortestPaths: travel times cannot be negative");
+            }
+            longestLink = std::max<std::int64_t>(longestLink, network.at(i, j));
+        }
+    }
+
+    ShortestPaths paths;
+    paths.nodes_ = n;
+    paths.distances_.resize(n * n);
+    paths.nextHops_.resize(n * n);
+
+    // A shortest route has at most n - 1 links; if the longest such route
+    // stays below the 32-bit infinity, 32-bit distances are exact.
+    std::int64_t longestRoute = longestLink * static_cast<std::int64_t>(n > 0 ? n - 1 : 0);
+    if (longestRoute < KleeneSolver<std::int32_t>::kInfinity) {
+        solveClosure<std::int32_t>(network, paths.distances_, paths.nextHops_, tileSize_, parallelGrain_, pool);
+    } else {
+        solveClosure<std::int64_t>(network, paths.distances_, paths.nextHops_, tileSize_, parallelGrain_, pool);
+    }
+    return paths;
+}
@@ -4,7 +4,13 @@
 #include <algorithm>
 #include <random>
 #include <set>
+#include <fstream>
+#include <cstdio>
+#include <limits>
+#include <stdexcept>
+#include "../src/alloc_stats.hpp"
 #include "../src/bucket_sort.hpp"
+#include "../src/memory_arena.hpp"
 
 class BucketSortTest : public ::testing::Test {
 protected:
@@ -173,3 +179,355 @@ TEST_F(BucketSortTest, PerformanceComparison) {
     std::cout << "Bucket sort avg: " << bucket_avg / 1000.0 << " microseconds" << std::endl;
     std::cout << "Std sort avg: " << std_avg / 1000.0 << " microseconds" << std::endl;
 }
+
+TEST_F(BucketSortTest, ExternalSortSmallBudget) {
+    const std::string input = "external_sort_input.txt";
+    const std::string output = "external_sort_output.txt";
+
+    std::mt19937 gen(12345);
+    std::uniform_int_distribution<int> dist(-50000, 50000);
+    std::vector<int> original(60000);
+    {
+        std::ofstream file(input);
+        for (int& n : original) {
+            n = dist(gen);
+            file << n << "\n";
+        }
+        // a run of duplicates exercises the single-value spill path
+        for (int i = 0; i < 5000; i++) {
+            original.push_back(7);
+            file << 7 << "\n";
+        }
+    }
+
+    // 64 KB budget forces the ~260 KB input through partitioning and recursion
+    sorter.addNumbers({ 3, 1, 2 });
+    ExternalSortStats stats = sorter.externalSort(input, output, 64 * 1024);
+    ASSERT_TRUE(stats.ok) << stats.error;
+    EXPECT_EQ(sorter.getNumbers(), std::vector<int>({ 3, 1, 2 }));
+    EXPECT_EQ(stats.elements, original.size());
+    EXPECT_GT(stats.spillFiles, 1u);
+    ASSERT_EQ(stats.phases.size(), 3u);
+    EXPECT_GT(stats.phases[0].bytesRead, 0u);
+    EXPECT_GT(stats.phases[1].bytesWritten, 0u);
+    EXPECT_GT(stats.phases[2].bytesWritten, 0u);
+
+    std::vector<int> sorted;
+    {
+        std::ifstream file(output);
+        int value;
+        while (file >> value) sorted.push_back(value);
+    }
+    std::sort(original.begin(), original.end());
+    EXPECT_EQ(sorted, original);
+
+    std::remove(input.c_str());
+    std::remove(output.c_str());
+}
+
+TEST_F(BucketSortTest, ExternalSortReportsSpillFailure) {
+    const std::string input = "external_sort_failure_input.txt";
+    const std::string output = "external_sort_failure_output.txt";
+    {
+        std::ofstream file(input);
+        for (int i = 0; i < 1000; i++) file << (i * 7919) % 1000 << "\n";
+    }
+
+    ExternalSortStats stats = sorter.externalSort(input, output, 64 * 1024, "no_such_spill_dir");
+    EXPECT_FALSE(stats.ok);
+    EXPECT_FALSE(stats.error.empty());
+
+    std::remove(input.c_str());
+    std::remove(output.c_str());
+}
+
+// out-of-range and non-numeric tokens are skipped and counted; the rest still sorts
+TEST_F(BucketSortTest, ExternalSortSkipsMalformedInput) {
+    const std::string input = "external_sort_malformed_input.txt";
+    const std::string output = "external_sort_malformed_output.txt";
+    {
+        std::ofstream file(input);
+        file << "5 99999999999 1\n2 x 3\n-2147483648 2147483647 2147483648 "
+             << "123456789012345678901234567890 -7 4y\n";
+    }
+
+    ExternalSortStats stats = sorter.externalSort(input, output, 64 * 1024);
+    ASSERT_TRUE(stats.ok) << stats.error;
+    EXPECT_EQ(stats.elements, 7u);
+    EXPECT_EQ(stats.malformed, 5u);
+
+    std::vector<long long> sorted;
+    {
+        std::ifstream file(output);
+        long long value;
+        while (file >> value) sorted.push_back(value);
+    }
+    EXPECT_EQ(sorted, (std::vector<long long>{ -2147483648LL, -7, 1, 2, 3, 5, 2147483647LL }));
+
+    std::remove(input.c_str());
+    std::remove(output.c_str());
+}
+
+TEST_F(BucketSortTest, SmallRangeUsesCountingSort) {
+    sorter.loadFromFile("../../../src/thousand.txt");
+    ASSERT_EQ(sorter.getNumberCount(), 1000);
+
+    sorter.bucketSort();
+    EXPECT_EQ(sorter.getLastStrategy(), SortStrategy::Counting);
+    EXPECT_TRUE(isSorted());
+}
+
+TEST_F(BucketSortTest, AutoStrategySelection) {
+    std::mt19937 gen(7);
+
+    // many duplicates in a narrow range
+    std::uniform_int_distribution<int> narrow(-20, 20);
+    for (int i = 0; i < 500; i++) sorter.addNumber(narrow(gen));
+    sorter.bucketSort();
+    EXPECT_EQ(sorter.getLastStrategy(), SortStrategy::Counting);
+    EXPECT_TRUE(isSorted());
+
+    // mid-range ints, enough of them for radix
+    sorter.clearNumbers();
+    std::uniform_int_distribution<int> mid(0, 1000000);
+    for (int i = 0; i < 10000; i++) sorter.addNumber(mid(gen));
+    sorter.bucketSort();
+    EXPECT_EQ(sorter.getLastStrategy(), SortStrategy::Radix);
+    EXPECT_TRUE(isSorted());
+
+    // a few widely spread values stay on the bucket sort
+    sorter.clearNumbers();
+    std::uniform_int_distribution<int> wide(-1000000000, 1000000000);
+    for (int i = 0; i < 100; i++) sorter.addNumber(wide(gen));
+    sorter.bucketSort();
+    EXPECT_EQ(sorter.getLastStrategy(), SortStrategy::Bucket);
+    EXPECT_TRUE(isSorted());
+}
+
+TEST_F(BucketSortTest, ForcedStrategiesAgree) {
+    std::mt19937 gen(99);
+    std::uniform_int_distribution<int> dist(-300000, 300000);
+    std::vector<int> original(5000);
+    for (int& n : original) n = dist(gen);
+    original.push_back(std::numeric_limits<int>::max());
+    original.push_back(std::numeric_limits<int>::min());
+    std::vector<int> expected = original;
+    std::sort(expected.begin(), expected.end());
+
+    for (SortStrategy strategy : { SortStrategy::Bucket, SortStrategy::Radix, SortStrategy::InPlace }) {
+        sorter.clearNumbers();
+        for (int n : original) sorter.addNumber(n);
+        sorter.setStrategy(strategy);
+        sorter.bucketSort();
+        EXPECT_EQ(sorter.getLastStrategy(), strategy) << sortStrategyName(strategy);
+        EXPECT_EQ(sorter.getNumbers(), expected) << sortStrategyName(strategy);
+    }
+
+    // counting sort over the full int range falls back to radix
+    sorter.clearNumbers();
+    for (int n : original) sorter.addNumber(n);
+    sorter.setStrategy(SortStrategy::Counting);
+    sorter.bucketSort();
+    EXPECT_EQ(sorter.getLastStrategy(), SortStrategy::Radix);
+    EXPECT_EQ(sorter.getNumbers(), expected);
+
+    // and handles a bounded range directly
+    sorter.clearNumbers();
+    for (int n : original) sorter.addNumber(n / 1000);
+    sorter.bucketSort();
+    EXPECT_EQ(sorter.getLastStrategy(), SortStrategy::Counting);
+    EXPECT_TRUE(isSorted());
+}
+
+TEST_F(BucketSortTest, IncrementalBatchesMergeIntoSortedState) {
+    std::mt19937 gen(2024);
+    std::uniform_int_distribution<int> dist(-1000000, 1000000);
+
+    std::vector<int> expected(200000);
+    for (int& n : expected) n = dist(gen);
+    sorter.addNumbers(expected);
+    sorter.bucketSort();
+    EXPECT_TRUE(sorter.isSorted());
+
+    for (int round = 0; round < 10; round++) {
+        std::vector<int> batch(1000);
+        for (int& n : batch) n = dist(gen);
+        // include values at both ends of the sorted prefix
+        batch[0] = -2000000;
+        batch[1] = 2000000;
+        for (int n : batch) sorter.addNumber(n);
+        expected.insert(expected.end(), batch.begin(), batch.end());
+        EXPECT_FALSE(sorter.isSorted());
+
+        sorter.bucketSort();
+        EXPECT_TRUE(sorter.isSorted());
+    }
+
+    std::sort(expected.begin(), expected.end());
+    const BucketSort& constSorter = sorter;
+    EXPECT_EQ(constSorter.getNumbers(), expected);
+
+    // nothing appended: the call is a no-op
+    sorter.bucketSort();
+    EXPECT_EQ(sorter.getLastStrategy(), SortStrategy::Auto);
+    EXPECT_EQ(constSorter.getNumbers(), expected);
+}
+
+TEST_F(BucketSortTest, RankQueriesSortOnlyNeededBuckets) {
+    std::mt19937 gen(31337);
+    std::uniform_int_distribution<int> dist(-5000000, 5000000);
+    std::vector<int> original(100000);
+    for (int& n : original) n = dist(gen);
+    sorter.addNumbers(original);
+
+    std::vector<int> expected = original;
+    std::sort(expected.begin(), expected.end());
+
+    EXPECT_EQ(sorter.nthElement(0), expected.front());
+    EXPECT_EQ(sorter.nthElement(54321), expected[54321]);
+    EXPECT_EQ(sorter.nthElement(expected.size() - 1), expected.back());
+
+    std::vector<int> top = sorter.topK(100);
+    ASSERT_EQ(top.size(), 100u);
+    for (size_t i = 0; i < top.size(); i++) {
+        EXPECT_EQ(top[i], expected[expected.size() - 1 - i]);
+    }
+
+    std::vector<int> ps = sorter.percentiles({ 50, 90, 99 });
+    ASSERT_EQ(ps.size(), 3u);
+    EXPECT_EQ(ps[0], expected[49999]);
+    EXPECT_EQ(ps[1], expected[89999]);
+    EXPECT_EQ(ps[2], expected[98999]);
+
+    // only a handful of buckets were sorted
+    EXPECT_FALSE(sorter.isSorted());
+    EXPECT_TRUE(hasAllOriginalData(original));
+
+    // appending invalidates the bucketing; results track the new data
+    sorter.addNumber(10000000);
+    EXPECT_EQ(sorter.topK(1), std::vector<int>{ 10000000 });
+    EXPECT_THROW(sorter.nthElement(original.size() + 1), std::out_of_range);
+}
+
+TEST_F(BucketSortTest, PercentilesNearestRank) {
+    for (int i = 1000; i >= 1; i--) sorter.addNumber(i);
+
+    std::vector<int> ps = sorter.percentiles({ 0, 50, 90, 99, 100 });
+    EXPECT_EQ(ps, (std::vector<int>{ 1, 500, 900, 990, 1000 }));
+    EXPECT_EQ(sorter.topK(3), (std::vector<int>{ 1000, 999, 998 }));
+}
+
+TEST_F(BucketSortTest, InPlaceAmericanFlagSort) {
+    sorter.setStrategy(SortStrategy::InPlace);
+    std::mt19937 gen(4242);
+
+    // wide range, narrow range with duplicates, and tiny partitions
+    std::vector<std::uniform_int_distribution<int>> dists = {
+        std::uniform_int_distribution<int>(std::numeric_limits<int>::min(), std::numeric_limits<int>::max()),
+        std::uniform_int_distribution<int>(-100, 100),
+        std::uniform_int_distribution<int>(0, 1 << 20),
+    };
+    for (auto& dist : dists) {
+        for (size_t size : { size_t(5), size_t(33), size_t(50000) }) {
+            std::vector<int> original(size);
+            for (int& n : original) n = dist(gen);
+            std::vector<int> expected = original;
+            std::sort(expected.begin(), expected.end());
+
+            sorter.clearNumbers();
+            sorter.addNumbers(original);
+            sorter.bucketSort();
+            EXPECT_EQ(sorter.getLastStrategy(), SortStrategy::InPlace);
+            const BucketSort& constSorter = sorter;
+            EXPECT_EQ(constSorter.getNumbers(), expected) << "size " << size;
+        }
+    }
+}
+
+TEST_F(BucketSortTest, StringSortMatchesStdSort) {
+    std::mt19937 gen(555);
+    std::uniform_int_distribution<int> id(0, 2000000);
+    std::uniform_int_distribution<int> len(0, 20);
+    std::uniform_int_distribution<int> ch(0, 255);
+
+    std::vector<std::string> keys;
+    // long shared prefix, like station names
+    for (int i = 0; i < 20000; i++) keys.push_back("Station_" + std::to_string(id(gen)));
+    // arbitrary bytes, including embedded NULs and empty strings
+    for (int i = 0; i < 5000; i++) {
+        std::string s(len(gen), '\0');
+        for (char& c : s) c = static_cast<char>(ch(gen) % 4 == 0 ? 0 : ch(gen));
+        keys.push_back(s);
+    }
+    keys.push_back("");
+    keys.push_back(std::string("a\0", 2));
+    keys.push_back("a");
+    keys.push_back(std::string("Station_") + std::string(40, 'x'));
+    keys.push_back(std::string("Station_") + std::string(41, 'x'));
+    std::shuffle(keys.begin(), keys.end(), gen);
+
+    std::vector<std::string> expected = keys;
+    std::sort(expected.begin(), expected.end());
+
+    BucketSort::sortStrings(keys);
+    EXPECT_EQ(keys, expected);
+}
+
+TEST_F(BucketSortTest, MemoryResourcesMatchHeap) {
+    std::mt19937 gen(46);
+    std::uniform_int_distribution<int> dist(-100000, 100000);
+    std::vector<int> input(20000);
+    for (int& v : input) v = dist(gen);
+    std::vector<int> expected = input;
+    std::sort(expected.begin(), expected.end());
+
+    ArenaResource arena;
+    SizeClassPool pool;
+    for (SortStrategy s : { SortStrategy::Auto, SortStrategy::Bucket, SortStrategy::Counting,
+                            SortStrategy::Radix, SortStrategy::InPlace }) {
+        for (std::pmr::memory_resource* resource : { static_cast<std::pmr::memory_resource*>(&arena),
+                                                     static_cast<std::pmr::memory_resource*>(&pool) }) {
+            BucketSort local(resource);
+            local.setStrategy(s);
+            local.getNumbers() = input;
+            local.bucketSort();
+            EXPECT_EQ(local.getNumbers(), expected) << sortStrategyName(s);
+            EXPECT_EQ(local.getMemoryResource(), resource);
+            arena.release();
+        }
+    }
+
+    // The per-bucket vectors of the classic sort come from the arena, not the heap.
+    BucketSort heapSorter, arenaSorter(&arena);
+    heapSorter.setStrategy(SortStrategy::Bucket);
+    arenaSorter.setStrategy(SortStrategy::Bucket);
+    heapSorter.getNumbers() = input;
+    arenaSorter.getNumbers() = input;
+    AllocationStats before = currentAllocationStats();
+    heapSorter.bucketSort();
+    std::uint64_t heapAllocations = (currentAllocationStats() - before).allocations;
+    before = currentAllocationStats();
+    arenaSorter.bucketSort();
+    std::uint64_t arenaAllocations = (currentAllocationStats() - before).allocations;
+    EXPECT_EQ(arenaSorter.getNumbers(), heapSorter.getNumbers());
+    EXPECT_LT(arenaAllocations * 10, heapAllocations);
+    EXPECT_GT(arena.allocationCount(), 0u);
+
+    // release() keeps one chunk, so the next round allocates nothing upstream.
+    arena.release();
+    EXPECT_EQ(arena.chunkCount(), 1u);
+    EXPECT_EQ(arena.bytesUsed(), 0u);
+    std::size_t reserved = arena.bytesReserved();
+    void* first = arena.allocate(24, 64);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(first) % 64, 0u);
+    EXPECT_EQ(arena.bytesReserved(), reserved);
+
+    // Freed blocks are reused by the next request of the same class.
+    void* block = pool.allocate(100);
+    pool.deallocate(block, 100);
+    EXPECT_EQ(pool.allocate(120), block);
+    std::size_t upstream = pool.upstreamAllocations();
+    void* large = pool.allocate(1 << 20);
+    EXPECT_EQ(pool.upstreamAllocations(), upstream + 1);
+    pool.deallocate(large, 1 << 20);
+}
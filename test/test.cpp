@@ -1,7 +1,18 @@
 #include <gtest/gtest.h>
 #include <iostream>
 #include <chrono>
+#include <fstream>
+#include <cstdio>
 #include "../src/algo.hpp"
+#include "../src/memory_arena.hpp"
+#include "../src/instrumentation.hpp"
+#include "../src/query_server.hpp"
+#include "../src/station_generator.hpp"
+#include <iterator>
+#include <sstream>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
 
 //the class will inhherit from the test framework of GTest.
 class AlgoTest : public ::testing::Test{
@@ -22,3 +33,341 @@ protected :
     }
 };
 
+TEST_F(AlgoTest, StationsSortedByName) {
+    const std::string path = "algo_test_stations.txt";
+    {
+        std::ofstream file(path);
+        for (int id : { 10, 2, 33, 1, 200, 21 }) file << "Station_" << id << "\n";
+    }
+    algo.loadStations(path);
+    std::remove(path.c_str());
+
+    std::vector<Station> sorted = algo.getStationsSortedByName();
+    std::vector<std::string> names;
+    for (const auto& s : sorted) names.emplace_back(s.name);
+    EXPECT_EQ(names, (std::vector<std::string>{ "Station_1", "Station_10", "Station_2",
+                                                "Station_200", "Station_21", "Station_33" }));
+    EXPECT_EQ(sorted[1].id, 10);
+}
+
+TEST_F(AlgoTest, StationsLoadIntoArena) {
+    const std::string path = "algo_test_arena_stations.txt";
+    {
+        std::ofstream file(path);
+        for (int id = 1; id <= 1000; ++id) file << "Station_" << id << "\n";
+    }
+    ArenaResource arena;
+    Algo arenaAlgo(&arena);
+    arenaAlgo.loadStations(path);
+    std::remove(path.c_str());
+
+    EXPECT_GE(arena.bytesUsed(), 1000 * sizeof(Station));
+    int probes = 0;
+    EXPECT_EQ(arenaAlgo.interpolationSearch(500, probes), 499);
+    EXPECT_EQ(arenaAlgo.getStationsSortedByName().front().name, "Station_1");
+}
+
+TEST_F(AlgoTest, LongStationNamesLoadIntoArena) {
+    //"Station_" plus a 10-digit id is past the 15-character inline buffer
+    const std::string path = "algo_test_arena_long_names.txt";
+    {
+        std::ofstream file(path);
+        for (int64_t id = 1; id <= 1000; ++id) file << "Station_" << 1300000000 + id << "\n";
+    }
+    ArenaResource arena;
+    Algo arenaAlgo(&arena);
+    arenaAlgo.loadStations(path);
+    std::remove(path.c_str());
+
+    EXPECT_GE(arena.bytesUsed(), 1000 * (sizeof(Station) + std::strlen("Station_1300000001")));
+}
+
+//the recorder works whether or not the macros are compiled in, so it is called directly here.
+TEST(InstrumentationTest, ExportsTraceAndMetrics) {
+    Instrumentation::reset();
+    {
+        Instrumentation::Span span("test.span");
+        Instrumentation::DepthScope outer("test.depth");
+        Instrumentation::DepthScope inner("test.depth");
+        Instrumentation::addCount("test.counter", 3);
+        Instrumentation::addCount("test.counter", 4);
+        Instrumentation::recordValue("test.histogram", 0);
+        Instrumentation::recordValue("test.histogram", 5);
+    }
+
+    std::ostringstream trace;
+    Instrumentation::writeChromeTrace(trace);
+    EXPECT_NE(trace.str().find("\"name\": \"test.span\""), std::string::npos);
+    EXPECT_NE(trace.str().find("\"ph\": \"X\""), std::string::npos);
+    EXPECT_NE(trace.str().find("\"test.counter\": 7"), std::string::npos);
+
+    //a span over a second in keeps microsecond resolution: fixed point, never 1.50016e+06
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    { Instrumentation::Span late("test.late"); }
+    std::ostringstream lateTrace;
+    Instrumentation::writeChromeTrace(lateTrace);
+    const std::string lateText = lateTrace.str();
+    size_t lateAt = lateText.find("\"name\": \"test.late\"");
+    ASSERT_NE(lateAt, std::string::npos);
+    size_t tsAt = lateText.find("\"ts\": ", lateAt) + 6;
+    const std::string ts = lateText.substr(tsAt, lateText.find(',', tsAt) - tsAt);
+    EXPECT_EQ(ts.find_first_of("eE"), std::string::npos) << ts;
+    ASSERT_NE(ts.find('.'), std::string::npos) << ts;
+    EXPECT_EQ(ts.size() - ts.find('.'), 4u) << ts;
+    EXPECT_GE(std::stod(ts), 1.0e6);
+
+    std::ostringstream metrics;
+    Instrumentation::writePrometheus(metrics);
+    const std::string text = metrics.str();
+    EXPECT_NE(text.find("algo_counter{name=\"test.counter\"} 7"), std::string::npos);
+    EXPECT_NE(text.find("algo_span_seconds_count{name=\"test.span\"} 1"), std::string::npos);
+    EXPECT_NE(text.find("algo_recursion_depth_max{name=\"test.depth\"} 2"), std::string::npos);
+    EXPECT_NE(text.find("algo_histogram_bucket{name=\"test.histogram\",le=\"0\"} 1"), std::string::npos);
+    EXPECT_NE(text.find("algo_histogram_bucket{name=\"test.histogram\",le=\"7\"} 2"), std::string::npos);
+    EXPECT_NE(text.find("algo_histogram_bucket{name=\"test.histogram\",le=\"+Inf\"} 2"), std::string::npos);
+    EXPECT_NE(text.find("algo_histogram_sum{name=\"test.histogram\"} 5"), std::string::npos);
+
+    Instrumentation::reset();
+    std::ostringstream empty;
+    Instrumentation::writePrometheus(empty);
+    EXPECT_EQ(empty.str().find("test.counter"), std::string::npos);
+}
+
+//ids past the int range come back whole from the target pickers.
+TEST_F(AlgoTest, TargetsKeepWideIds) {
+    const std::string path = "algo_test_wide_ids.txt";
+    const int64_t base = 5000000000LL;
+    {
+        std::ofstream file(path);
+        for (int64_t i = 0; i < 100; ++i) file << "Station_" << base + i * 10 << "\n";
+    }
+    ASSERT_TRUE(algo.loadStations(path));
+    std::remove(path.c_str());
+
+    for (int round = 0; round < 20; ++round) {
+        int64_t target = algo.setRandomFaultyStation();
+        EXPECT_GT(target, base);
+        EXPECT_LT(target, base + 990);
+        EXPECT_NE(target % 10, 0);
+    }
+    int probes = 0;
+    EXPECT_GE(algo.interpolationSearch(algo.pickTargetFromStations(), probes), 0);
+}
+
+//lookups through the pipeline match interpolationSearch, in input order, in both formats.
+TEST_F(AlgoTest, QueryServerAnswersLookups) {
+    const std::string path = "algo_test_serve_stations.txt";
+    {
+        std::ofstream file(path);
+        for (int id = 1; id <= 1000; ++id) file << "Station_" << id * 3 << "\n";
+    }
+    ASSERT_TRUE(algo.loadStations(path));
+    std::remove(path.c_str());
+
+    ServeOptions options;
+    options.batchSize = 7;   //forces many batches through small queues
+    options.queueDepth = 2;
+    QueryServer server(&algo, options);
+
+    std::istringstream text("3 4\n 3000 junk\t-5 999999999999999999999 300\n");
+    std::ostringstream textOut;
+    ServeStats stats = server.run(text, textOut);
+    EXPECT_EQ(textOut.str(), "0\n-1\n999\n-1\n99\n");
+    EXPECT_EQ(stats.queries, 5u);
+    EXPECT_EQ(stats.found, 3u);
+    EXPECT_EQ(stats.malformed, 2u);
+
+    std::vector<std::int64_t> ids;
+    for (int k = 0; k < 100; ++k) ids.push_back(k * 31);
+    std::string bytes(reinterpret_cast<const char*>(ids.data()), ids.size() * sizeof(std::int64_t));
+    options.format = ServeFormat::Binary;
+    std::istringstream binary(bytes);
+    std::ostringstream binaryOut;
+    stats = QueryServer(&algo, options).run(binary, binaryOut);
+    ASSERT_EQ(binaryOut.str().size(), ids.size() * sizeof(std::int64_t));
+    const std::int64_t* indices = reinterpret_cast<const std::int64_t*>(binaryOut.str().data());
+    for (std::size_t k = 0; k < ids.size(); ++k) {
+        int probes = 0;
+        EXPECT_EQ(indices[k], algo.interpolationSearch(ids[k], probes)) << "id " << ids[k];
+    }
+    EXPECT_EQ(stats.batches, 15u);
+    EXPECT_GE(stats.latencyMaxUs, stats.latencyP50Us);
+
+    EXPECT_THROW(QueryServer(nullptr), std::invalid_argument);
+}
+
+//each line is one sort job; jobs are never split across batches.
+TEST(QueryServerTest, SortsJobsPerLine) {
+    ServeOptions options;
+    options.mode = ServeMode::Sort;
+    options.batchSize = 3;
+    QueryServer server(nullptr, options);
+
+    std::istringstream text("5 3 9 1\n\n2 x 1\n7\n10 -4 99999999999 6\n");
+    std::ostringstream textOut;
+    ServeStats stats = server.run(text, textOut);
+    EXPECT_EQ(textOut.str(), "1 3 5 9\n1 2\n7\n-4 6 10\n");
+    EXPECT_EQ(stats.queries, 4u);
+    EXPECT_EQ(stats.values, 10u);
+    EXPECT_EQ(stats.malformed, 2u);
+
+    //binary jobs: count, then values; a truncated last job is dropped.
+    std::vector<std::int32_t> words = { 3, 30, -1, 20, 0, 2, 8, 4, 5, 1 };
+    std::string bytes(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(std::int32_t));
+    options.format = ServeFormat::Binary;
+    std::istringstream binary(bytes);
+    std::ostringstream binaryOut;
+    stats = QueryServer(nullptr, options).run(binary, binaryOut);
+    std::vector<std::int32_t> expected = { 3, -1, 20, 30, 0, 2, 4, 8 };
+    ASSERT_EQ(binaryOut.str().size(), expected.size() * sizeof(std::int32_t));
+    EXPECT_EQ(std::memcmp(binaryOut.str().data(), expected.data(), binaryOut.str().size()), 0);
+    EXPECT_EQ(stats.queries, 3u);
+    EXPECT_EQ(stats.malformed, 1u);
+}
+
+static std::string readWholeFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+//the generator wrappers keep the old file layout.
+TEST_F(AlgoTest, GeneratedStationFilesLoad) {
+    const std::string path = "algo_test_generated_stations.txt";
+    ASSERT_TRUE(algo.generateSequentialStations(path, 1000));
+    std::string text = readWholeFile(path);
+    EXPECT_EQ(text.substr(0, 20), "Station_1\nStation_2\n");
+    EXPECT_EQ(text.substr(text.size() - 13), "Station_1000\n");
+
+    ASSERT_TRUE(algo.generateHighlyNonUniformStations(path, 5000));
+    ASSERT_TRUE(algo.loadStations(path));
+    std::remove(path.c_str());
+    std::vector<Station> sorted = algo.getStationsSortedByName();
+    ASSERT_EQ(sorted.size(), 5000u);
+    int probes = 0;
+    int64_t target = algo.pickTargetFromStations();
+    EXPECT_GE(algo.interpolationSearch(target, probes), 0);
+}
+
+//the same options give the same stations whatever the threads, chunks or format.
+TEST(StationGeneratorTest, OutputIndependentOfThreadsAndFormat) {
+    const std::string textPath = "algo_test_generator.txt";
+    const std::string snapshotPath = "algo_test_generator.bin";
+    for (GapDistribution gaps : { GapDistribution::Uniform, GapDistribution::Bursty,
+                                  GapDistribution::Pareto, GapDistribution::Clustered }) {
+        StationGeneratorOptions options;
+        options.count = 100003;  //not a multiple of the 32-gap blocks
+        options.gaps = gaps;
+        options.seed = 42;
+        options.firstId = 7;
+        options.threads = 1;
+        options.chunkStations = 1 << 16;
+        StationGeneratorStats stats = StationGenerator::generate(textPath, options);
+        std::string reference = readWholeFile(textPath);
+        EXPECT_EQ(stats.stations, options.count);
+        EXPECT_EQ(stats.bytesWritten, reference.size());
+
+        options.threads = 3;
+        options.chunkStations = 1000;  //rounded up to 1024
+        StationGenerator::generate(textPath, options);
+        EXPECT_EQ(readWholeFile(textPath), reference);
+
+        options.format = StationFileFormat::Snapshot;
+        StationGeneratorStats snapshotStats = StationGenerator::generate(snapshotPath, options);
+        EXPECT_EQ(snapshotStats.lastId, stats.lastId);
+        std::vector<std::int64_t> ids = StationGenerator::readSnapshot(snapshotPath);
+        ASSERT_EQ(ids.size(), options.count);
+        EXPECT_EQ(ids.front(), 7);
+        EXPECT_EQ(ids.back(), stats.lastId);
+        EXPECT_TRUE(std::is_sorted(ids.begin(), ids.end()));
+        EXPECT_EQ(std::adjacent_find(ids.begin(), ids.end()), ids.end());
+
+        std::string text;
+        for (std::int64_t id : ids) text += "Station_" + std::to_string(id) + "\n";
+        EXPECT_EQ(text, reference);
+    }
+
+    Algo algo;
+    ASSERT_TRUE(algo.loadStationSnapshot(snapshotPath));
+    EXPECT_FALSE(algo.loadStationSnapshot(textPath));
+    EXPECT_EQ(algo.getStationsSortedByName().size(), 100003u);
+
+    //a cut-off snapshot is rejected, not read short.
+    std::string bytes = readWholeFile(snapshotPath);
+    std::ofstream(snapshotPath, std::ios::binary) << bytes.substr(0, bytes.size() - 4);
+    EXPECT_THROW(StationGenerator::readSnapshot(snapshotPath), std::runtime_error);
+    std::remove(textPath.c_str());
+    std::remove(snapshotPath.c_str());
+}
+
+//gaps stay inside the documented ranges at the extremes of the random word.
+TEST(StationGeneratorTest, GapRanges) {
+    StationGeneratorOptions options;
+    options.meanGap = 4;
+    EXPECT_EQ(StationGenerator::gap(options, 0, 0), 1u);
+    EXPECT_EQ(StationGenerator::gap(options, 0, 0xFFFFFFFFu), 7u);
+
+    options.gaps = GapDistribution::Bursty;
+    EXPECT_EQ(StationGenerator::gap(options, 0, 0), 1000u);
+    EXPECT_EQ(StationGenerator::gap(options, 0, 0xFFFFFFC0u), 20000u);
+    EXPECT_EQ(StationGenerator::gap(options, 0, 0xFFFFFFFFu), 4u);
+
+    options.gaps = GapDistribution::Pareto;
+    EXPECT_EQ(StationGenerator::gap(options, 0, 0xFFFFFFFFu), 1u);
+    EXPECT_GT(StationGenerator::gap(options, 0, 0), 1000000u);
+
+    options.gaps = GapDistribution::Clustered;
+    EXPECT_EQ(StationGenerator::gap(options, 10, 0xFFFFFFFFu), 20000u);
+    EXPECT_EQ(StationGenerator::gap(options, 3, 0), 50u);
+    EXPECT_EQ(StationGenerator::gap(options, 4, 0xFFFFFFFFu), 5u);
+
+    options.meanGap = 0;
+    EXPECT_THROW(StationGenerator::generate("unused.txt", options), std::invalid_argument);
+}
+
+//finger search answers exactly like interpolation search, whatever order the queries come in.
+TEST(FingerSearchTest, MatchesInterpolationSearch) {
+    const std::string path = "algo_test_finger.bin";
+    StationGeneratorOptions options;
+    options.count = 20000;
+    options.gaps = GapDistribution::Bursty;
+    options.format = StationFileFormat::Snapshot;
+    StationGenerator::generate(path, options);
+    std::vector<std::int64_t> ids = StationGenerator::readSnapshot(path);
+    Algo algo;
+    ASSERT_TRUE(algo.loadStationSnapshot(path));
+    std::remove(path.c_str());
+
+    std::vector<std::int64_t> queries = { ids.front() - 1, ids.back() + 1, ids.back(), ids.front() };
+    for (size_t k = 0; k < ids.size(); k += 7) {
+        queries.push_back(ids[k]);
+        queries.push_back(ids[k] + 1);  //mostly misses
+    }
+    std::mt19937 gen(3);
+    std::vector<std::int64_t> shuffled = queries;
+    std::shuffle(shuffled.begin(), shuffled.end(), gen);
+
+    for (const auto* stream : { &queries, &shuffled }) {
+        SearchCursor cursor;
+        for (std::int64_t id : *stream) {
+            int plainProbes = 0, fingerProbes = 0;
+            ASSERT_EQ(algo.fingerSearch(id, cursor, fingerProbes), algo.interpolationSearch(id, plainProbes)) << "id " << id;
+        }
+    }
+
+    //a walk along the table costs two probes per step: the cursor and its neighbour.
+    SearchCursor cursor;
+    int total = 0;
+    for (size_t k = 5000; k < 6000; ++k) {
+        int probes = 0;
+        ASSERT_EQ(algo.fingerSearch(ids[k], cursor, probes), static_cast<int>(k));
+        total += probes;
+    }
+    EXPECT_LE(total, 2100);
+
+    //a cursor left over from a bigger table is ignored, and an empty table finds nothing.
+    cursor.position = 1000000;
+    int probes = 0;
+    EXPECT_EQ(algo.fingerSearch(ids[42], cursor, probes), 42);
+    algo.clearStations();
+    EXPECT_EQ(algo.fingerSearch(ids[42], cursor, probes), -1);
+}
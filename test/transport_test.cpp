@@ -30,8 +30,17 @@
 
 #include <gtest/gtest.h>
 #include "../src/transport.hpp"
+#include "../src/counter_rng.hpp"
+#include "../src/memory_arena.hpp"
+#include "../src/instrumentation.hpp"
 #include <vector>
 #include <chrono>
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
 
 /**
  * @brief Test fixture for Singapore Transport Optimizer tests
@@ -79,30 +88,43 @@ TEST_F(SingaporeTransportTest, SmallNetworkTest) {
 /**
  * @brief Tests the recurrence relation T(n) = 4T(n/2) + n empirically
  *
- * Measures execution times for networks of sizes 2, 4, 8, and 16.
+ * Measures execution times for networks of sizes 8, 16, 32, and 64
+ * (averaged over many runs at nanosecond resolution). Smaller sizes are
+ * dominated by the fixed per-call cost, and instrumented builds add a span
+ * per call, so the ratios are only checked in plain builds.
  * Verifies that time complexity follows O(n) by checking that
  * execution time roughly quadruples when problem size doubles.
  */
 TEST_F(SingaporeTransportTest, RecurrenceRelationTest) {
-    std::vector<int> sizes = { 2, 4, 8, 16 };
+    std::vector<int> sizes = { 8, 16, 32, 64 };
     std::vector<long long> durations;
 
     for (int size : sizes) {
         SingaporeTransportOptimizer optimizer(size);
+        optimizer.setTileSize(1);  // time the full recursion, not the leaf kernel
         auto network = SingaporeTransportOptimizer::generateNetwork(size);
-        auto start = std::chrono::high_resolution_clock::now();
+        std::int64_t result = optimizer.optimizeTransport(network);  // warm-up, untimed
 
-        const int iterations = 10;
-        int result = 0;
-        for (int i = 0; i < iterations; ++i) {
-            result = optimizer.optimizeTransport(network);
+        // Enough iterations for the zero-copy recursion to register in ns;
+        // the best of three rounds drops interference from other processes.
+        const int iterations = 1000;
+        long long avg_duration = 0;
+        for (int round = 0; round < 3; ++round) {
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < iterations; ++i) {
+                result = optimizer.optimizeTransport(network);
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+            auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+            long long avg = std::max<long long>(1, duration.count() / iterations);
+            avg_duration = round == 0 ? avg : std::min(avg_duration, avg);
         }
-
-        auto end = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-        long long avg_duration = std::max(1LL, duration.count() / iterations);
         durations.push_back(avg_duration);
-        std::cout << "Size: " << size << ", Time: " << avg_duration << " microseconds, Result: " << result << std::endl;
+        std::cout << "Size: " << size << ", Time: " << avg_duration << " nanoseconds, Result: " << result << std::endl;
+    }
+
+    if (Instrumentation::kEnabled) {
+        GTEST_SKIP() << "Span recording distorts the timings of instrumented builds";
     }
 
     // Verify that time grows quadratically
@@ -131,9 +153,9 @@ TEST_F(SingaporeTransportTest, NetworkGenerationTest) {
     int size = 4;
     auto network = SingaporeTransportOptimizer::generateNetwork(size);
 
-    EXPECT_EQ(network.size(), size);
+    EXPECT_EQ(network.size(), static_cast<size_t>(size));
     for (const auto& row : network) {
-        EXPECT_EQ(row.size(), size);
+        EXPECT_EQ(row.size(), static_cast<size_t>(size));
         for (int val : row) {
             EXPECT_GE(val, 1);
             EXPECT_LE(val, 100);
@@ -185,6 +207,678 @@ TEST_F(SingaporeTransportTest, RegionDivisionTest) {
     EXPECT_EQ(sw[1][1], 16);  // row3,col3
 }
 
+/**
+ * @brief Tests that the flat matrix and view overloads match the nested API
+ *
+ * Runs the same random networks through the nested-vector, TransportMatrix
+ * and MatrixView entry points, and checks that quadrant views of a 4x4
+ * matrix point at the right storage without copying.
+ */
+TEST_F(SingaporeTransportTest, FlatMatrixViewTest) {
+    for (int size : { 1, 2, 4, 8, 16 }) {
+        SingaporeTransportOptimizer optimizer(size);
+        auto network = SingaporeTransportOptimizer::generateNetwork(size);
+        TransportMatrix matrix(network);
+
+        std::int64_t nested = optimizer.optimizeTransport(network);
+        EXPECT_EQ(optimizer.optimizeTransport(matrix), nested);
+        EXPECT_EQ(optimizer.optimizeTransport(matrix.view()), nested);
+        EXPECT_EQ(matrix.toNested(), network);
+    }
+
+    TransportMatrix matrix({ {1, 2, 3, 4}, {5, 6, 7, 8}, {9, 10, 11, 12}, {13, 14, 15, 16} });
+    MatrixView sw = matrix.view().block(2, 2, 2, 2);
+    EXPECT_EQ(sw.base, matrix.data());
+    EXPECT_EQ(sw.at(0, 0), 11);
+    EXPECT_EQ(sw.at(1, 1), 16);
+
+    // a view of a larger matrix gives the same answer as a copy of the block
+    SingaporeTransportOptimizer optimizer(2);
+    EXPECT_EQ(optimizer.optimizeTransport(sw), optimizer.optimizeTransport({ {11, 12}, {15, 16} }));
+
+    EXPECT_THROW(TransportMatrix({ {1, 2}, {3} }), std::invalid_argument);
+}
+
+/**
+ * @brief Tests that the parallel recursion matches the serial one
+ *
+ * Uses a small grain size so that several levels are split into tasks,
+ * and repeats the run to check the result is deterministic.
+ */
+TEST_F(SingaporeTransportTest, ParallelMatchesSerialTest) {
+    for (int size : { 1, 16, 64, 256 }) {
+        SingaporeTransportOptimizer optimizer(size);
+        TransportMatrix network(SingaporeTransportOptimizer::generateNetwork(size));
+        std::int64_t serial = optimizer.optimizeTransport(network);
+
+        for (unsigned threads : { 1u, 4u }) {
+            optimizer.setThreadCount(threads);
+            optimizer.setParallelGrain(4);
+            for (int run = 0; run < 3; ++run) {
+                EXPECT_EQ(optimizer.optimizeTransportParallel(network), serial)
+                    << "size " << size << ", threads " << threads;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Tests that the tiled leaf kernel matches the full recursion exactly
+ *
+ * Compares several tile sizes against tile size 1 (recursion down to single
+ * cells) on power-of-two and odd sizes, then checks a network whose score
+ * no longer fits in 32 bits against its closed form.
+ */
+TEST_F(SingaporeTransportTest, TiledKernelMatchesRecursionTest) {
+    for (int size : { 2, 3, 5, 8, 13, 32, 33, 64, 100, 128 }) {
+        SingaporeTransportOptimizer reference(size);
+        reference.setTileSize(1);
+        TransportMatrix network(SingaporeTransportOptimizer::generateNetwork(size));
+        std::int64_t expected = reference.optimizeTransport(network);
+
+        for (size_t tile : { 2, 4, 7, 32, 64, 256 }) {
+            SingaporeTransportOptimizer optimizer(size);
+            optimizer.setTileSize(tile);
+            EXPECT_EQ(optimizer.optimizeTransport(network), expected) << "size " << size << ", tile " << tile;
+        }
+    }
+
+    // Constant 100s at 4096^2: 100 * (2n^2 - n^2/n) = 3355033600 > INT_MAX
+    const size_t n = 4096;
+    TransportMatrix network(n, n, 100);
+    SingaporeTransportOptimizer optimizer(static_cast<int>(n));
+    EXPECT_EQ(optimizer.optimizeTransport(network), 3355033600LL);
+}
+
+/**
+ * @brief Tests networks whose dimensions are odd or unequal
+ *
+ * Checks hand-computed ceil/floor splits, that the last row and column of
+ * an odd network are no longer dropped, and that the tiled and parallel
+ * paths agree with the full recursion on rectangular shapes.
+ */
+TEST_F(SingaporeTransportTest, RectangularNetworkTest) {
+    SingaporeTransportOptimizer small(3);
+    // 2x3: regions [1 2] [3] [4 5] [6] sum to 21, plus diagonal 1 + 5
+    EXPECT_EQ(small.optimizeTransport({ {1, 2, 3}, {4, 5, 6} }), 27);
+    // 3x3: NE 2x2 gives 12 + 6, then 9 + 15 + 9, plus diagonal 1 + 5 + 9
+    EXPECT_EQ(small.optimizeTransport({ {1, 2, 3}, {4, 5, 6}, {7, 8, 9} }), 66);
+
+    TransportMatrix corner(5, 5, 0);
+    corner(4, 4) = 1;
+    EXPECT_GT(small.optimizeTransport(corner), 0);
+
+    std::mt19937 gen(37);
+    std::uniform_int_distribution<> dis(1, 100);
+    for (auto shape : { std::make_pair(1, 9), std::make_pair(9, 1), std::make_pair(7, 12),
+                        std::make_pair(100, 37), std::make_pair(333, 500) }) {
+        TransportMatrix network(shape.first, shape.second);
+        for (size_t i = 0; i < network.rows(); ++i) {
+            for (size_t j = 0; j < network.cols(); ++j) {
+                network(i, j) = dis(gen);
+            }
+        }
+
+        SingaporeTransportOptimizer reference(shape.first);
+        reference.setTileSize(1);
+        std::int64_t expected = reference.optimizeTransport(network);
+
+        SingaporeTransportOptimizer optimizer(shape.first);
+        EXPECT_EQ(optimizer.optimizeTransport(network), expected) << shape.first << "x" << shape.second;
+        optimizer.setThreadCount(2);
+        optimizer.setParallelGrain(8);
+        EXPECT_EQ(optimizer.optimizeTransportParallel(network), expected) << shape.first << "x" << shape.second;
+    }
+}
+
+/**
+ * @brief Tests the Z-order layout and its bottom-up evaluator
+ *
+ * Checks the round trip through MortonMatrix, that a quadrant is one
+ * contiguous block of storage, and that the stackless evaluator matches
+ * the row-major recursion for several tile sizes.
+ */
+TEST_F(SingaporeTransportTest, MortonLayoutTest) {
+    for (int size : { 1, 2, 4, 8, 64, 256 }) {
+        SingaporeTransportOptimizer optimizer(size);
+        TransportMatrix network(SingaporeTransportOptimizer::generateNetwork(size));
+        std::int64_t expected = optimizer.optimizeTransport(network);
+
+        for (size_t tile : { 1, 2, 6, 32, 512 }) {
+            MortonMatrix morton(network, tile);
+            EXPECT_LE(morton.tileSize(), tile);
+            EXPECT_EQ(morton.toRowMajor().toNested(), network.toNested());
+            EXPECT_EQ(optimizer.optimizeTransport(morton), expected) << "size " << size << ", tile " << tile;
+        }
+    }
+
+    // 8x8 in 2x2 tiles: the SE quadrant (rows 4-7, cols 0-3) is the third
+    // quarter of storage, and element (i, j) is still found by coordinates.
+    TransportMatrix network(8, 8);
+    for (size_t i = 0; i < 8; ++i) {
+        for (size_t j = 0; j < 8; ++j) {
+            network(i, j) = static_cast<int>(i * 8 + j);
+        }
+    }
+    MortonMatrix morton(network, 2);
+    for (size_t k = 32; k < 48; ++k) {
+        int value = morton.data()[k];
+        EXPECT_GE(value / 8, 4);
+        EXPECT_LT(value % 8, 4);
+    }
+    EXPECT_EQ(morton(5, 3), 43);
+
+    EXPECT_THROW(MortonMatrix(TransportMatrix(6, 6)), std::invalid_argument);
+    EXPECT_THROW(MortonMatrix(TransportMatrix(4, 8)), std::invalid_argument);
+}
+
+/**
+ * @brief Tests that incremental updates match a full re-optimization
+ *
+ * Applies single and batched random link updates (including repeated
+ * cells within a batch) and compares the cached score against a fresh
+ * optimizeTransport of the updated network after each step.
+ */
+TEST_F(SingaporeTransportTest, IncrementalUpdateTest) {
+    std::mt19937 gen(38);
+    for (auto shape : { std::make_pair(1, 1), std::make_pair(64, 64), std::make_pair(100, 77) }) {
+        TransportMatrix network(shape.first, shape.second);
+        for (size_t i = 0; i < network.rows(); ++i) {
+            for (size_t j = 0; j < network.cols(); ++j) {
+                network(i, j) = static_cast<int>(gen() % 100) + 1;
+            }
+        }
+
+        for (size_t tile : { 1, 8, 32 }) {
+            IncrementalTransportOptimizer incremental(network, tile);
+            SingaporeTransportOptimizer full(shape.first);
+            EXPECT_EQ(incremental.score(), full.optimizeTransport(network));
+
+            std::uniform_int_distribution<size_t> row(0, network.rows() - 1);
+            std::uniform_int_distribution<size_t> col(0, network.cols() - 1);
+            for (int step = 0; step < 20; ++step) {
+                incremental.updateEdge(row(gen), col(gen), static_cast<int>(gen() % 1000));
+                ASSERT_EQ(incremental.score(), full.optimizeTransport(incremental.network()));
+            }
+
+            std::vector<EdgeUpdate> batch;
+            for (int k = 0; k < 50; ++k) {
+                batch.push_back({ row(gen), col(gen), static_cast<int>(gen() % 1000) - 500 });
+            }
+            batch.push_back({ batch[0].row, batch[0].col, 7 });  // same cell twice: last write wins
+            incremental.updateEdges(batch);
+            EXPECT_EQ(incremental.network()(batch[0].row, batch[0].col), 7);
+            EXPECT_EQ(incremental.score(), full.optimizeTransport(incremental.network()));
+        }
+    }
+
+    IncrementalTransportOptimizer incremental(TransportMatrix(4, 4, 1));
+    std::int64_t before = incremental.score();
+    EXPECT_THROW(incremental.updateEdges({ { 0, 0, 9 }, { 4, 0, 9 } }), std::out_of_range);
+    EXPECT_EQ(incremental.score(), before);
+
+    // A copy keeps updating correctly after its source is gone.
+    IncrementalTransportOptimizer copy = [] {
+        IncrementalTransportOptimizer source(TransportMatrix(9, 9, 2), 4);
+        return IncrementalTransportOptimizer(source);
+    }();
+    copy.updateEdge(3, 5, 40);
+    SingaporeTransportOptimizer full(9);
+    EXPECT_EQ(copy.score(), full.optimizeTransport(copy.network()));
+}
+
+/**
+ * @brief Tests that the sparse path matches the dense one
+ *
+ * Compares random sparse networks (square and rectangular, odd and
+ * power-of-two) against their dense expansion, checks duplicate and zero
+ * handling, and evaluates single links in a 2^20 x 2^20 network whose
+ * weights are known in closed form.
+ */
+TEST_F(SingaporeTransportTest, SparseNetworkTest) {
+    SingaporeTransportOptimizer optimizer(0);
+    for (auto shape : { std::make_pair(1, 1), std::make_pair(64, 64), std::make_pair(100, 77), std::make_pair(333, 500) }) {
+        for (size_t links : { 0, 1, 50, 2000 }) {
+            std::mt19937 gen(static_cast<unsigned>(links));
+            std::vector<SparseLink> list;
+            for (size_t k = 0; k < links; ++k) {
+                list.push_back({ static_cast<std::uint32_t>(gen() % shape.first),
+                                 static_cast<std::uint32_t>(gen() % shape.second),
+                                 static_cast<int>(gen() % 201) - 100 });
+            }
+            SparseTransportMatrix sparse(shape.first, shape.second, list);
+            TransportMatrix dense = sparse.toDense();
+            EXPECT_EQ(optimizer.optimizeTransport(sparse), optimizer.optimizeTransport(dense))
+                << shape.first << "x" << shape.second << ", " << links << " links";
+            EXPECT_EQ(SparseTransportMatrix::fromDense(dense.view()).links().size(), sparse.nonZeros());
+        }
+    }
+
+    SparseTransportMatrix merged(4, 4, { { 1, 2, 5 }, { 1, 2, -5 }, { 0, 0, 3 }, { 0, 0, 4 } });
+    ASSERT_EQ(merged.nonZeros(), 1u);
+    EXPECT_EQ(merged.links()[0].weight, 7);
+
+    // (0, 0) lies on the diagonal of all 20 internal ancestors; the top-right
+    // corner lies on none of them.
+    const size_t n = size_t(1) << 20;
+    EXPECT_EQ(optimizer.optimizeTransport(SparseTransportMatrix(n, n, { { 0, 0, 5 } })), 5 * 21);
+    EXPECT_EQ(optimizer.optimizeTransport(SparseTransportMatrix(n, n, { { 0, n - 1, 5 } })), 5);
+
+    SparseTransportMatrix generated = SingaporeTransportOptimizer::generateSparseNetwork(1000000, 100000, 39);
+    EXPECT_GT(generated.nonZeros(), 99000u);
+    EXPECT_GT(optimizer.optimizeTransport(generated), 0);
+
+    EXPECT_THROW(SparseTransportMatrix(4, 4, { { 4, 0, 1 } }), std::out_of_range);
+}
+
+/**
+ * @brief Tests that streaming a tiled file matches the in-memory result
+ *
+ * Round-trips networks of several shapes and tile sizes through
+ * TiledNetworkFile, checks the generator writer and the I/O statistics,
+ * and rejects truncated or foreign files.
+ */
+TEST_F(SingaporeTransportTest, TiledFileStreamingTest) {
+    const std::string path = "transport_tiled_test.bin";
+    SingaporeTransportOptimizer optimizer(0);
+    std::mt19937 gen(40);
+
+    for (auto shape : { std::make_pair(0, 0), std::make_pair(1, 1), std::make_pair(64, 64), std::make_pair(100, 77) }) {
+        TransportMatrix network(shape.first, shape.second);
+        for (size_t i = 0; i < network.rows(); ++i) {
+            for (size_t j = 0; j < network.cols(); ++j) {
+                network(i, j) = static_cast<int>(gen() % 100) + 1;
+            }
+        }
+        std::int64_t expected = optimizer.optimizeTransport(network);
+
+        for (size_t tile : { 1, 8, 32 }) {
+            TiledNetworkFile::write(path, network.view(), tile);
+            TiledNetworkFile::Header header = TiledNetworkFile::readHeader(path);
+            EXPECT_EQ(header.rows, network.rows());
+            EXPECT_EQ(header.tileSize, tile);
+
+            TiledFileStats stats;
+            EXPECT_EQ(optimizer.optimizeTransportFile(path, &stats), expected)
+                << shape.first << "x" << shape.second << ", tile " << tile;
+            EXPECT_EQ(stats.bytesRead, 32 + network.rows() * network.cols() * sizeof(int));
+        }
+    }
+
+    // The generator overload writes the same bytes without a matrix in memory.
+    TransportMatrix network(50, 70);
+    for (size_t i = 0; i < 50; ++i) {
+        for (size_t j = 0; j < 70; ++j) {
+            network(i, j) = static_cast<int>(i * 70 + j);
+        }
+    }
+    TiledNetworkFile::write(path, 50, 70, 16, [](size_t i, size_t j) { return static_cast<int>(i * 70 + j); });
+    EXPECT_EQ(optimizer.optimizeTransportFile(path), optimizer.optimizeTransport(network));
+
+    {
+        std::FILE* file = std::fopen(path.c_str(), "r+b");
+        ASSERT_NE(file, nullptr);
+        std::fseek(file, 0, SEEK_SET);
+        std::fputc('X', file);
+        std::fclose(file);
+    }
+    EXPECT_THROW(optimizer.optimizeTransportFile(path), std::runtime_error);
+    EXPECT_THROW(optimizer.optimizeTransportFile("missing_tiled_network.bin"), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+/**
+ * @brief Tests the seeded counter-based network generator
+ *
+ * Checks Philox4x32-10 against the published known-answer vectors, that a
+ * seed gives the same matrix for every thread count, and the shape of each
+ * weight distribution.
+ */
+TEST_F(SingaporeTransportTest, SeededGeneratorTest) {
+    EXPECT_EQ(Philox4x32::generate({ 0, 0, 0, 0 }, { 0, 0 }),
+              (Philox4x32::Counter{ 0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u }));
+    EXPECT_EQ(Philox4x32::generate({ 0x243f6a88u, 0x85a308d3u, 0x13198a2eu, 0x03707344u }, { 0xa4093822u, 0x299f31d0u }),
+              (Philox4x32::Counter{ 0xd16cfe09u, 0x94fdccebu, 0x5001e420u, 0x24126ea1u }));
+
+    for (WeightDistribution distribution : { WeightDistribution::Uniform, WeightDistribution::Banded,
+                                             WeightDistribution::Sparse, WeightDistribution::Clustered }) {
+        NetworkSpec spec;
+        spec.rows = 203;
+        spec.cols = 150;
+        spec.seed = 41;
+        spec.distribution = distribution;
+        spec.density = 0.1;
+        TransportMatrix serial = SingaporeTransportOptimizer::generateNetwork(spec, 1);
+        EXPECT_EQ(SingaporeTransportOptimizer::generateNetwork(spec, 3).toNested(), serial.toNested());
+        EXPECT_EQ(SingaporeTransportOptimizer::generateNetwork(spec, 4).toNested(), serial.toNested());
+
+        size_t nonZero = 0;
+        for (size_t i = 0; i < spec.rows; ++i) {
+            for (size_t j = 0; j < spec.cols; ++j) {
+                int value = serial(i, j);
+                if (value == 0) continue;
+                ++nonZero;
+                EXPECT_GE(value, spec.minWeight);
+                EXPECT_LE(value, spec.maxWeight);
+                if (distribution == WeightDistribution::Banded) {
+                    EXPECT_LE(i > j ? i - j : j - i, spec.bandWidth);
+                }
+            }
+        }
+        double share = static_cast<double>(nonZero) / (spec.rows * spec.cols);
+        if (distribution == WeightDistribution::Uniform) {
+            EXPECT_EQ(share, 1.0);
+        }
+        if (distribution == WeightDistribution::Sparse) {
+            EXPECT_NEAR(share, 0.1, 0.02);
+        }
+        if (distribution == WeightDistribution::Clustered) {
+            EXPECT_NEAR(share, 0.25 + 0.75 * 0.1, 0.03);
+        }
+    }
+
+    NetworkSpec a;
+    a.rows = a.cols = 64;
+    a.seed = 1;
+    NetworkSpec b = a;
+    b.seed = 2;
+    EXPECT_NE(SingaporeTransportOptimizer::generateNetwork(a).toNested(),
+              SingaporeTransportOptimizer::generateNetwork(b).toNested());
+}
+
+/**
+ * @brief Tests the scaling harness behind analyzeComplexity
+ *
+ * Checks the per-size bookkeeping (allocation and copy counts are exact,
+ * timings are positive) and the CSV/JSON output rather than the timings
+ * themselves, which depend on the machine.
+ */
+TEST_F(SingaporeTransportTest, ScalingAnalysisTest) {
+    SingaporeTransportOptimizer optimizer(0);
+    ScalingOptions options;
+    options.sizes = { 16, 32, 64, 128, 256 };
+    options.warmup = 1;
+    options.repetitions = 3;
+    options.minSampleSeconds = 0.0002;
+    options.fitMinSize = 32;
+
+    ScalingReport report = optimizer.measureScaling(options);
+    ASSERT_EQ(report.samples.size(), options.sizes.size());
+    EXPECT_EQ(report.fittedPoints, 4u);
+    for (const ScalingSample& sample : report.samples) {
+        EXPECT_GT(sample.medianNs, 0.0);
+        EXPECT_LE(sample.minNs, sample.medianNs);
+        EXPECT_GE(sample.runsPerSample, 1u);
+        EXPECT_EQ(sample.allocationsPerRun, 0.0) << "matrix path allocated at size " << sample.size;
+        EXPECT_EQ(sample.bytesCopiedPerRun, 0.0);
+    }
+    EXPECT_LE(report.exponentLow, report.exponent);
+    EXPECT_GE(report.exponentHigh, report.exponent);
+    EXPECT_GT(report.exponent, 0.5);
+
+    // The nested entry point copies the network into flat storage once per run.
+    options.sizes = { 64 };
+    options.nestedInput = true;
+    ScalingReport nested = optimizer.measureScaling(options);
+    EXPECT_EQ(nested.samples[0].bytesCopiedPerRun, 64.0 * 64 * sizeof(int));
+    EXPECT_GE(nested.samples[0].allocationsPerRun, 1.0);
+
+    std::stringstream csv, json;
+    report.writeCsv(csv);
+    report.writeJson(json);
+    EXPECT_EQ(std::count(std::istreambuf_iterator<char>(csv), std::istreambuf_iterator<char>(), '\n'), 6);
+    EXPECT_NE(json.str().find("\"exponent\""), std::string::npos);
+    EXPECT_NE(json.str().find("\"size\": 256"), std::string::npos);
+}
+
+/**
+ * @brief Tests all-pairs shortest paths against a plain Floyd-Warshall
+ *
+ * Covers odd sizes that split unevenly, the 64-bit fallback for long
+ * links, unreachable pairs, parallel determinism, and that every route
+ * is made of real links adding up to the reported distance.
+ */
+TEST_F(SingaporeTransportTest, ShortestPathsTest) {
+    auto referenceDistances = [](const TransportMatrix& network) {
+        const std::int64_t inf = ShortestPaths::kUnreachable;
+        size_t n = network.rows();
+        std::vector<std::int64_t> d(n * n, inf);
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                if (i == j) d[i * n + j] = 0;
+                else if (network(i, j) > 0) d[i * n + j] = network(i, j);
+            }
+        }
+        for (size_t k = 0; k < n; ++k)
+            for (size_t i = 0; i < n; ++i)
+                for (size_t j = 0; j < n; ++j)
+                    if (d[i * n + k] != inf && d[k * n + j] != inf)
+                        d[i * n + j] = std::min(d[i * n + j], d[i * n + k] + d[k * n + j]);
+        return d;
+    };
+    auto expectValidRoutes = [](const TransportMatrix& network, const ShortestPaths& paths) {
+        for (size_t i = 0; i < network.rows(); ++i) {
+            for (size_t j = 0; j < network.rows(); ++j) {
+                std::vector<size_t> route = paths.route(i, j);
+                if (!paths.reachable(i, j)) {
+                    EXPECT_TRUE(route.empty());
+                    continue;
+                }
+                ASSERT_FALSE(route.empty());
+                ASSERT_EQ(route.front(), i);
+                ASSERT_EQ(route.back(), j);
+                std::int64_t length = 0;
+                for (size_t h = 1; h < route.size(); ++h) {
+                    ASSERT_GT(network(route[h - 1], route[h]), 0) << "route uses a missing link";
+                    length += network(route[h - 1], route[h]);
+                }
+                EXPECT_EQ(length, paths.distance(i, j));
+            }
+        }
+    };
+
+    SingaporeTransportOptimizer optimizer(0);
+    optimizer.setTileSize(8);
+    optimizer.setParallelGrain(16);
+    optimizer.setThreadCount(4);
+    for (size_t n : { 1, 2, 9, 37, 100 }) {
+        for (int maxWeight : { 100, 2000000000 }) {
+            std::mt19937 gen(static_cast<unsigned>(n));
+            TransportMatrix network(n, n);
+            for (size_t i = 0; i < n; ++i)
+                for (size_t j = 0; j < n; ++j)
+                    network(i, j) = gen() % 8 == 0 ? 1 + static_cast<int>(gen() % maxWeight) : 0;
+
+            ShortestPaths paths = optimizer.shortestPaths(network);
+            ASSERT_EQ(paths.nodeCount(), n);
+            EXPECT_EQ(paths.distances(), referenceDistances(network)) << n << " nodes, weights up to " << maxWeight;
+            expectValidRoutes(network, paths);
+
+            ShortestPaths parallel = optimizer.shortestPathsParallel(network);
+            EXPECT_EQ(parallel.distances(), paths.distances());
+            for (size_t i = 0; i < n; ++i)
+                for (size_t j = 0; j < n; ++j)
+                    ASSERT_EQ(parallel.nextHop(i, j), paths.nextHop(i, j));
+        }
+    }
+
+    // 0 -> 1 -> 2 is cheaper than the direct 0 -> 2; nothing leaves node 3.
+    TransportMatrix line(std::vector<std::vector<int>>{ { 0, 2, 9, 0 }, { 0, 0, 3, 0 }, { 0, 0, 0, 1 }, { 0, 0, 0, 0 } });
+    ShortestPaths paths = optimizer.shortestPaths(line);
+    EXPECT_EQ(paths.distance(0, 2), 5);
+    EXPECT_EQ(paths.distance(0, 3), 6);
+    EXPECT_EQ(paths.nextHop(0, 3), 1u);
+    EXPECT_EQ(paths.route(0, 3), (std::vector<size_t>{ 0, 1, 2, 3 }));
+    EXPECT_EQ(paths.route(2, 2), (std::vector<size_t>{ 2 }));
+    EXPECT_EQ(paths.distance(3, 0), ShortestPaths::kUnreachable);
+    EXPECT_EQ(paths.nextHop(3, 0), ShortestPaths::kNoRoute);
+
+    EXPECT_THROW(paths.distance(0, 4), std::out_of_range);
+    EXPECT_THROW(optimizer.shortestPaths(TransportMatrix(2, 3)), std::invalid_argument);
+    EXPECT_THROW(optimizer.shortestPaths(TransportMatrix(2, 2, -1)), std::invalid_argument);
+}
+
+/**
+ * @brief Tests that batch evaluation matches per-network optimization
+ *
+ * Both layouts, several shapes (including single rows and odd splits)
+ * and batch sizes, plus snapshot round-trips and shape checks.
+ */
+TEST_F(SingaporeTransportTest, BatchEvaluationTest) {
+    SingaporeTransportOptimizer optimizer(0);
+    for (auto shape : { std::make_pair(1, 1), std::make_pair(1, 90), std::make_pair(5, 7), std::make_pair(64, 64), std::make_pair(100, 77) }) {
+        for (size_t count : { 1, 3, 17 }) {
+            std::vector<TransportMatrix> networks;
+            for (size_t k = 0; k < count; ++k) {
+                NetworkSpec spec;
+                spec.rows = shape.first;
+                spec.cols = shape.second;
+                spec.seed = k;
+                spec.minWeight = -1000;
+                spec.maxWeight = 1000;
+                networks.push_back(SingaporeTransportOptimizer::generateNetwork(spec, 1));
+            }
+            for (BatchLayout layout : { BatchLayout::Planar, BatchLayout::Interleaved }) {
+                NetworkBatch batch = NetworkBatch::fromNetworks(networks, layout);
+                std::vector<std::int64_t> scores = optimizer.optimizeTransportBatch(batch);
+                ASSERT_EQ(scores.size(), count);
+                for (size_t k = 0; k < count; ++k) {
+                    EXPECT_EQ(scores[k], optimizer.optimizeTransport(networks[k]))
+                        << shape.first << "x" << shape.second << ", snapshot " << k;
+                }
+                TransportMatrix last = batch.snapshot(count - 1);
+                EXPECT_TRUE(std::equal(last.data(), last.data() + last.rows() * last.cols(), networks.back().data()));
+            }
+        }
+    }
+
+    NetworkBatch batch(2, 3, 3);
+    batch(1, 2, 2) = 4;
+    EXPECT_EQ(optimizer.optimizeTransportBatch(batch), (std::vector<std::int64_t>{ 0, 8 }));
+    EXPECT_TRUE(optimizer.optimizeTransportBatch(NetworkBatch()).empty());
+    EXPECT_THROW(batch.setSnapshot(2, TransportMatrix(3, 3).view()), std::out_of_range);
+    EXPECT_THROW(batch.setSnapshot(0, TransportMatrix(3, 4).view()), std::invalid_argument);
+    EXPECT_THROW(NetworkBatch::fromNetworks({ TransportMatrix(2, 2), TransportMatrix(2, 3) }), std::invalid_argument);
+}
+
+/**
+ * @brief Tests that memoized scores match the plain optimizer
+ *
+ * Full evaluations and edited scenarios on random networks, a network of
+ * repeated tiles (which must hit the cache), a cache small enough to
+ * evict, and misuse.
+ */
+TEST_F(SingaporeTransportTest, MemoizedTransportTest) {
+    SingaporeTransportOptimizer optimizer(0);
+    std::mt19937 gen(45);
+    for (auto shape : { std::make_pair(1, 1), std::make_pair(1, 90), std::make_pair(64, 64), std::make_pair(100, 77) }) {
+        NetworkSpec spec;
+        spec.rows = shape.first;
+        spec.cols = shape.second;
+        spec.seed = 45;
+        spec.minWeight = -1000;
+        spec.maxWeight = 1000;
+        TransportMatrix network = SingaporeTransportOptimizer::generateNetwork(spec, 1);
+
+        for (size_t tile : { 1, 8, 32 }) {
+            for (size_t capacity : { 3, 65536 }) {
+                MemoizedTransportOptimizer memo(capacity, tile);
+                EXPECT_EQ(memo.optimizeTransport(network), optimizer.optimizeTransport(network));
+                EXPECT_EQ(memo.optimizeTransport(network), optimizer.optimizeTransport(network));
+                EXPECT_LE(memo.cachedRegions(), capacity);
+
+                std::uniform_int_distribution<size_t> row(0, network.rows() - 1);
+                std::uniform_int_distribution<size_t> col(0, network.cols() - 1);
+                for (size_t edits : { 1, 5, 40 }) {
+                    std::vector<EdgeUpdate> scenario;
+                    TransportMatrix edited = network;
+                    for (size_t k = 0; k < edits; ++k) {
+                        EdgeUpdate edit = { row(gen), col(gen), static_cast<int>(gen() % 2001) - 1000 };
+                        scenario.push_back(edit);
+                        edited(edit.row, edit.col) = edit.weight;
+                    }
+                    scenario.push_back({ scenario[0].row, scenario[0].col, 7 });  // last write wins
+                    edited(scenario[0].row, scenario[0].col) = 7;
+                    ASSERT_EQ(memo.optimizeScenario(scenario), optimizer.optimizeTransport(edited))
+                        << shape.first << "x" << shape.second << ", tile " << tile << ", " << edits << " edits";
+                }
+                // Scenarios leave the base alone.
+                EXPECT_EQ(memo.optimizeScenario({}), optimizer.optimizeTransport(network));
+                if (capacity == 3 && network.rows() > tile) {
+                    EXPECT_GT(memo.stats().evictions, 0u);
+                }
+            }
+        }
+    }
+
+    // Sixteen copies of one 32 x 32 tile: one leaf evaluation serves them all.
+    TransportMatrix tiled(128, 128);
+    for (size_t i = 0; i < 128; ++i) {
+        for (size_t j = 0; j < 128; ++j) {
+            tiled(i, j) = static_cast<int>((i % 32) * 31 + (j % 32));
+        }
+    }
+    MemoizedTransportOptimizer memo;
+    EXPECT_EQ(memo.optimizeTransport(tiled), optimizer.optimizeTransport(tiled));
+    EXPECT_GT(memo.stats().hits, 0u);
+    memo.resetStats();
+    EXPECT_EQ(memo.optimizeTransport(tiled), optimizer.optimizeTransport(tiled));
+    EXPECT_EQ(memo.stats().hits, 1u);
+    EXPECT_EQ(memo.stats().misses, 0u);
+    memo.clear();
+    EXPECT_EQ(memo.cachedRegions(), 0u);
+
+    // A wider network grows the column keys; the narrow leaf must still hit.
+    TransportMatrix narrow(8, 8, 3), wide(8, 32, 3);
+    MemoizedTransportOptimizer growing;
+    growing.optimizeTransport(narrow);
+    growing.optimizeTransport(wide);
+    growing.resetStats();
+    EXPECT_EQ(growing.optimizeTransport(narrow), optimizer.optimizeTransport(narrow));
+    EXPECT_EQ(growing.stats().hits, 1u);
+    EXPECT_EQ(growing.stats().misses, 0u);
+
+    MemoizedTransportOptimizer fresh;
+    EXPECT_THROW(fresh.optimizeScenario({}), std::logic_error);
+    fresh.optimizeTransport(TransportMatrix(4, 4, 1));
+    EXPECT_THROW(fresh.optimizeScenario({ { 0, 4, 9 } }), std::out_of_range);
+    EXPECT_EQ(fresh.optimizeTransport(TransportMatrix()), 0);
+}
+
+/**
+ * @brief Tests that per-call scratch can come from an arena
+ *
+ * Every entry point that allocates scratch gives the same score with an
+ * ArenaResource as with the heap, and draws from the arena.
+ */
+TEST_F(SingaporeTransportTest, MemoryResourceTest) {
+    NetworkSpec spec;
+    spec.rows = 100;
+    spec.cols = 77;
+    spec.seed = 46;
+    TransportMatrix network = SingaporeTransportOptimizer::generateNetwork(spec, 1);
+    std::vector<std::vector<int>> nested = network.toNested();
+    SparseTransportMatrix sparse = SingaporeTransportOptimizer::generateSparseNetwork(1000, 500, 46);
+    NetworkBatch batch = NetworkBatch::fromNetworks({ network, network });
+
+    SingaporeTransportOptimizer heap(0);
+    ArenaResource arena;
+    SingaporeTransportOptimizer pooled(0, &arena);
+    EXPECT_EQ(pooled.memoryResource(), &arena);
+
+    EXPECT_EQ(pooled.optimizeTransport(nested), heap.optimizeTransport(network));
+    EXPECT_GE(arena.bytesUsed(), 100 * 77 * sizeof(int));
+    EXPECT_EQ(pooled.optimizeTransport(sparse), heap.optimizeTransport(sparse));
+    EXPECT_EQ(pooled.optimizeTransportBatch(batch), heap.optimizeTransportBatch(batch));
+    std::size_t used = arena.allocationCount();
+    arena.release();
+    EXPECT_GE(used, 3u);
+
+    EXPECT_THROW(pooled.optimizeTransport(std::vector<std::vector<int>>{ { 1, 2 }, { 3 } }), std::invalid_argument);
+    pooled.setMemoryResource(std::pmr::get_default_resource());
+    EXPECT_EQ(pooled.optimizeTransport(nested), heap.optimizeTransport(network));
+}
+
 /**
  * @brief Main function to run all Google Tests
  *